@@ -0,0 +1,32 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "SharedMemory.h"
+
+// Minimal headless benchmark harness: runs a body repeatedly and reports time per iteration
+
+// Keeps results alive so the optimizer cannot drop the measured work
+extern volatile unsigned long long benchSink;
+
+// Run 'body' for 'iterations' rounds after a short warm-up and print nanoseconds per round
+template <typename Body>
+double runBenchmark(const char* name, int iterations, Body body) {
+    for (int i = 0; i < iterations / 10 + 1; ++i) body(i);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) body(i);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double nanoseconds = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    printf("%-32s %12.1f ns/op  (%d iterations)\n", name, nanoseconds, iterations);
+    return nanoseconds;
+}
+
+// Fill a snapshot with a full 64-car race field at the given race time
+void fillSyntheticSnapshot(SharedMemory* sharedData, double raceTime);
+
+// Move car 0 to where it is at the given race time and fill the player-car input block
+void fillSyntheticPlayerInputs(SharedMemory* sharedData, double raceTime);
+
+#endif // BENCH_H
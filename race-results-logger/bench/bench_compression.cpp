@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include "bench.h"
+#include "compression.h"
+
+// Read every .json result file under a folder, sorted by name so the split is reproducible
+static void collectSamples(const std::string& folder, std::vector<std::string>& samples) {
+    namespace fs = std::filesystem;
+    if (!fs::is_directory(folder)) return;
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::recursive_directory_iterator(folder)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".json") files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+    for (const auto& file : files) {
+        std::ifstream in(file, std::ios::binary);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        if (isResultDocument(buffer.str())) samples.push_back(buffer.str());
+    }
+}
+
+// Ratio and per-document throughput of one codec over the test set
+template <typename Compress, typename Decompress>
+static void measureCodec(const char* name, const std::vector<std::string>& tests, Compress compress, Decompress decompress) {
+    size_t inputBytes = 0;
+    size_t outputBytes = 0;
+    std::vector<std::string> compressed(tests.size());
+    for (size_t i = 0; i < tests.size(); ++i) {
+        std::string restored;
+        if (!compress(tests[i], compressed[i]) || !decompress(compressed[i], restored) || restored != tests[i]) {
+            printf("%s: round trip failed on sample %zu\n", name, i);
+            return;
+        }
+        inputBytes += tests[i].size();
+        outputBytes += compressed[i].size();
+    }
+
+    const int rounds = 200;
+    const int count = static_cast<int>(tests.size());
+    std::string label = std::string(name) + " encode";
+    double encodeNs = runBenchmark(label.c_str(), rounds * count, [&](int i) {
+        std::string out;
+        compress(tests[i % count], out);
+        benchSink += out.size();
+    });
+    label = std::string(name) + " decode";
+    double decodeNs = runBenchmark(label.c_str(), rounds * count, [&](int i) {
+        std::string out;
+        decompress(compressed[i % count], out);
+        benchSink += out.size();
+    });
+
+    const double averageBytes = static_cast<double>(inputBytes) / count;
+    printf("%-32s %zu -> %zu bytes, ratio %.2f, encode %.1f MB/s, decode %.1f MB/s\n\n", name, inputBytes, outputBytes,
+           static_cast<double>(inputBytes) / outputBytes, averageBytes / encodeNs * 1000.0, averageBytes / decodeNs * 1000.0);
+}
+
+// Dictionary deflate against plain gzip on real result files: bench_compression <folder>...
+// Files are split alternately into a training half (for the dictionary) and a test half (measured).
+int main(int argc, char** argv) {
+    std::vector<std::string> samples;
+    for (int i = 1; i < argc; ++i) collectSamples(argv[i], samples);
+    if (samples.size() < 2) {
+        printf("Usage: bench_compression <folder with result .json files>...\n");
+        return 1;
+    }
+
+    std::vector<std::string> training;
+    std::vector<std::string> tests;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        (i % 2 == 0 ? training : tests).push_back(samples[i]);
+    }
+
+    printf("Samples: %zu training, %zu test\n\n", training.size(), tests.size());
+    measureCodec("gzip -9", tests, gzipCompress, gzipDecompress);
+
+    // Budgets past what the training set fills give the same dictionary and are skipped
+    const size_t sizes[] = {2048, 4096, 32768};
+    size_t lastSize = 0;
+    for (size_t size : sizes) {
+        CompressionDictionary dictionary = trainDictionary(training, size);
+        if (dictionary.data.size() == lastSize) continue;
+        lastSize = dictionary.data.size();
+        std::string name = "deflate-dict " + std::to_string(dictionary.data.size()) + " B";
+        measureCodec(name.c_str(), tests,
+            [&](const std::string& in, std::string& out) { return compressWithDictionary(in, dictionary, out); },
+            [&](const std::string& in, std::string& out) { return decompressWithDictionary(in, dictionary, out); });
+    }
+    return 0;
+}
@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench.h"
+#include "config.h"
+#include "logger_threads.h"
+
+// Interference benchmark: how much the logger slows down a CPU-bound "game" running next to it.
+// The game is one busy worker per CPU plus a thread writing a 64-car snapshot at the game's frame
+// rate with the $pcars2$ sequence protocol. The logger side runs the logger's own thread loops
+// from logger_threads over it (sampler, analytics with the per-frame field update, the black box
+// when enabled and the field copy of each 500 ms detection pass) with the settings given. The
+// game's throughput is measured alone, with the logger, and alone again, and the slowdown is
+// checked against a budget. A run whose two baselines differ by more than the budget cannot
+// tell the logger from the drift and is reported as inconclusive.
+
+// Particles each game worker integrates per step; 64 KB of state, so it lives in the worker's L2
+enum
+{
+  GAME_PARTICLES = 4096
+};
+
+// Benchmark settings from the command line
+struct InterferenceOptions {
+    double seconds;                                   // per phase
+    int gameThreads;
+    int fps;
+    double budget;                                    // [ UNITS = percent ] of game throughput the logger may cost
+    ServerConfig config;                              // scheduling, black box and derived state settings of the logger
+};
+
+// The game: workers, the snapshot writer and the shared snapshot they stand in for
+struct GameWorkload {
+    std::atomic<bool> running;
+    std::atomic<unsigned long long> steps;
+    SharedMemory* shared;                             // what the game publishes, read by the sampler
+};
+
+// One game worker: a fixed amount of floating point work per step, counted until stopped
+static void runGameWorker(GameWorkload* game) {
+    std::vector<float> position(GAME_PARTICLES), velocity(GAME_PARTICLES);
+    for (int p = 0; p < GAME_PARTICLES; ++p) {
+        position[p] = static_cast<float>(p % 97) * 0.01f;
+        velocity[p] = 0.0f;
+    }
+    unsigned long long steps = 0;
+    while (game->running.load(std::memory_order_relaxed)) {
+        for (int p = 0; p < GAME_PARTICLES; ++p) {
+            velocity[p] -= position[p] * 0.001f;
+            position[p] += velocity[p] * 0.001f;
+        }
+        ++steps;
+    }
+    benchSink += static_cast<unsigned long long>(position[0] * 1000.0f);
+    game->steps += steps;
+}
+
+// The game's shared memory writer: a new frame every 1/fps seconds, sequence number odd while writing
+static void runGameWriter(GameWorkload* game, int fps) {
+    SharedMemory* staging = new SharedMemory;
+    memcpy(staging, game->shared, sizeof(SharedMemory));
+    const auto start = std::chrono::steady_clock::now();
+    for (long frame = 0; game->running.load(std::memory_order_relaxed); ++frame) {
+        const double raceTime = 600.0 + static_cast<double>(frame) / fps;
+        fillSyntheticSnapshot(staging, raceTime);
+        fillSyntheticPlayerInputs(staging, raceTime);
+        staging->mGameState = GAME_INGAME_PLAYING;
+        const unsigned int sequence = game->shared->mSequenceNumber;
+        game->shared->mSequenceNumber = sequence + 1;
+        staging->mSequenceNumber = sequence + 1;
+        memcpy(game->shared, staging, sizeof(SharedMemory));
+        game->shared->mSequenceNumber = sequence + 2;
+        std::this_thread::sleep_until(start + std::chrono::microseconds((frame + 1) * 1000000LL / fps));
+    }
+    delete staging;
+}
+
+// The logger's detection thread without the race detection and logging around it: the field copy every 500 ms
+static void runDetection(SnapshotExchange* exchange, int consumer, FrameAnalytics* analytics, std::chrono::steady_clock::time_point clockStart, ThreadSchedule schedule) {
+    enterThreadSchedule(schedule);
+    FieldView* field = new FieldView;
+    DerivedField* derivedField = new DerivedField;
+    if (analytics->derivedState != NULL) *derivedField = analytics->derivedState->field;
+    double lastDetection = -DETECTION_INTERVAL_SECONDS;
+    while (!exchange->stopped) {
+        double now = 0.0;
+        const SharedMemory* snapshot = acquireDetectionSnapshot(*exchange, consumer, schedule, clockStart, lastDetection, &now);
+        if (snapshot == NULL) continue;
+        lastDetection = now;
+        readFieldView(*analytics, *field, *derivedField, snapshot, now);
+        releaseSnapshot(*exchange, consumer);
+    }
+    delete field;
+    delete derivedField;
+}
+
+// Run the game for one phase, with or without the logger; returns game steps per second
+static double runPhase(const InterferenceOptions& options, bool withLogger, std::string& report) {
+    GameWorkload game;
+    game.running = true;
+    game.steps = 0;
+    game.shared = new SharedMemory;
+    memset(game.shared, 0, sizeof(SharedMemory));
+    fillSyntheticSnapshot(game.shared, 600.0);
+
+    std::vector<std::thread> gameThreads;
+    gameThreads.emplace_back(runGameWriter, &game, options.fps);
+
+    // The logger's state, set up as race_logger does but with the derived segment in private memory
+    const ServerConfig& config = options.config;
+    const auto clockStart = std::chrono::steady_clock::now();
+    SnapshotExchange exchange;
+    SchedulingStats stats;
+    FrameAnalytics analytics;
+    DerivedState* derivedState = NULL;
+    BlackBox* blackBox = NULL;
+    std::vector<std::thread> loggerThreads;
+    if (withLogger) {
+        createSnapshotExchange(exchange);
+        resetSchedulingStats(stats, 0.0, processCpuSeconds());
+        analytics.drivingStats = new DrivingStats;
+        resetDrivingStats(*analytics.drivingStats);
+        analytics.telemetry = new TelemetryPyramid;
+        createTelemetryPyramid(*analytics.telemetry);
+        analytics.lapDelta = new LapDelta;
+        analytics.lapDelta->trackLength = -1.0f;
+        analytics.referenceFile = {NULL, NULL, NULL, 0};
+        analytics.keepReferenceLaps = false;
+        analytics.derivedState = NULL;
+        analytics.derivedViewed = new DerivedViewedCar;
+        if (config.derivedState) {
+            derivedState = new DerivedState;
+            initDerivedState(derivedState);
+            analytics.derivedState = derivedState;
+            *analytics.derivedViewed = derivedState->viewed;
+        }
+        analytics.participants = new ParticipantTable;
+        resetParticipantTable(*analytics.participants);
+        analytics.identities = new IdentityMap;
+        resetIdentityMap(*analytics.identities);
+        analytics.gaps = new GapTracker;
+        resetGapTracker(*analytics.gaps);
+        analytics.fieldTime = -1.0;
+
+        const ThreadSchedule sampler = {"sampler", config.samplerPriority, config.samplerCpus, &stats, addSchedulingThread(stats, "sampler")};
+        const ThreadSchedule analyticsSchedule = {"analytics", config.backgroundPriority, config.backgroundCpus, &stats, addSchedulingThread(stats, "analytics")};
+        const ThreadSchedule detection = {"detection", config.backgroundPriority, config.backgroundCpus, &stats, addSchedulingThread(stats, "detection")};
+        const int analyticsConsumer = addSnapshotConsumer(exchange, "analytics");
+        const int detectionConsumer = addSnapshotConsumer(exchange, "detection");
+        SamplerPacing pacing;
+        resetSamplerPacing(pacing, SAMPLER_POLL_MS, static_cast<unsigned int>(config.idlePollMs), config.gameScheduling, 0.0);
+        loggerThreads.emplace_back(runSampler, game.shared, &exchange, clockStart, sampler, pacing, static_cast<unsigned int>(config.timerResolutionMs));
+        loggerThreads.emplace_back(runAnalytics, &exchange, analyticsConsumer, &analytics, analyticsSchedule);
+        loggerThreads.emplace_back(runDetection, &exchange, detectionConsumer, &analytics, clockStart, detection);
+        if (config.blackBoxMinutes > 0) {
+            blackBox = new BlackBox;
+            createBlackBox(*blackBox, config.blackBoxMemoryMB, config.blackBoxMinutes, config.blackBoxCollision);
+            const ThreadSchedule blackBoxSchedule = {"blackbox", config.backgroundPriority, config.backgroundCpus, &stats, addSchedulingThread(stats, "blackbox")};
+            loggerThreads.emplace_back(runBlackBox, &exchange, addSnapshotConsumer(exchange, "blackbox"), blackBox, clockStart, blackBoxSchedule);
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < options.gameThreads; ++t) gameThreads.emplace_back(runGameWorker, &game);
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    game.running = false;
+    for (std::thread& thread : gameThreads) thread.join();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (withLogger) {
+        report = formatSchedulingReport(stats, secondsSince(clockStart), processCpuSeconds());
+        stopSnapshotExchange(exchange);
+        for (std::thread& thread : loggerThreads) thread.join();
+        report += "; " + std::to_string(exchange.published) + " frames sampled, " + std::to_string(exchange.torn) + " torn";
+        destroySnapshotExchange(exchange);
+        delete analytics.drivingStats;
+        destroyTelemetryPyramid(*analytics.telemetry);
+        delete analytics.telemetry;
+        delete analytics.lapDelta;
+        delete analytics.derivedViewed;
+        delete analytics.participants;
+        delete analytics.identities;
+        delete analytics.gaps;
+        delete derivedState;
+        if (blackBox != NULL) {
+            destroyBlackBox(*blackBox);
+            delete blackBox;
+        }
+    }
+    delete game.shared;
+    return game.steps / elapsed;
+}
+
+// ams2interference [-seconds N] [-threads N] [-fps N] [-budget percent] [-scheduling game|normal]
+//                  [-samplerPriority level] [-backgroundPriority level] [-samplerCpus list] [-backgroundCpus list]
+//                  [-blackBoxMinutes N]
+// Exits 0 within budget, 1 over budget, 2 on bad options and 3 when the baseline drifted too far to tell
+int main(int argc, char** argv) {
+    InterferenceOptions options;
+    options.seconds = 10.0;
+    options.gameThreads = static_cast<int>(std::thread::hardware_concurrency());
+    if (options.gameThreads < 1) options.gameThreads = 1;
+    options.fps = 60;
+    options.budget = 2.0;
+    for (int arg = 1; arg + 1 < argc; arg += 2) {
+        const std::string option = argv[arg];
+        const std::string value = argv[arg + 1];
+        bool valid = true;
+        if (option == "-seconds") {
+            options.seconds = atof(value.c_str());
+        } else if (option == "-threads") {
+            options.gameThreads = atoi(value.c_str());
+        } else if (option == "-fps") {
+            options.fps = atoi(value.c_str());
+        } else if (option == "-budget") {
+            options.budget = atof(value.c_str());
+        } else if (option == "-scheduling") {
+            options.config.gameScheduling = value == "game";
+        } else if (option == "-samplerPriority") {
+            options.config.samplerPriority = parseSchedulingPriority(value);
+            valid = options.config.samplerPriority >= 0;
+        } else if (option == "-backgroundPriority") {
+            options.config.backgroundPriority = parseSchedulingPriority(value);
+            valid = options.config.backgroundPriority >= 0;
+        } else if (option == "-samplerCpus") {
+            valid = parseCpuList(value, options.config.samplerCpus);
+        } else if (option == "-backgroundCpus") {
+            valid = parseCpuList(value, options.config.backgroundCpus);
+        } else if (option == "-blackBoxMinutes") {
+            options.config.blackBoxMinutes = atoi(value.c_str());
+            valid = options.config.blackBoxMinutes >= 0;
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            printf("Bad option %s %s\n", option.c_str(), value.c_str());
+            return 2;
+        }
+    }
+    if (options.seconds <= 0.0 || options.gameThreads < 1 || options.fps < 1) {
+        printf("Usage: ams2interference [-seconds N] [-threads N] [-fps N] [-budget percent] [-scheduling game|normal] ...\n");
+        return 2;
+    }
+    resolveScheduling(options.config);
+    const ServerConfig& config = options.config;
+    printf("Game: %d workers + %d fps writer, %.0f s per phase; logger: scheduling %s, sampler %s on %s, background %s on %s, black box %s\n\n",
+           options.gameThreads, options.fps, options.seconds, config.gameScheduling ? "game" : "normal", schedulingPriorityName(config.samplerPriority),
+           formatCpuList(config.samplerCpus).c_str(), schedulingPriorityName(config.backgroundPriority), formatCpuList(config.backgroundCpus).c_str(),
+           config.blackBoxMinutes > 0 ? (std::to_string(config.blackBoxMinutes) + " min").c_str() : "off");
+
+    // Alone, with the logger, and alone again, so drift in clock speed shows up in both baselines
+    std::string report;
+    const double before = runPhase(options, false, report);
+    printf("%-24s %14.0f steps/s\n", "game alone", before);
+    const double withLogger = runPhase(options, true, report);
+    printf("%-24s %14.0f steps/s\n", "game with logger", withLogger);
+    const double after = runPhase(options, false, report);
+    printf("%-24s %14.0f steps/s\n", "game alone again", after);
+
+    const double baseline = (before + after) / 2.0;
+    const double slowdown = 100.0 * (1.0 - withLogger / baseline);
+    const double drift = 100.0 * (before > after ? before - after : after - before) / baseline;
+    printf("\nlogger (process CPU includes the game): %s\n", report.c_str());
+    if (drift > options.budget) {
+        // The game's own speed moved by more than the logger may cost, so the slowdown says nothing
+        printf("slowdown %.2f%% (baseline drift %.2f%%), budget %.2f%%: INCONCLUSIVE, rerun on a quieter machine or with longer phases\n",
+               slowdown, drift, options.budget);
+        return 3;
+    }
+    printf("slowdown %.2f%% (baseline drift %.2f%%), budget %.2f%%: %s\n", slowdown, drift, options.budget,
+           slowdown <= options.budget ? "within budget" : "OVER BUDGET");
+    return slowdown <= options.budget ? 0 : 1;
+}
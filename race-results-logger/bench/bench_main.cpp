@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "asset_ids.h"
+#include "bench.h"
+#include "black_box.h"
+#include "config.h"
+#include "derived_publisher.h"
+#include "driving_stats.h"
+#include "gap_tracker.h"
+#include "output.h"
+#include "participant_identity.h"
+#include "participant_table.h"
+#include "reference_lap.h"
+#include "result_hash.h"
+#include "result_wire.h"
+#include "results.h"
+#include "snapshot_exchange.h"
+#include "standings.h"
+#include "telemetry_pyramid.h"
+#include "track_map.h"
+
+// Benchmarks for the per-sample and per-result paths of the logger on a synthetic 64-car field
+int main() {
+    SharedMemory* source = new SharedMemory;
+    SharedMemory* localCopy = new SharedMemory;
+    GapTracker* gapTracker = new GapTracker;
+    TrackMap* trackMap = new TrackMap;
+    ParticipantTable* participants = new ParticipantTable;
+    IdentityMap* identities = new IdentityMap;
+    fillSyntheticSnapshot(source, 600.0);
+    resetParticipantTable(*participants);
+    resetIdentityMap(*identities);
+    resetGapTracker(*gapTracker);
+    resetTrackMap(*trackMap);
+
+    printf("Snapshot size: %zu bytes, participants: %d\n\n", sizeof(SharedMemory), source->mNumParticipants);
+
+    runBenchmark("snapshot copy", 200000, [&](int) {
+        memcpy(localCopy, source, sizeof(SharedMemory));
+        benchSink += localCopy->mSequenceNumber == source->mSequenceNumber;
+    });
+
+    // Feed a few seconds of 60 Hz samples so the gap tables hold real crossings
+    for (int frame = 0; frame < 600; ++frame) {
+        fillSyntheticSnapshot(source, 600.0 + frame / 60.0);
+        updateParticipantTable(*participants, source);
+        updateIdentityMap(*identities, *participants, 600.0 + frame / 60.0);
+        updateGapTracker(*gapTracker, *participants, *identities, 600.0 + frame / 60.0);
+    }
+
+    runBenchmark("participant table update", 200000, [&](int) {
+        updateParticipantTable(*participants, source);
+        benchSink += participants->count;
+    });
+
+    runBenchmark("identity reconcile (steady)", 1000000, [&](int i) {
+        updateIdentityMap(*identities, *participants, 610.0 + i / 60.0);
+        benchSink += identities->present;
+    });
+
+    // Every car one slot down, as after a driver in front leaves: each sample alternates the two layouts,
+    // so every update is a full reconcile that moves all 64 identities
+    SharedMemory* shuffled = new SharedMemory;
+    memcpy(shuffled, source, sizeof(SharedMemory));
+    const int fieldSize = source->mNumParticipants;
+    for (int slot = 0; slot < fieldSize; ++slot) {
+        const int from = (slot + 1) % fieldSize;
+        shuffled->mParticipantInfo[slot] = source->mParticipantInfo[from];
+        memcpy(shuffled->mCarNames[slot], source->mCarNames[from], STRING_LENGTH_MAX);
+        memcpy(shuffled->mCarClassNames[slot], source->mCarClassNames[from], STRING_LENGTH_MAX);
+    }
+    ParticipantTable* shuffledParticipants = new ParticipantTable;
+    resetParticipantTable(*shuffledParticipants);
+    updateParticipantTable(*shuffledParticipants, shuffled);
+    runBenchmark("identity reconcile (reshuffle)", 200000, [&](int i) {
+        ParticipantTable& table = (i & 1) ? *participants : *shuffledParticipants;
+        table.nameChanges += 1; // what updateParticipantTable would count for the rewritten rows
+        updateIdentityMap(*identities, table, 620.0 + i / 60.0);
+        benchSink += identities->numEvents;
+    });
+    printf("%-32s %d identities, %lu joins, %lu leaves, %lu slot moves\n", "identity map", identities->count,
+           identities->joins, identities->leaves, identities->moves);
+    delete shuffled;
+    delete shuffledParticipants;
+    updateIdentityMap(*identities, *participants, 630.0);
+
+    runBenchmark("all finished check", 1000000, [&](int) {
+        benchSink += allParticipantsFinished(*participants);
+    });
+
+    runBenchmark("result extraction", 50000, [&](int) {
+        std::vector<RaceResult> results = collectResults(source, *participants, gapTracker->gaps);
+        benchSink += results.size();
+    });
+
+    std::vector<RaceResult> results = collectResults(source, *participants, gapTracker->gaps);
+    DerivedState* derivedState = new DerivedState;
+    DerivedField* derivedField = new DerivedField;
+    initDerivedState(derivedState);
+    *derivedField = derivedState->field;
+    runBenchmark("derived field build + publish", 200000, [&](int) {
+        buildDerivedField(*derivedField, source, *participants, gapTracker->gaps, 600.0);
+        publishDerivedField(derivedState, *derivedField);
+        benchSink += derivedState->field.numCars;
+    });
+
+    // Each round is a new race (new hash) of the same 64-car field, so the tallies keep growing as in a season
+    Standings* standings = new Standings;
+    resetStandings(*standings);
+    runBenchmark("standings apply (64-car race)", 50000, [&](int i) {
+        benchSink += applyRaceResult(*standings, static_cast<uint64_t>(i) + 1, results);
+    });
+    std::ostringstream standingsJson;
+    writeStandingsJson(standingsJson, *standings);
+    printf("%-32s %d races, %zu bytes JSON\n", "standings", standings->races, standingsJson.str().size());
+    delete standings;
+
+    runBenchmark("asset id lookup (car + class)", 1000000, [&](int i) {
+        const RaceResult& result = results[i % results.size()];
+        benchSink += carAssetId(result.carName) + carClassAssetId(result.carClass);
+    });
+
+    std::mt19937 random(42);
+    ServerConfig config;
+    config.server = "127.0.0.1";
+    runBenchmark("sort by position", 50000, [&](int) {
+        std::vector<RaceResult> shuffled = results;
+        std::shuffle(shuffled.begin(), shuffled.end(), random);
+        sortResults(shuffled, config);
+        benchSink += shuffled.front().position;
+    });
+
+    runBenchmark("canonical result hash", 50000, [&](int) {
+        benchSink += hashResults("Race", "Watkins Glen", "Watkins Glen Short (Inner Loop)", results);
+    });
+
+    runBenchmark("json serialization", 20000, [&](int) {
+        std::ostringstream out;
+        writeResultsJson(out, "Race", "Watkins Glen", "Watkins Glen Short (Inner Loop)", 0, results);
+        benchSink += out.str().size();
+    });
+
+    // Binary wire format against the JSON path above; size printed for comparison
+    std::string wire;
+    runBenchmark("binary wire encode", 20000, [&](int) {
+        encodeResultsWire("Race", "Watkins Glen", "Watkins Glen Short (Inner Loop)", 0, results, wire);
+        benchSink += wire.size();
+    });
+    ResultDocument document;
+    runBenchmark("binary wire decode", 20000, [&](int) {
+        benchSink += decodeResultsWire(wire, document);
+    });
+    std::ostringstream json;
+    writeResultsJson(json, "Race", "Watkins Glen", "Watkins Glen Short (Inner Loop)", 0, results);
+    printf("%-32s %zu bytes binary, %zu bytes JSON\n", "result document size", wire.size(), json.str().size());
+
+    // Per-frame updates, one 60 Hz step per iteration
+    double frameTime = 700.0;
+    runBenchmark("gap tracker update (60 Hz)", 20000, [&](int i) {
+        frameTime = 700.0 + i / 60.0;
+        fillSyntheticSnapshot(source, frameTime);
+        updateParticipantTable(*participants, source);
+        updateIdentityMap(*identities, *participants, frameTime);
+        updateGapTracker(*gapTracker, *participants, *identities, frameTime);
+        benchSink += gapTracker->numOrdered;
+    });
+
+    // The field keeps its slots from here on, so the identities of the last gap tracker frame still apply
+    SlotIdentities slots;
+    copySlotIdentities(*identities, slots);
+    runBenchmark("track map update (60 Hz)", 20000, [&](int i) {
+        fillSyntheticSnapshot(source, 700.0 + i / 60.0);
+        updateTrackMap(*trackMap, source, slots);
+        benchSink += trackMap->trajectories[slots.identity[0]].count;
+    });
+
+    // Driving analytics run on every game frame, so this is the per-frame budget
+    DrivingStats* drivingStats = new DrivingStats;
+    resetDrivingStats(*drivingStats);
+    runBenchmark("driving stats update (frame)", 200000, [&](int i) {
+        const double time = 900.0 + i / 120.0;
+        fillSyntheticPlayerInputs(source, time);
+        updateDrivingStats(*drivingStats, source, time);
+        benchSink += drivingStats->historyCount;
+    });
+    printf("%-32s %d laps, %llu frames\n", "driving stats history", drivingStats->historyCount, drivingStats->framesSeen);
+
+    // The lap delta also runs on every frame: one grid lookup plus the points passed since the last frame
+    LapDelta* lapDelta = new LapDelta;
+    fillSyntheticPlayerInputs(source, 900.0);
+    resetLapDelta(*lapDelta, source);
+    runBenchmark("lap delta update (frame)", 200000, [&](int i) {
+        fillSyntheticPlayerInputs(source, 900.0 + i / 120.0);
+        benchSink += updateLapDelta(*lapDelta, source) + lapDelta->recordedPoints;
+    });
+    printf("%-32s %d points, best %.3f s, delta %+.3f s\n", "lap delta reference", lapDelta->points,
+           lapDelta->sessionBestTime, lapDelta->hasDelta ? lapDelta->delta : 0.0f);
+
+    // The telemetry pyramid also runs on every frame; 2.3 h of 120 Hz frames wrap the 1 s level
+    TelemetryPyramid* telemetry = new TelemetryPyramid;
+    createTelemetryPyramid(*telemetry);
+    TelemetrySample telemetrySample;
+    fillSyntheticPlayerInputs(source, 900.0);
+    readTelemetrySample(source, telemetrySample);
+    runBenchmark("telemetry pyramid sample (frame)", 1000000, [&](int i) {
+        telemetrySample.groups[TELEMETRY_TYRE_TEMP].v[0] = 80.0f + (i & 15);
+        addTelemetrySample(*telemetry, telemetrySample, i / 120.0);
+        benchSink += telemetry->levels[0].count;
+    });
+    runBenchmark("telemetry level select (chart)", 200000, [&](int i) {
+        benchSink += selectTelemetryLevel(*telemetry, 0.0, 600.0 + i % 7200, 1000);
+    });
+    printf("%-32s %d/%d/%d buckets, %zu bytes\n", "telemetry pyramid levels", telemetry->levels[0].count,
+           telemetry->levels[1].count, telemetry->levels[2].count,
+           sizeof(TelemetryPyramid) + (TELEMETRY_LEVEL_BUCKETS[0] + TELEMETRY_LEVEL_BUCKETS[1] + TELEMETRY_LEVEL_BUCKETS[2]) * sizeof(TelemetryBucket));
+
+    // Sampler copy and publish plus one consumer take and release, without thread wakeups
+    SnapshotExchange* exchange = new SnapshotExchange;
+    createSnapshotExchange(*exchange);
+    const int consumer = addSnapshotConsumer(*exchange, "bench");
+    runBenchmark("snapshot exchange (frame)", 200000, [&](int i) {
+        memcpy(beginSnapshotWrite(*exchange), source, sizeof(SharedMemory));
+        publishSnapshot(*exchange, i / 120.0);
+        const SharedMemory* snapshot = acquireSnapshot(*exchange, consumer, 0, NULL);
+        benchSink += snapshot->mNumParticipants;
+        releaseSnapshot(*exchange, consumer);
+    });
+
+    // The black box codes every frame against the previous one; replay a minute of 60 Hz frames
+    const int blackBoxFrames = 3600;
+    SharedMemory* frames = new SharedMemory[blackBoxFrames];
+    for (int f = 0; f < blackBoxFrames; ++f) {
+        memcpy(&frames[f], source, sizeof(SharedMemory));
+        fillSyntheticSnapshot(&frames[f], 1200.0 + f / 60.0);
+    }
+    BlackBox* blackBox = new BlackBox;
+    createBlackBox(*blackBox, 32, 5, 0.0f);
+    runBenchmark("black box record (frame)", 36000, [&](int i) {
+        recordBlackBoxFrame(*blackBox, &frames[i % blackBoxFrames], 1200.0 + i / 60.0);
+        benchSink += blackBox->records;
+    });
+    printf("%-32s %u frames over %.0f s in %zu KB, %.1f:1\n", "black box ring", blackBox->records,
+           blackBox->records / 60.0, blackBox->used / 1024, static_cast<double>(blackBox->bytesIn) / blackBox->bytesOut);
+
+    runBenchmark("synthetic snapshot fill", 20000, [&](int i) {
+        fillSyntheticSnapshot(source, 700.0 + i / 60.0);
+        benchSink += source->mNumParticipants;
+    });
+
+    delete source;
+    delete localCopy;
+    delete gapTracker;
+    delete trackMap;
+    delete participants;
+    delete identities;
+    delete derivedState;
+    delete derivedField;
+    delete drivingStats;
+    delete lapDelta;
+    destroyTelemetryPyramid(*telemetry);
+    delete telemetry;
+    destroySnapshotExchange(*exchange);
+    delete exchange;
+    destroyBlackBox(*blackBox);
+    delete blackBox;
+    delete[] frames;
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include "bench.h"
+#include <stdio.h>
+#include <math.h>
+
+volatile unsigned long long benchSink = 0;
+
+static const char* const CAR_NAMES[] = {
+    "Formula Inter MG-15", "Porsche 911 GT3 R", "McLaren 720S GT3", "BMW M4 GT4",
+    "Mercedes-AMG GT3", "Ginetta G55 GT4", "Porsche 962C", "Lotus 72E"
+};
+static const char* const CAR_CLASSES[] = {
+    "F-Inter", "GT3", "GT3", "GT4", "GT3", "GT4", "Group C", "F-Retro_Gen1"
+};
+
+// Fill a snapshot with a full 64-car race field at the given race time
+void fillSyntheticSnapshot(SharedMemory* sharedData, double raceTime) {
+    memset(sharedData, 0, sizeof(SharedMemory));
+    sharedData->mVersion = SHARED_MEMORY_VERSION;
+    sharedData->mGameState = GAME_INGAME_PLAYING;
+    sharedData->mSessionState = SESSION_RACE;
+    sharedData->mRaceState = RACESTATE_RACING;
+    sharedData->mNumParticipants = STORED_PARTICIPANTS_MAX;
+    sharedData->mViewedParticipantIndex = 0;
+    sharedData->mTrackLength = 5100.0f;
+    snprintf(sharedData->mTrackLocation, STRING_LENGTH_MAX, "Watkins Glen");
+    snprintf(sharedData->mTrackVariation, STRING_LENGTH_MAX, "Watkins Glen Short (Inner Loop)");
+
+    for (int i = 0; i < STORED_PARTICIPANTS_MAX; ++i) {
+        ParticipantInfo& info = sharedData->mParticipantInfo[i];
+        // Cars slow down a little with grid slot, so the field spreads out and gets lapped
+        double distance = (60.0 - i * 0.15) * raceTime + (STORED_PARTICIPANTS_MAX - i) * 8.0;
+        info.mIsActive = true;
+        snprintf(info.mName, STRING_LENGTH_MAX, "Driver %02d", i + 1);
+        info.mLapsCompleted = static_cast<unsigned int>(distance / sharedData->mTrackLength);
+        info.mCurrentLapDistance = static_cast<float>(distance - info.mLapsCompleted * sharedData->mTrackLength);
+        info.mCurrentLap = info.mLapsCompleted + 1;
+        info.mCurrentSector = static_cast<int>(info.mCurrentLapDistance / (sharedData->mTrackLength / 3.0f));
+        info.mRacePosition = i + 1;
+        info.mWorldPosition[VEC_X] = info.mCurrentLapDistance * 0.1f;
+        info.mWorldPosition[VEC_Z] = info.mCurrentLapDistance * 0.05f;
+        sharedData->mRaceStates[i] = RACESTATE_RACING;
+        sharedData->mSpeeds[i] = 60.0f;
+        sharedData->mLastLapTimes[i] = 85.0f + i * 0.1f;
+        sharedData->mFastestLapTimes[i] = 84.0f + i * 0.1f;
+        snprintf(sharedData->mCarNames[i], STRING_LENGTH_MAX, "%s", CAR_NAMES[i % 8]);
+        snprintf(sharedData->mCarClassNames[i], STRING_LENGTH_MAX, "%s", CAR_CLASSES[i % 8]);
+    }
+
+    fillSyntheticPlayerInputs(sharedData, raceTime);
+}
+
+// Move car 0 to where it is at the given race time and fill the player-car input block
+void fillSyntheticPlayerInputs(SharedMemory* sharedData, double raceTime) {
+    ParticipantInfo& info = sharedData->mParticipantInfo[0];
+    double distance = 60.0 * raceTime + STORED_PARTICIPANTS_MAX * 8.0;
+    info.mLapsCompleted = static_cast<unsigned int>(distance / sharedData->mTrackLength);
+    info.mCurrentLapDistance = static_cast<float>(distance - info.mLapsCompleted * sharedData->mTrackLength);
+    info.mCurrentLap = info.mLapsCompleted + 1;
+    info.mCurrentSector = static_cast<int>(info.mCurrentLapDistance / (sharedData->mTrackLength / 3.0f));
+
+    // Flat out, then braking and a part-throttle exit three times a lap
+    const float phase = fmodf(info.mCurrentLapDistance, 1700.0f);
+    const bool braking = phase > 1400.0f && phase < 1500.0f;
+    sharedData->mThrottle = braking ? 0.0f : phase > 1500.0f ? 0.6f : 1.0f;
+    sharedData->mBrake = braking ? 0.9f : 0.0f;
+    sharedData->mSpeed = braking ? 90.0f - (phase - 1400.0f) * 0.5f : 40.0f + phase * 0.03f;
+    sharedData->mGear = 1 + static_cast<int>(phase / 300.0f);
+    sharedData->mRpm = 5000.0f + fmodf(phase, 300.0f) * 10.0f;
+    sharedData->mLocalAcceleration[VEC_X] = sinf(phase * 0.01f) * 20.0f;
+    sharedData->mLocalAcceleration[VEC_Z] = braking ? 25.0f : -5.0f;
+    sharedData->mCurrentTime = info.mCurrentLapDistance / 60.0f;
+    sharedData->mLastLapTime = info.mLapsCompleted > 0 ? sharedData->mTrackLength / 60.0f : 0.0f;
+
+    // Tyres and brakes heat under braking and wear slowly over the race
+    for (int k = 0; k < TYRE_MAX; ++k) {
+        sharedData->mTyreTemp[k] = 80.0f + k + (braking ? 15.0f : 0.0f);
+        sharedData->mTyreTreadTemp[k] = 355.0f + k + (braking ? 20.0f : 0.0f);
+        sharedData->mBrakeTempCelsius[k] = braking ? 650.0f : 400.0f;
+        sharedData->mTyreWear[k] = static_cast<float>(fmod(raceTime / 3600.0, 1.0));
+        sharedData->mAirPressure[k] = 26.0f + 0.01f * sharedData->mTyreTemp[k];
+    }
+    sharedData->mRainDensity = 0.0f;
+    sharedData->mTrackTemperature = 32.0f;
+    sharedData->mAmbientTemperature = 24.0f;
+    sharedData->mSequenceNumber = 2 * static_cast<unsigned int>(raceTime * 60.0 + 1.0);
+}
@@ -15,9 +15,23 @@ IF %ERRORLEVEL% NEQ 0 (
     EXIT /B %ERRORLEVEL%
 )
 
+:: Generate the asset ID tables from the server's CSV data tables
+ECHO Generating asset ID tables...
+IF NOT EXIST "generated" mkdir generated
+g++ -std=c++17 -Isrc -o ams2assetgen.exe tools/ams2assetgen.cpp
+IF %ERRORLEVEL% NEQ 0 (
+    ECHO Error: Failed to compile tools/ams2assetgen.cpp
+    EXIT /B %ERRORLEVEL%
+)
+ams2assetgen.exe ../race-results-server/fs/data/csv generated/asset_ids_table.h
+IF %ERRORLEVEL% NEQ 0 (
+    ECHO Error: Failed to generate generated/asset_ids_table.h
+    EXIT /B %ERRORLEVEL%
+)
+
 :: Compile and link C++ program
 ECHO Compiling src/race_logger.cpp...
-g++ -o ams2results.exe src/race_logger.cpp resource.o -lwinmm -lcurl -mconsole
+g++ -std=c++17 -Igenerated -o ams2results.exe src/race_logger.cpp src/upload.cpp src/asset_ids.cpp src/black_box.cpp src/compression.cpp src/config.cpp src/derived_publisher.cpp src/driving_stats.cpp src/gap_tracker.cpp src/logger.cpp src/logger_threads.cpp src/output.cpp src/participant_identity.cpp src/participant_table.cpp src/reference_lap.cpp src/result_hash.cpp src/result_wire.cpp src/results.cpp src/scheduling.cpp src/snapshot_exchange.cpp src/standings.cpp src/telemetry_pyramid.cpp src/track_map.cpp src/platform_win32.cpp resource.o -lwinmm -lcurl -lz -mconsole
 IF %ERRORLEVEL% NEQ 0 (
     ECHO Error: Failed to compile src/race_logger.cpp or link ams2results.exe
     EXIT /B %ERRORLEVEL%
@@ -0,0 +1,41 @@
+#include "asset_ids.h"
+#include <mutex>
+#include <set>
+#include "asset_ids_table.h"
+#include "logger.h"
+
+// Names already warned about, so a field of unknown cars is reported once and not on every capture
+static std::mutex unknownMutex;
+static std::set<std::string> unknownNames;
+
+// ID of a car from mCarNames ("Car Game Internal Name")
+uint32_t carAssetId(const std::string& carName) {
+    return lookupAssetId(CAR_ASSETS, carName.data(), carName.size());
+}
+
+// ID of a car class from mCarClassNames ("Car Class Game Internal Name")
+uint32_t carClassAssetId(const std::string& carClass) {
+    return lookupAssetId(CAR_CLASS_ASSETS, carClass.data(), carClass.size());
+}
+
+// ID of a track layout; layout names repeat across locations ("Grand Prix"), so the key is location + layout
+uint32_t trackAssetId(const std::string& location, const std::string& layout) {
+    std::string key = location;
+    key += '\0';
+    key += layout;
+    return lookupAssetId(TRACK_ASSETS, key.data(), key.size());
+}
+
+// ID of a track location
+uint32_t locationAssetId(const std::string& location) {
+    return lookupAssetId(LOCATION_ASSETS, location.data(), location.size());
+}
+
+// Log a warning the first time a name of the given kind resolves to ASSET_ID_UNKNOWN
+void warnUnknownAsset(const char* kind, const std::string& name) {
+    {
+        std::lock_guard<std::mutex> lock(unknownMutex);
+        if (!unknownNames.insert(std::string(kind) + ":" + name).second) return;
+    }
+    logMessage("WARNING", std::string("Unknown ") + kind + " '" + name + "', sent with asset ID 0");
+}
@@ -0,0 +1,80 @@
+#ifndef ASSET_IDS_H
+#define ASSET_IDS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Stable numeric IDs for the cars, classes, tracks and locations the server's CSV tables know,
+// so results can be joined on numbers instead of names. An ID is the FNV-1a hash of the game
+// name (assetId() in race-results-server/src/utils/assetIds.js computes the same); the known
+// names sit in perfect-hash tables generated at build time by tools/ams2assetgen.cpp.
+
+// ID of a name the tables do not know
+enum
+{
+  ASSET_ID_UNKNOWN = 0
+};
+
+// FNV-1a 32-bit hash of a UTF-8 name
+constexpr uint32_t fnv1a32(const char* text, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(text[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// One slot of a generated table; the name is kept to tell a known name from one that only lands on its slot
+struct AssetEntry {
+    const char* name;                                 // [ UNSET = NULL ]
+    uint32_t length;
+    uint32_t id;
+};
+
+// Perfect-hash table: a name's bucket picks the displacement that sends it to its own slot
+struct AssetTable {
+    const AssetEntry* slots;
+    uint32_t slotMask;                                // slot count - 1, a power of two
+    const uint16_t* displacements;
+    uint32_t bucketCount;
+};
+
+// Slot hash of a name hash under a bucket displacement
+constexpr uint32_t mixAssetHash(uint32_t hash, uint32_t displacement) {
+    uint32_t x = hash ^ (displacement * 0x9E3779B9u);
+    x ^= x >> 16;
+    x *= 0x85EBCA6Bu;
+    x ^= x >> 13;
+    return x;
+}
+
+// Look a name up in one hash, one probe and one compare; ASSET_ID_UNKNOWN if the table does not hold it
+constexpr uint32_t lookupAssetId(const AssetTable& table, const char* name, size_t length) {
+    const uint32_t hash = fnv1a32(name, length);
+    const uint32_t displacement = table.displacements[hash % table.bucketCount];
+    const AssetEntry& entry = table.slots[mixAssetHash(hash, displacement) & table.slotMask];
+    if (entry.name == NULL || entry.id != hash || entry.length != length) return ASSET_ID_UNKNOWN;
+    for (size_t i = 0; i < length; ++i) {
+        if (entry.name[i] != name[i]) return ASSET_ID_UNKNOWN;
+    }
+    return hash;
+}
+
+// ID of a car from mCarNames ("Car Game Internal Name")
+uint32_t carAssetId(const std::string& carName);
+
+// ID of a car class from mCarClassNames ("Car Class Game Internal Name")
+uint32_t carClassAssetId(const std::string& carClass);
+
+// ID of a track layout; layout names repeat across locations ("Grand Prix"), so the key is location + layout
+uint32_t trackAssetId(const std::string& location, const std::string& layout);
+
+// ID of a track location
+uint32_t locationAssetId(const std::string& location);
+
+// Log a warning the first time a name of the given kind resolves to ASSET_ID_UNKNOWN
+void warnUnknownAsset(const char* kind, const std::string& name);
+
+#endif // ASSET_IDS_H
@@ -0,0 +1,305 @@
+#include "black_box.h"
+#include <string.h>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include "logger.h"
+#include "output.h"
+
+// Dump file header: "AMSB", u32 version, u32 snapshot bytes, u32 shared memory version,
+// u32 records, f64 trigger time, u32 reason length, reason bytes; then the records
+static const char BLACK_BOX_MAGIC[4] = {'A', 'M', 'S', 'B'};
+
+// Copy into the ring at 'offset', wrapping at the end
+static void ringWrite(BlackBox& box, size_t offset, const unsigned char* source, size_t size) {
+    offset %= box.capacity;
+    size_t first = size < box.capacity - offset ? size : box.capacity - offset;
+    memcpy(box.ring + offset, source, first);
+    memcpy(box.ring, source + first, size - first);
+}
+
+// Copy out of the ring from 'offset', wrapping at the end
+static void ringRead(const BlackBox& box, size_t offset, unsigned char* target, size_t size) {
+    offset %= box.capacity;
+    size_t first = size < box.capacity - offset ? size : box.capacity - offset;
+    memcpy(target, box.ring + offset, first);
+    memcpy(target + first, box.ring, size - first);
+}
+
+// Header fields of the record at 'offset'
+static void readRecordHeader(const BlackBox& box, size_t offset, uint32_t& size, uint32_t& flags, double& time) {
+    unsigned char header[BLACK_BOX_RECORD_HEADER_SIZE];
+    ringRead(box, offset, header, sizeof(header));
+    memcpy(&size, header, 4);
+    memcpy(&flags, header + 4, 4);
+    memcpy(&time, header + 8, 8);
+}
+
+// Drop the oldest record
+static void dropOldestRecord(BlackBox& box) {
+    uint32_t size, flags;
+    double time;
+    readRecordHeader(box, box.head, size, flags, time);
+    box.head = (box.head + BLACK_BOX_RECORD_HEADER_SIZE + size) % box.capacity;
+    box.used -= BLACK_BOX_RECORD_HEADER_SIZE + size;
+    box.records--;
+}
+
+// Code 'current' XOR 'previous' (or 'current' alone for a keyframe) as runs of
+// u16 zero words, u16 literal words, literal words; returns the bytes written
+static size_t encodeFrame(const uint64_t* current, const uint64_t* previous, unsigned char* out) {
+    size_t pos = 0;
+    int w = 0;
+    while (w < BLACK_BOX_WORDS) {
+        uint16_t zeros = 0;
+        while (w < BLACK_BOX_WORDS && zeros < BLACK_BOX_RUN_MAX && current[w] == (previous ? previous[w] : 0)) {
+            ++zeros;
+            ++w;
+        }
+        const int literalStart = w;
+        uint16_t literals = 0;
+        while (w < BLACK_BOX_WORDS && literals < BLACK_BOX_RUN_MAX && current[w] != (previous ? previous[w] : 0)) {
+            ++literals;
+            ++w;
+        }
+        memcpy(out + pos, &zeros, 2);
+        memcpy(out + pos + 2, &literals, 2);
+        pos += 4;
+        for (int i = literalStart; i < w; ++i) {
+            uint64_t delta = current[i] ^ (previous ? previous[i] : 0);
+            memcpy(out + pos, &delta, 8);
+            pos += 8;
+        }
+    }
+    return pos;
+}
+
+// Apply one coded frame to 'frame' in place; false if the runs do not fit
+static bool decodeFrame(const unsigned char* in, size_t size, uint64_t* frame) {
+    size_t pos = 0;
+    int w = 0;
+    while (pos < size) {
+        if (size - pos < 4) return false;
+        uint16_t zeros, literals;
+        memcpy(&zeros, in + pos, 2);
+        memcpy(&literals, in + pos + 2, 2);
+        pos += 4;
+        w += zeros;
+        if (w + literals > BLACK_BOX_WORDS || size - pos < static_cast<size_t>(literals) * 8) return false;
+        for (int i = 0; i < literals; ++i, ++w, pos += 8) {
+            uint64_t delta;
+            memcpy(&delta, in + pos, 8);
+            frame[w] ^= delta;
+        }
+    }
+    return w == BLACK_BOX_WORDS;
+}
+
+// Allocate a ring of memoryMB megabytes keeping at most maxMinutes of frames
+void createBlackBox(BlackBox& box, int memoryMB, int maxMinutes, float collisionThreshold) {
+    if (memoryMB < BLACK_BOX_MIN_MEMORY_MB) memoryMB = BLACK_BOX_MIN_MEMORY_MB;
+    box.capacity = static_cast<size_t>(memoryMB) * 1024 * 1024;
+    box.ring = new unsigned char[box.capacity];
+    box.maxAge = maxMinutes * 60.0;
+    box.collisionThreshold = collisionThreshold;
+    box.postTriggerSeconds = 5.0;
+    box.previous = new uint64_t[BLACK_BOX_WORDS];
+    box.current = new uint64_t[BLACK_BOX_WORDS];
+    box.scratch = new unsigned char[BLACK_BOX_RECORD_HEADER_SIZE + BLACK_BOX_WORDS * 12 + 4];
+    resetBlackBox(box);
+}
+
+// Free the ring and encoder buffers
+void destroyBlackBox(BlackBox& box) {
+    delete[] box.ring;
+    delete[] box.previous;
+    delete[] box.current;
+    delete[] box.scratch;
+    box.ring = NULL;
+    box.previous = NULL;
+    box.current = NULL;
+    box.scratch = NULL;
+}
+
+// Drop every record, e.g. when shared memory reconnects
+void resetBlackBox(BlackBox& box) {
+    box.head = 0;
+    box.used = 0;
+    box.records = 0;
+    box.framesSinceKeyframe = 0;
+    box.havePrevious = false;
+    box.framesRecorded = 0;
+    box.bytesIn = 0;
+    box.bytesOut = 0;
+    box.lastCollisionIndex = -1;
+    box.lastCollisionMagnitude = 0.0f;
+    box.lastCrashState = CRASH_DAMAGE_NONE;
+    std::lock_guard<std::mutex> lock(box.requestMutex);
+    box.pendingReason.clear();
+    box.dumpAt = 0.0;
+}
+
+// Delta-code one snapshot into the ring, dropping the oldest records to stay within memory and age
+void recordBlackBoxFrame(BlackBox& box, const SharedMemory* sharedData, double now) {
+    box.current[BLACK_BOX_WORDS - 1] = 0;
+    memcpy(box.current, sharedData, sizeof(SharedMemory));
+
+    bool keyframe = !box.havePrevious || box.framesSinceKeyframe >= BLACK_BOX_KEYFRAME_INTERVAL;
+    size_t payload = encodeFrame(box.current, keyframe ? NULL : box.previous, box.scratch + BLACK_BOX_RECORD_HEADER_SIZE);
+    size_t size = BLACK_BOX_RECORD_HEADER_SIZE + payload;
+
+    // Drop whole keyframe groups from the front, a delta is useless without the frames before it
+    while (box.records > 0) {
+        uint32_t oldestSize, oldestFlags;
+        double oldestTime;
+        readRecordHeader(box, box.head, oldestSize, oldestFlags, oldestTime);
+        const bool groupStart = (oldestFlags & BLACK_BOX_FLAG_KEYFRAME) != 0;
+        if (groupStart && box.used + size <= box.capacity && oldestTime >= now - box.maxAge) break;
+        dropOldestRecord(box);
+    }
+    if (box.records == 0 && !keyframe) {
+        keyframe = true;
+        payload = encodeFrame(box.current, NULL, box.scratch + BLACK_BOX_RECORD_HEADER_SIZE);
+        size = BLACK_BOX_RECORD_HEADER_SIZE + payload;
+    }
+    if (size > box.capacity) return;
+
+    const uint32_t payloadSize = static_cast<uint32_t>(payload);
+    const uint32_t flags = keyframe ? BLACK_BOX_FLAG_KEYFRAME : 0;
+    memcpy(box.scratch, &payloadSize, 4);
+    memcpy(box.scratch + 4, &flags, 4);
+    memcpy(box.scratch + 8, &now, 8);
+    ringWrite(box, box.head + box.used, box.scratch, size);
+    box.used += size;
+    box.records++;
+
+    uint64_t* swap = box.previous;
+    box.previous = box.current;
+    box.current = swap;
+    box.havePrevious = true;
+    box.framesSinceKeyframe = keyframe ? 1 : box.framesSinceKeyframe + 1;
+    box.framesRecorded++;
+    box.bytesIn += sizeof(SharedMemory);
+    box.bytesOut += size;
+}
+
+// Request a dump from the recording thread for a collision or a crash state change of the viewed car
+void checkBlackBoxTriggers(BlackBox& box, const SharedMemory* sharedData, double now) {
+    const int collisionIndex = sharedData->mLastOpponentCollisionIndex;
+    const float collisionMagnitude = sharedData->mLastOpponentCollisionMagnitude;
+    const bool armed = box.framesRecorded > 1; // values already set when the logger started are not incidents
+    if (armed && (collisionIndex != box.lastCollisionIndex || collisionMagnitude != box.lastCollisionMagnitude) &&
+        collisionIndex >= 0 && box.collisionThreshold > 0.0f && collisionMagnitude >= box.collisionThreshold) {
+        requestBlackBoxDump(box, "collision", now);
+    }
+    box.lastCollisionIndex = collisionIndex;
+    box.lastCollisionMagnitude = collisionMagnitude;
+
+    if (armed && sharedData->mCrashState != box.lastCrashState && sharedData->mCrashState != CRASH_DAMAGE_NONE) {
+        requestBlackBoxDump(box, "crash", now);
+    }
+    box.lastCrashState = sharedData->mCrashState;
+}
+
+// Ask for a dump postTriggerSeconds after 'now'; requests while one is pending join it. Any thread.
+void requestBlackBoxDump(BlackBox& box, const std::string& reason, double now) {
+    std::lock_guard<std::mutex> lock(box.requestMutex);
+    if (box.pendingReason.empty()) {
+        box.pendingReason = reason;
+        box.dumpAt = now + box.postTriggerSeconds;
+        logMessage("INFO", "Black box dump requested: " + reason);
+    } else if (box.pendingReason.find(reason) == std::string::npos) {
+        box.pendingReason += "_" + reason;
+    }
+}
+
+// Write the ring to blackbox/ if a requested dump is due; returns the file name or ""
+std::string saveBlackBoxIfDue(BlackBox& box, double now) {
+    std::string reason;
+    double triggerTime;
+    {
+        std::lock_guard<std::mutex> lock(box.requestMutex);
+        if (box.pendingReason.empty() || now < box.dumpAt) return "";
+        reason.swap(box.pendingReason);
+        triggerTime = box.dumpAt - box.postTriggerSeconds;
+    }
+    if (box.records == 0) return "";
+
+    namespace fs = std::filesystem;
+    if (!fs::exists("blackbox")) {
+        fs::create_directory("blackbox");
+        logMessage("INFO", "Created blackbox/ directory");
+    }
+    time_t wallClock = time(nullptr);
+    char timeStr[64];
+    strftime(timeStr, sizeof(timeStr), "blackbox/blackbox_%Y%m%d_%H%M%S_", localtime(&wallClock));
+    std::string filename = std::string(timeStr) + sanitizeFilename(reason) + BLACK_BOX_EXTENSION;
+    std::ofstream file(filename, std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        logMessage("ERROR", "Failed to open black box file: " + filename);
+        return "";
+    }
+
+    const uint32_t header[4] = {BLACK_BOX_VERSION, static_cast<uint32_t>(sizeof(SharedMemory)), SHARED_MEMORY_VERSION, box.records};
+    const uint32_t reasonSize = static_cast<uint32_t>(reason.size());
+    file.write(BLACK_BOX_MAGIC, sizeof(BLACK_BOX_MAGIC));
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&triggerTime), sizeof(triggerTime));
+    file.write(reinterpret_cast<const char*>(&reasonSize), sizeof(reasonSize));
+    file.write(reason.data(), reason.size());
+    const size_t first = box.used < box.capacity - box.head ? box.used : box.capacity - box.head;
+    file.write(reinterpret_cast<const char*>(box.ring + box.head), first);
+    file.write(reinterpret_cast<const char*>(box.ring), box.used - first);
+    file.close();
+
+    uint32_t size, flags;
+    double oldestTime;
+    readRecordHeader(box, box.head, size, flags, oldestTime);
+    logMessage("INFO", "Black box saved to " + filename + ": " + std::to_string(box.records) + " frames over " +
+                       std::to_string(static_cast<int>(now - oldestTime)) + " s, " + std::to_string(box.used / 1024) + " KB (" +
+                       std::to_string(box.bytesOut > 0 ? box.bytesIn / box.bytesOut : 0) + ":1)");
+    return filename;
+}
+
+// Start reading a dump; false if it is not a black box file for this shared memory layout
+bool openBlackBoxDump(const std::string& data, BlackBoxReader& reader) {
+    const size_t fixedSize = sizeof(BLACK_BOX_MAGIC) + 4 * 4 + 8 + 4;
+    if (data.size() < fixedSize || memcmp(data.data(), BLACK_BOX_MAGIC, sizeof(BLACK_BOX_MAGIC)) != 0) return false;
+    uint32_t header[4];
+    uint32_t reasonSize;
+    memcpy(header, data.data() + 4, sizeof(header));
+    memcpy(&reader.triggerTime, data.data() + 20, 8);
+    memcpy(&reasonSize, data.data() + 28, 4);
+    if (header[0] != BLACK_BOX_VERSION || header[1] != sizeof(SharedMemory) || data.size() - fixedSize < reasonSize) return false;
+    reader.data = &data;
+    reader.reason = data.substr(fixedSize, reasonSize);
+    reader.offset = fixedSize + reasonSize;
+    reader.records = header[3];
+    reader.recordsLeft = header[3];
+    reader.frame = new uint64_t[BLACK_BOX_WORDS]();
+    return true;
+}
+
+// Decode the next frame into reader.frame; false at the end or on a corrupt record
+bool nextBlackBoxFrame(BlackBoxReader& reader, double& time) {
+    const std::string& data = *reader.data;
+    if (reader.recordsLeft == 0 || data.size() - reader.offset < BLACK_BOX_RECORD_HEADER_SIZE) return false;
+    uint32_t size, flags;
+    memcpy(&size, data.data() + reader.offset, 4);
+    memcpy(&flags, data.data() + reader.offset + 4, 4);
+    memcpy(&time, data.data() + reader.offset + 8, 8);
+    reader.offset += BLACK_BOX_RECORD_HEADER_SIZE;
+    if (data.size() - reader.offset < size) return false;
+    if (flags & BLACK_BOX_FLAG_KEYFRAME) memset(reader.frame, 0, BLACK_BOX_WORDS * sizeof(uint64_t));
+    else if (reader.recordsLeft == reader.records) return false; // must start at a keyframe
+    if (!decodeFrame(reinterpret_cast<const unsigned char*>(data.data()) + reader.offset, size, reader.frame)) return false;
+    reader.offset += size;
+    reader.recordsLeft--;
+    return true;
+}
+
+// Free the reader's frame buffer
+void closeBlackBoxDump(BlackBoxReader& reader) {
+    delete[] reader.frame;
+    reader.frame = NULL;
+}
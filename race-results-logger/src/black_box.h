@@ -0,0 +1,110 @@
+#ifndef BLACK_BOX_H
+#define BLACK_BOX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include "SharedMemory.h"
+
+// Black box dump files: blackbox/blackbox_YYYYMMDD_HHMMSS_<reason>.amsb
+#define BLACK_BOX_EXTENSION ".amsb"
+
+// Dropping this file into blackbox/ asks for a dump; its first line, if any, is the reason
+#define BLACK_BOX_REQUEST_FILE "blackbox/dump.request"
+
+// Snapshots are XOR'd against the previous one in 64-bit words, so mostly zero, and the
+// zero runs are length-coded. Every BLACK_BOX_KEYFRAME_INTERVAL frames one is coded against
+// zero instead, so the ring can be replayed from any keyframe once older frames are dropped.
+enum
+{
+  BLACK_BOX_KEYFRAME_INTERVAL = 120,
+  BLACK_BOX_WORDS = (sizeof(SharedMemory) + 7) / 8,
+  BLACK_BOX_RUN_MAX = 0xFFFF,                         // words per zero or literal run
+  BLACK_BOX_MIN_MEMORY_MB = 1,
+  BLACK_BOX_VERSION = 1
+};
+
+// Record header in the ring and in dump files:
+// u32 payload bytes, u32 flags (bit 0 = keyframe), f64 time
+enum
+{
+  BLACK_BOX_RECORD_HEADER_SIZE = 16,
+  BLACK_BOX_FLAG_KEYFRAME = 1
+};
+
+// Last N minutes of snapshots in a fixed-size byte ring, oldest record first
+struct BlackBox {
+    unsigned char* ring;
+    size_t capacity;                                  // [ UNITS = bytes ]
+    size_t head;                                      // offset of the oldest record
+    size_t used;                                      // bytes of records from head on
+    unsigned int records;
+    double maxAge;                                    // [ UNITS = seconds ]
+    float collisionThreshold;                         // [ UNSET = 0.0f, collisions never trigger ]
+    double postTriggerSeconds;                        // frames kept after a trigger before dumping
+
+    // Encoder state
+    uint64_t* previous;                               // last recorded frame, padded to BLACK_BOX_WORDS
+    uint64_t* current;
+    unsigned char* scratch;                           // worst-case encoded record
+    unsigned int framesSinceKeyframe;
+    bool havePrevious;
+    unsigned long long framesRecorded;
+    unsigned long long bytesIn;
+    unsigned long long bytesOut;
+
+    // Trigger state, seen by the recording thread
+    int lastCollisionIndex;
+    float lastCollisionMagnitude;
+    unsigned int lastCrashState;
+
+    // Dump requests from any thread: a collision or crash of the viewed car, a disputed result,
+    // the Ctrl+Shift+B hotkey or the request file
+    std::mutex requestMutex;
+    std::string pendingReason;                        // [ UNSET = "" ]
+    double dumpAt;                                    // snapshot time the pending dump is written at
+};
+
+// Replays a dump one frame at a time
+struct BlackBoxReader {
+    const std::string* data;
+    size_t offset;
+    unsigned int recordsLeft;
+    uint64_t* frame;                                  // BLACK_BOX_WORDS, the last decoded frame
+    std::string reason;
+    double triggerTime;
+    unsigned int records;
+};
+
+// Allocate a ring of memoryMB megabytes keeping at most maxMinutes of frames
+void createBlackBox(BlackBox& box, int memoryMB, int maxMinutes, float collisionThreshold);
+
+// Free the ring and encoder buffers
+void destroyBlackBox(BlackBox& box);
+
+// Drop every record, e.g. when shared memory reconnects
+void resetBlackBox(BlackBox& box);
+
+// Delta-code one snapshot into the ring, dropping the oldest records to stay within memory and age
+void recordBlackBoxFrame(BlackBox& box, const SharedMemory* sharedData, double now);
+
+// Request a dump from the recording thread for a collision or a crash state change of the viewed car
+void checkBlackBoxTriggers(BlackBox& box, const SharedMemory* sharedData, double now);
+
+// Ask for a dump postTriggerSeconds after 'now'; requests while one is pending join it. Any thread.
+void requestBlackBoxDump(BlackBox& box, const std::string& reason, double now);
+
+// Write the ring to blackbox/ if a requested dump is due; returns the file name or ""
+std::string saveBlackBoxIfDue(BlackBox& box, double now);
+
+// Start reading a dump; false if it is not a black box file for this shared memory layout
+bool openBlackBoxDump(const std::string& data, BlackBoxReader& reader);
+
+// Decode the next frame into reader.frame; false at the end or on a corrupt record
+bool nextBlackBoxFrame(BlackBoxReader& reader, double& time);
+
+// Free the reader's frame buffer
+void closeBlackBoxDump(BlackBoxReader& reader);
+
+#endif // BLACK_BOX_H
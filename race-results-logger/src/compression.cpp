@@ -0,0 +1,152 @@
+#include "compression.h"
+#include <zlib.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+// zlib window bits: 15 for a zlib stream, +16 for a gzip wrapper
+static const int ZLIB_WINDOW_BITS = 15;
+static const int GZIP_WINDOW_BITS = 15 + 16;
+
+// Largest dictionary deflate can still reference (its window size)
+static const size_t DICTIONARY_SIZE_MAX = 32768;
+
+// Check that a training sample is a result document (a JSON object with a Drivers array),
+// so stray files in an archive folder do not end up in the dictionary
+bool isResultDocument(const std::string& data) {
+    const size_t first = data.find_first_not_of(" \t\r\n");
+    return first != std::string::npos && data[first] == '{' && data.find("\"Drivers\": [") != std::string::npos;
+}
+
+// Build a dictionary from sample documents: the lines repeated most across the samples
+// (keys, car, class and track strings with their indentation), most useful last so they sit
+// closest to the data in the deflate window
+CompressionDictionary trainDictionary(const std::vector<std::string>& samples, size_t maxSize) {
+    std::unordered_map<std::string, size_t> counts;
+    for (const auto& sample : samples) {
+        std::istringstream lines(sample);
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.size() > 2) counts[line]++;
+        }
+    }
+
+    // Score by the bytes a line would save over the whole sample set
+    std::vector<std::pair<size_t, std::string>> scored;
+    for (const auto& entry : counts) {
+        if (entry.second < 2) continue;
+        scored.push_back(std::make_pair(entry.second * (entry.first.size() + 1), entry.first));
+    }
+    std::sort(scored.begin(), scored.end(), [](const std::pair<size_t, std::string>& a, const std::pair<size_t, std::string>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    maxSize = std::min(maxSize, DICTIONARY_SIZE_MAX);
+    std::vector<const std::string*> chosen;
+    size_t size = 0;
+    for (const auto& entry : scored) {
+        if (size + entry.second.size() + 1 > maxSize) continue;
+        chosen.push_back(&entry.second);
+        size += entry.second.size() + 1;
+    }
+
+    CompressionDictionary dictionary;
+    for (auto it = chosen.rbegin(); it != chosen.rend(); ++it) {
+        dictionary.data += **it;
+        dictionary.data += '\n';
+    }
+    dictionary.id = adler32(adler32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(dictionary.data.data()), static_cast<uInt>(dictionary.data.size()));
+    return dictionary;
+}
+
+// Load a dictionary file; false if it cannot be read or is empty
+bool loadDictionary(const std::string& filename, CompressionDictionary& dictionary) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    dictionary.data = buffer.str();
+    if (dictionary.data.empty() || dictionary.data.size() > DICTIONARY_SIZE_MAX) return false;
+    dictionary.id = adler32(adler32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(dictionary.data.data()), static_cast<uInt>(dictionary.data.size()));
+    return true;
+}
+
+// Write a dictionary file
+bool saveDictionary(const std::string& filename, const CompressionDictionary& dictionary) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+    file.write(dictionary.data.data(), dictionary.data.size());
+    return file.good();
+}
+
+// Run deflate over the whole input in one call; the documents are small
+static bool deflateAll(z_stream& stream, const std::string& input, std::string& output) {
+    output.resize(deflateBound(&stream, static_cast<uLong>(input.size())));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+    int status = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return status == Z_STREAM_END;
+}
+
+// Inflate until the end of the stream, growing the output as needed
+static bool inflateAll(z_stream& stream, const std::string& input, std::string& output, const CompressionDictionary* dictionary) {
+    output.clear();
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    char chunk[16384];
+    int status = Z_OK;
+    while (status != Z_STREAM_END) {
+        stream.next_out = reinterpret_cast<Bytef*>(chunk);
+        stream.avail_out = sizeof(chunk);
+        status = inflate(&stream, Z_NO_FLUSH);
+        if (status == Z_NEED_DICT) {
+            if (dictionary == NULL || stream.adler != dictionary->id) break;
+            status = inflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary->data.data()), static_cast<uInt>(dictionary->data.size()));
+            if (status != Z_OK) break;
+            continue;
+        }
+        if (status != Z_OK && status != Z_STREAM_END) break;
+        output.append(chunk, sizeof(chunk) - stream.avail_out);
+        if (status == Z_OK && stream.avail_in == 0 && stream.avail_out != 0) break; // truncated input
+    }
+    inflateEnd(&stream);
+    return status == Z_STREAM_END;
+}
+
+// zlib stream deflated with a preset dictionary
+bool compressWithDictionary(const std::string& input, const CompressionDictionary& dictionary, std::string& output) {
+    z_stream stream = {};
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, ZLIB_WINDOW_BITS, 9, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+    if (deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary.data.data()), static_cast<uInt>(dictionary.data.size())) != Z_OK) {
+        deflateEnd(&stream);
+        return false;
+    }
+    return deflateAll(stream, input, output);
+}
+
+// Inflate a stream made by compressWithDictionary; fails if it needs a different dictionary
+bool decompressWithDictionary(const std::string& input, const CompressionDictionary& dictionary, std::string& output) {
+    z_stream stream = {};
+    if (inflateInit2(&stream, ZLIB_WINDOW_BITS) != Z_OK) return false;
+    return inflateAll(stream, input, output, &dictionary);
+}
+
+// Plain gzip, used as the baseline in the compression benchmark
+bool gzipCompress(const std::string& input, std::string& output) {
+    z_stream stream = {};
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS, 9, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+    return deflateAll(stream, input, output);
+}
+
+// Inflate a gzip stream
+bool gzipDecompress(const std::string& input, std::string& output) {
+    z_stream stream = {};
+    if (inflateInit2(&stream, GZIP_WINDOW_BITS) != Z_OK) return false;
+    return inflateAll(stream, input, output, NULL);
+}
@@ -0,0 +1,48 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <string>
+#include <vector>
+
+// Content-Encoding token for result documents deflated against a shared dictionary
+#define DICTIONARY_CONTENT_ENCODING "deflate-dict"
+
+// Extension appended to spool files written with the dictionary
+#define COMPRESSED_SPOOL_EXTENSION ".zd"
+
+// Dictionary shared by the logger and the server for compressing result documents.
+// The id is the Adler-32 of the data, the same value zlib stores in the stream header,
+// so a receiver can pick the right dictionary from the body alone.
+struct CompressionDictionary {
+    std::string data;
+    unsigned long id;
+};
+
+// Check that a training sample is a result document (a JSON object with a Drivers array),
+// so stray files in an archive folder do not end up in the dictionary
+bool isResultDocument(const std::string& data);
+
+// Build a dictionary from sample documents: the lines repeated most across the samples
+// (keys, car, class and track strings with their indentation), most useful last so they sit
+// closest to the data in the deflate window
+CompressionDictionary trainDictionary(const std::vector<std::string>& samples, size_t maxSize);
+
+// Load a dictionary file; false if it cannot be read or is empty
+bool loadDictionary(const std::string& filename, CompressionDictionary& dictionary);
+
+// Write a dictionary file
+bool saveDictionary(const std::string& filename, const CompressionDictionary& dictionary);
+
+// zlib stream deflated with a preset dictionary
+bool compressWithDictionary(const std::string& input, const CompressionDictionary& dictionary, std::string& output);
+
+// Inflate a stream made by compressWithDictionary; fails if it needs a different dictionary
+bool decompressWithDictionary(const std::string& input, const CompressionDictionary& dictionary, std::string& output);
+
+// Plain gzip, used as the baseline in the compression benchmark
+bool gzipCompress(const std::string& input, std::string& output);
+
+// Inflate a gzip stream
+bool gzipDecompress(const std::string& input, std::string& output);
+
+#endif // COMPRESSION_H
@@ -0,0 +1,96 @@
+#include "config.h"
+#include <fstream>
+#include "logger.h"
+#include "scheduling.h"
+
+// Fill in the scheduling settings left unset (-1) with the defaults of the scheduling mode
+void resolveScheduling(ServerConfig& config) {
+    if (config.samplerPriority < 0) config.samplerPriority = SCHEDULING_PRIORITY_NORMAL;
+    if (config.backgroundPriority < 0) config.backgroundPriority = config.gameScheduling ? SCHEDULING_PRIORITY_LOW : SCHEDULING_PRIORITY_NORMAL;
+    if (config.idlePollMs < 0) config.idlePollMs = config.gameScheduling ? SAMPLER_GAME_IDLE_POLL_MS : SAMPLER_POLL_MS;
+}
+
+// Priority level of a config value; the key is left unset (mode default) if the name is unknown
+static int readPriority(const std::string& key, const std::string& value) {
+    const int level = parseSchedulingPriority(value);
+    if (level < 0) logMessage("WARNING", "Unknown " + key + " '" + value + "', expected idle, low, normal or high");
+    return level;
+}
+
+// CPU mask of a config value; any CPU if the list is malformed
+static uint64_t readCpuList(const std::string& key, const std::string& value) {
+    uint64_t mask = 0;
+    if (!parseCpuList(value, mask)) {
+        logMessage("WARNING", "Malformed " + key + " '" + value + "', expected CPU numbers and ranges like 2,3 or 4-7");
+        mask = 0;
+    }
+    return mask;
+}
+
+// Read server config from config.properties
+ServerConfig readConfig() {
+    ServerConfig config;
+    std::ifstream configFile("config.properties");
+    if (!configFile.is_open()) {
+        logMessage("ERROR", "Failed to open config.properties, using default server: example.com:3000, createJsonAtRaceStart: no, disableUpload: no");
+        resolveScheduling(config);
+        return config;
+    }
+    std::string line;
+    while (std::getline(configFile, line)) {
+        if (line.find("server=") == 0) {
+            config.server = line.substr(7);
+        } else if (line.find("port=") == 0) {
+            config.port = std::stoi(line.substr(5));
+        } else if (line.find("createJsonAtRaceStart=") == 0) {
+            config.createJsonAtRaceStart = (line.substr(22) == "yes");
+        } else if (line.find("disableUpload=") == 0) {
+            config.disableUpload = (line.substr(14) == "yes");
+        } else if (line.find("compressSpool=") == 0) {
+            config.compressSpool = (line.substr(14) == "yes");
+        } else if (line.find("compressUpload=") == 0) {
+            config.compressUpload = (line.substr(15) == "yes");
+        } else if (line.find("dictionary=") == 0) {
+            config.dictionary = line.substr(11);
+        } else if (line.find("resultFormat=") == 0) {
+            config.binaryResults = (line.substr(13) == "binary");
+        } else if (line.find("blackBoxMinutes=") == 0) {
+            config.blackBoxMinutes = std::stoi(line.substr(16));
+        } else if (line.find("blackBoxMemoryMB=") == 0) {
+            config.blackBoxMemoryMB = std::stoi(line.substr(17));
+        } else if (line.find("blackBoxCollision=") == 0) {
+            config.blackBoxCollision = std::stof(line.substr(18));
+        } else if (line.find("derivedState=") == 0) {
+            config.derivedState = (line.substr(13) != "no");
+        } else if (line.find("standings=") == 0) {
+            config.standings = (line.substr(10) != "no");
+        } else if (line.find("scheduling=") == 0) {
+            config.gameScheduling = (line.substr(11) == "game");
+        } else if (line.find("samplerPriority=") == 0) {
+            config.samplerPriority = readPriority("samplerPriority", line.substr(16));
+        } else if (line.find("backgroundPriority=") == 0) {
+            config.backgroundPriority = readPriority("backgroundPriority", line.substr(19));
+        } else if (line.find("samplerCpus=") == 0) {
+            config.samplerCpus = readCpuList("samplerCpus", line.substr(12));
+        } else if (line.find("backgroundCpus=") == 0) {
+            config.backgroundCpus = readCpuList("backgroundCpus", line.substr(15));
+        } else if (line.find("idlePollMs=") == 0) {
+            config.idlePollMs = std::stoi(line.substr(11));
+        } else if (line.find("timerResolutionMs=") == 0) {
+            config.timerResolutionMs = std::stoi(line.substr(18));
+        }
+    }
+    configFile.close();
+    resolveScheduling(config);
+    logMessage("INFO", "Server config loaded: " + config.server + ":" + std::to_string(config.port) + ", createJsonAtRaceStart: " + (config.createJsonAtRaceStart ? "yes" : "no") + ", disableUpload: " + (config.disableUpload ? "yes" : "no") +
+                       ", compressSpool: " + (config.compressSpool ? "yes" : "no") + ", compressUpload: " + (config.compressUpload ? "yes" : "no") +
+                       ", resultFormat: " + (config.binaryResults ? "binary" : "json") +
+                       ", blackBox: " + (config.blackBoxMinutes > 0 ? std::to_string(config.blackBoxMinutes) + " min / " + std::to_string(config.blackBoxMemoryMB) + " MB" : std::string("off")) +
+                       ", derivedState: " + (config.derivedState ? "yes" : "no") +
+                       ", standings: " + (config.standings ? "yes" : "no") +
+                       ", scheduling: " + (config.gameScheduling ? "game" : "normal") +
+                       " (sampler " + schedulingPriorityName(config.samplerPriority) + " on " + formatCpuList(config.samplerCpus) +
+                       ", background " + schedulingPriorityName(config.backgroundPriority) + " on " + formatCpuList(config.backgroundCpus) +
+                       ", idle poll " + std::to_string(config.idlePollMs) + " ms, timer " + std::to_string(config.timerResolutionMs) + " ms)");
+    return config;
+}
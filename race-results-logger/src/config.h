@@ -0,0 +1,38 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdint.h>
+#include <string>
+
+// Structure to hold server config; the defaults apply to keys missing from config.properties
+struct ServerConfig {
+    std::string server = "example.com";
+    int port = 3000;
+    bool createJsonAtRaceStart = false;
+    bool disableUpload = false;
+    bool compressSpool = false;                       // write spool files as .json.zd
+    bool compressUpload = false;                      // send bodies with the dictionary encoding
+    std::string dictionary = "dict/results.dict";     // dictionary shared with the server
+    bool binaryResults = false;                       // resultFormat=binary: write and send .amsr instead of JSON
+    int blackBoxMinutes = 0;                          // minutes of frames kept for incident dumps, 0 disables
+    int blackBoxMemoryMB = 32;                        // hard limit of the black box ring
+    float blackBoxCollision = 1.0f;                   // collision magnitude that triggers a dump, 0 disables
+    bool derivedState = true;                         // publish the derived-state segment for overlays and dashboards
+    bool standings = true;                            // keep season standings from the races this logger writes
+    // Scheduling keys left at -1 take the default of the scheduling mode in resolveScheduling
+    bool gameScheduling = false;                      // scheduling=game: lower background priority, sampler backs off while the game is idle
+    int samplerPriority = -1;                         // SCHEDULING_PRIORITY_* of the sampler thread
+    int backgroundPriority = -1;                      // SCHEDULING_PRIORITY_* of the analytics, black box and detection threads
+    uint64_t samplerCpus = 0;                         // CPUs the sampler thread may run on, 0 for any
+    uint64_t backgroundCpus = 0;                      // CPUs the other threads may run on, 0 for any
+    int idlePollMs = -1;                              // sampler poll interval once the game writes no frames
+    int timerResolutionMs = 1;                        // timer resolution held while frames arrive, 0 leaves the system default
+};
+
+// Read server config from config.properties
+ServerConfig readConfig();
+
+// Fill in the scheduling settings left unset (-1) with the defaults of the scheduling mode
+void resolveScheduling(ServerConfig& config);
+
+#endif // CONFIG_H
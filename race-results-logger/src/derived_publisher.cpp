@@ -0,0 +1,149 @@
+#include "derived_publisher.h"
+#include <string.h>
+#include <atomic>
+#include "asset_ids.h"
+#include "results.h"
+
+// Set up a freshly mapped segment: header filled in, both sections empty
+void initDerivedState(DerivedState* segment) {
+    memset(segment, 0, sizeof(DerivedState));
+    segment->viewed.slot = -1;
+    segment->version = DERIVED_STATE_VERSION;
+    segment->size = sizeof(DerivedState);
+    // Readers check the magic first, so it goes in last
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->magic = DERIVED_STATE_MAGIC;
+}
+
+// Copy a name into a fixed, always terminated buffer
+static void copyName(char* target, const char* name) {
+    strncpy(target, name, DERIVED_NAME_LENGTH - 1);
+    target[DERIVED_NAME_LENGTH - 1] = '\0';
+}
+
+// Where the session stands, from the session state and the race-state columns
+static uint32_t sessionPhase(const SharedMemory* sharedData, const ParticipantTable& participants) {
+    if (sharedData->mSessionState == SESSION_INVALID || participants.count == 0) return DERIVED_PHASE_IDLE;
+    if (sharedData->mSessionState != SESSION_RACE) return DERIVED_PHASE_SESSION;
+    if (allParticipantsFinished(participants)) return DERIVED_PHASE_RACE_FINISHED;
+    int finished = 0;
+    int racing = 0;
+    for (int i = 0; i < participants.count; ++i) {
+        finished += participants.active[i] & (participants.raceState[i] == RACESTATE_FINISHED);
+        racing += participants.active[i] & (participants.raceState[i] == RACESTATE_RACING);
+    }
+    if (finished > 0) return DERIVED_PHASE_RACE_FINISHING;
+    return racing > 0 ? DERIVED_PHASE_RACING : DERIVED_PHASE_RACE_PENDING;
+}
+
+// Race position for ordering, cars without one after everybody else
+static uint32_t orderPosition(const ParticipantTable& participants, int i) {
+    return participants.racePosition[i] == 0 ? UINT32_MAX : participants.racePosition[i];
+}
+
+// Build the field section from the detection thread's view of one snapshot taken at 'now'
+void buildDerivedField(DerivedField& field, const SharedMemory* sharedData, const ParticipantTable& participants,
+                       const FieldGaps& gaps, double now) {
+    field.time = now;
+    field.gameSequence = sharedData->mSequenceNumber;
+    field.sessionState = sharedData->mSessionState;
+    field.phase = sessionPhase(sharedData, participants);
+    const std::string trackName = getTrackName(sharedData);
+    field.trackId = trackAssetId(trackName, getTrackLayout(sharedData));
+    field.locationId = locationAssetId(trackName);
+    field.trackLength = participants.trackLength;
+
+    // Active slots by race position, unplaced cars last; insertion sort, the field is at most 64 cars
+    int order[STORED_PARTICIPANTS_MAX];
+    int count = 0;
+    for (int i = 0; i < participants.count; ++i) {
+        if (!participants.active[i]) continue;
+        const uint32_t position = orderPosition(participants, i);
+        int k = count++;
+        while (k > 0 && orderPosition(participants, order[k - 1]) > position) {
+            order[k] = order[k - 1];
+            --k;
+        }
+        order[k] = i;
+    }
+
+    field.numCars = static_cast<uint32_t>(count);
+    for (int j = 0; j < count; ++j) {
+        const int i = order[j];
+        DerivedCar& car = field.cars[j];
+        car.slot = static_cast<uint32_t>(i);
+        car.position = participants.racePosition[i];
+        car.lapsCompleted = participants.lapsCompleted[i];
+        car.lapsDown = gaps.lapsDown[i];
+        car.gapToLeader = gaps.gapToLeader[i];
+        car.interval = gaps.interval[i];
+        car.raceDistance = participants.raceDistance[i];
+        car.lastLapTime = participants.lastLapTime[i];
+        car.fastestLapTime = participants.fastestLapTime[i];
+        car.raceState = participants.raceState[i];
+        car.pitMode = participants.pitMode[i];
+        car.carId = participants.carId[i];
+        car.carClassId = participants.carClassId[i];
+        copyName(car.driverName, participants.driverName[i]);
+    }
+    memset(field.cars + count, 0, (DERIVED_CARS_MAX - count) * sizeof(DerivedCar));
+}
+
+// Share of a lap spent in one state, 0 for a lap without time
+static float lapFraction(float seconds, float duration) {
+    return duration > 0.0f ? seconds / duration : 0.0f;
+}
+
+// Build the viewed-car section from the analytics of the viewed car at 'now'
+void buildDerivedViewedCar(DerivedViewedCar& viewed, const DrivingStats& stats, const LapDelta& lapDelta, double now) {
+    viewed.time = now;
+    viewed.slot = stats.participantIndex;
+    viewed.hasDelta = lapDelta.hasDelta;
+    viewed.delta = lapDelta.hasDelta ? lapDelta.delta : 0.0f;
+    viewed.referenceLapTime = lapDelta.reference.times != NULL ? lapDelta.reference.lapTime : 0.0f;
+    viewed.lastLapTime = lapDelta.lastLapTime;
+    viewed.lastLapHasDelta = lapDelta.lastLapHasDelta;
+    viewed.lastLapDelta = lapDelta.lastLapDelta;
+    copyName(viewed.driverName, stats.driverName.c_str());
+
+    const int first = stats.historyCount > DERIVED_LAPS_MAX ? stats.historyCount - DERIVED_LAPS_MAX : 0;
+    viewed.numLaps = static_cast<uint32_t>(stats.historyCount - first);
+    for (int l = first; l < stats.historyCount; ++l) {
+        const LapStats& lap = lapHistoryAt(stats, l);
+        DerivedLap& summary = viewed.laps[l - first];
+        summary.lap = lap.lap;
+        summary.lapTime = lap.lapTime;
+        summary.invalidated = lap.invalidated;
+        summary.maxSpeed = lap.total.maxSpeed;
+        summary.fullThrottle = lapFraction(lap.total.fullThrottleTime, lap.total.duration);
+        summary.braking = lapFraction(lap.total.brakeTime, lap.total.duration);
+        summary.coasting = lapFraction(lap.total.coastTime, lap.total.duration);
+        summary.peakCombinedG = lap.total.peakCombinedG;
+    }
+    memset(viewed.laps + viewed.numLaps, 0, (DERIVED_LAPS_MAX - viewed.numLaps) * sizeof(DerivedLap));
+}
+
+// Seqlock write: odd sequence, section, even sequence, each step ordered before the next
+template <typename Section>
+static void publishSection(Section* shared, Section& section) {
+    volatile uint32_t* sequence = &shared->sequence;
+    const uint32_t even = *sequence & ~1u;
+    *sequence = even + 1;
+    std::atomic_thread_fence(std::memory_order_release);
+    section.sequence = even + 1;
+    ++section.updates;
+    memcpy(static_cast<void*>(shared), &section, sizeof(Section));
+    std::atomic_thread_fence(std::memory_order_release);
+    *sequence = even + 2;
+    section.sequence = even + 2;
+}
+
+// Publish a built field section; it is kept as the writer's copy, with its sequence and update count advanced
+void publishDerivedField(DerivedState* segment, DerivedField& field) {
+    publishSection(&segment->field, field);
+}
+
+// Publish a built viewed-car section; it is kept as the writer's copy, with its sequence and update count advanced
+void publishDerivedViewedCar(DerivedState* segment, DerivedViewedCar& viewed) {
+    publishSection(&segment->viewed, viewed);
+}
@@ -0,0 +1,31 @@
+#ifndef DERIVED_PUBLISHER_H
+#define DERIVED_PUBLISHER_H
+
+#include "SharedMemory.h"
+#include "derived_state.h"
+#include "driving_stats.h"
+#include "gap_tracker.h"
+#include "participant_table.h"
+#include "reference_lap.h"
+
+// Writer side of the derived-state segment described in derived_state.h. Sections are built
+// into a private copy and then published under their seqlock, so a reader never waits on the
+// work of deriving them.
+
+// Set up a freshly mapped segment: header filled in, both sections empty
+void initDerivedState(DerivedState* segment);
+
+// Build the field section from the detection thread's view of one snapshot taken at 'now'
+void buildDerivedField(DerivedField& field, const SharedMemory* sharedData, const ParticipantTable& participants,
+                       const FieldGaps& gaps, double now);
+
+// Build the viewed-car section from the analytics of the viewed car at 'now'
+void buildDerivedViewedCar(DerivedViewedCar& viewed, const DrivingStats& stats, const LapDelta& lapDelta, double now);
+
+// Publish a built field section; it is kept as the writer's copy, with its sequence and update count advanced
+void publishDerivedField(DerivedState* segment, DerivedField& field);
+
+// Publish a built viewed-car section; it is kept as the writer's copy, with its sequence and update count advanced
+void publishDerivedViewedCar(DerivedState* segment, DerivedViewedCar& viewed);
+
+#endif // DERIVED_PUBLISHER_H
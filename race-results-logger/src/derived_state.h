@@ -0,0 +1,196 @@
+#ifndef DERIVED_STATE_H
+#define DERIVED_STATE_H
+
+/*
+ * Derived state the logger republishes for overlays, stream tools and dashboards, so they can
+ * read a few KB of precomputed standings, gaps and lap summaries instead of each copying the
+ * ~20 KB $pcars2$ block and recomputing them. Plain C with no dependencies; copy this header
+ * into a reader, map the segment read-only and take copies with readDerivedField() and
+ * readDerivedViewedCar():
+ *
+ *   Win32: OpenFileMappingA(FILE_MAP_READ, FALSE, DERIVED_STATE_NAME), MapViewOfFile(...)
+ *   POSIX: shm_open("/" DERIVED_STATE_NAME, O_RDONLY, 0), mmap(..., PROT_READ, MAP_SHARED, ...)
+ *
+ * The segment has two sections with their own seqlock: the field, written by the logger's
+ * detection thread every 500 ms, and the viewed car, written on every game frame. A sequence
+ * number is odd while its section is being written; a reader copies the section and retries
+ * if the number was odd or changed meanwhile.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#define DERIVED_STATE_NAME "$ams2derived$"
+#define DERIVED_STATE_MAGIC 0x44534D41u /* "AMSD" */
+
+/* Bumped whenever the layout below changes */
+enum
+{
+  DERIVED_STATE_VERSION = 1
+};
+
+/* Cars in the field section, same as the game's STORED_PARTICIPANTS_MAX */
+enum
+{
+  DERIVED_CARS_MAX = 64
+};
+
+/* Bytes per name, including the terminator */
+enum
+{
+  DERIVED_NAME_LENGTH = 64
+};
+
+/* Completed laps of the viewed car summarised in its section, oldest first */
+enum
+{
+  DERIVED_LAPS_MAX = 8
+};
+
+/* Copies tried before a read gives up on a section the writer keeps changing */
+enum
+{
+  DERIVED_READ_ATTEMPTS = 64
+};
+
+/* Where the session stands (to be used with 'phase') */
+enum DerivedSessionPhase
+{
+  DERIVED_PHASE_IDLE = 0,            /* no session, e.g. in the menus */
+  DERIVED_PHASE_SESSION,             /* practice, qualifying or another session without a race start */
+  DERIVED_PHASE_RACE_PENDING,        /* race session, nobody racing yet (grid, formation) */
+  DERIVED_PHASE_RACING,
+  DERIVED_PHASE_RACE_FINISHING,      /* at least one car has taken the flag */
+  DERIVED_PHASE_RACE_FINISHED        /* every active car finished, retired, DNF'd or was disqualified */
+};
+
+/* Result of readDerivedField() and readDerivedViewedCar() */
+enum DerivedReadResult
+{
+  DERIVED_READ_OK = 0,
+  DERIVED_READ_BUSY,                 /* the writer kept the section busy for DERIVED_READ_ATTEMPTS copies */
+  DERIVED_READ_MISMATCH              /* not a segment of this version (yet), check the header */
+};
+
+/* One car of the classification */
+typedef struct
+{
+  uint32_t slot;                     /* index into the $pcars2$ participant arrays */
+  uint32_t position;                 /* [ RANGE = 1->... ]   [ UNSET = 0 ] */
+  uint32_t lapsCompleted;
+  int32_t lapsDown;
+  float gapToLeader;                 /* [ UNITS = seconds ]   [ UNSET = -1.0f ] */
+  float interval;                    /* to the car ahead [ UNITS = seconds ]   [ UNSET = -1.0f ] */
+  float raceDistance;                /* [ UNITS = Metres ] since the start line */
+  float lastLapTime;                 /* [ UNITS = seconds ]   [ UNSET = -1.0f ] */
+  float fastestLapTime;              /* [ UNITS = seconds ]   [ UNSET = -1.0f ] */
+  uint32_t raceState;                /* [ enum (Type#3) Race State ] */
+  uint32_t pitMode;                  /* [ enum (Type#7) Pit Mode ] */
+  uint32_t carId;                    /* asset ID of the car name   [ UNSET = 0 ] */
+  uint32_t carClassId;               /* asset ID of the car class name   [ UNSET = 0 ] */
+  char driverName[DERIVED_NAME_LENGTH];
+} DerivedCar;
+
+/* Field section: the classification with live gaps */
+typedef struct
+{
+  uint32_t sequence;                 /* odd while being written */
+  uint32_t updates;
+  double time;                       /* logger clock [ UNITS = seconds ] */
+  uint32_t gameSequence;             /* mSequenceNumber of the game frame this was derived from */
+  uint32_t sessionState;             /* [ enum (Type#2) Session state ] */
+  uint32_t phase;                    /* [ enum DerivedSessionPhase ] */
+  uint32_t trackId;                  /* asset ID of location + layout   [ UNSET = 0 ] */
+  uint32_t locationId;               /* [ UNSET = 0 ] */
+  float trackLength;                 /* [ UNITS = Metres ] */
+  uint32_t numCars;
+  uint32_t reserved;
+  DerivedCar cars[DERIVED_CARS_MAX]; /* by race position, cars without one last */
+} DerivedField;
+
+/* Summary of one completed lap of the viewed car */
+typedef struct
+{
+  int32_t lap;
+  float lapTime;                     /* [ UNITS = seconds ]   [ UNSET = -1.0f ] */
+  uint32_t invalidated;
+  float maxSpeed;                    /* [ UNITS = Metres per-second ] */
+  float fullThrottle;                /* fraction of the lap flat out */
+  float braking;                     /* fraction of the lap on the brake */
+  float coasting;                    /* fraction of the lap on neither pedal */
+  float peakCombinedG;
+} DerivedLap;
+
+/* Viewed-car section: live delta to the reference lap and the last laps */
+typedef struct
+{
+  uint32_t sequence;                 /* odd while being written */
+  uint32_t updates;
+  double time;                       /* logger clock [ UNITS = seconds ] */
+  int32_t slot;                      /* [ UNSET = -1 ] */
+  uint32_t hasDelta;
+  float delta;                       /* to the reference lap, positive when slower [ UNITS = seconds ] */
+  float referenceLapTime;            /* [ UNITS = seconds ]   [ UNSET = 0.0f ] */
+  float lastLapTime;                 /* [ UNITS = seconds ]   [ UNSET = -1.0f ] */
+  uint32_t lastLapHasDelta;
+  float lastLapDelta;                /* [ UNITS = seconds ] */
+  uint32_t numLaps;
+  DerivedLap laps[DERIVED_LAPS_MAX];
+  char driverName[DERIVED_NAME_LENGTH];
+} DerivedViewedCar;
+
+/* The whole segment */
+typedef struct
+{
+  uint32_t magic;                    /* DERIVED_STATE_MAGIC once the logger has set the segment up */
+  uint32_t version;                  /* DERIVED_STATE_VERSION */
+  uint32_t size;                     /* sizeof(DerivedState) */
+  uint32_t reserved;
+  DerivedField field;
+  DerivedViewedCar viewed;
+} DerivedState;
+
+/* Orders the sequence loads around the section copy */
+#if defined(__cplusplus)
+#include <atomic>
+#define DERIVED_STATE_FENCE() std::atomic_thread_fence(std::memory_order_acquire)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define DERIVED_STATE_FENCE() _ReadWriteBarrier()
+#else
+#define DERIVED_STATE_FENCE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+
+/* Copy one seqlocked section; sequence is the section's first field */
+static inline int readDerivedSection(const volatile DerivedState* shared, const volatile uint32_t* sequence, void* copy, size_t size)
+{
+  int attempt;
+  if (shared->magic != DERIVED_STATE_MAGIC || shared->version != DERIVED_STATE_VERSION || shared->size != sizeof(DerivedState))
+    return DERIVED_READ_MISMATCH;
+  for (attempt = 0; attempt < DERIVED_READ_ATTEMPTS; ++attempt)
+  {
+    uint32_t before = *sequence;
+    if (before & 1u)
+      continue;
+    DERIVED_STATE_FENCE();
+    memcpy(copy, (const void*)sequence, size);
+    DERIVED_STATE_FENCE();
+    if (*sequence == before)
+      return DERIVED_READ_OK;
+  }
+  return DERIVED_READ_BUSY;
+}
+
+/* Take a consistent copy of the field section */
+static inline int readDerivedField(const volatile DerivedState* shared, DerivedField* field)
+{
+  return readDerivedSection(shared, &shared->field.sequence, field, sizeof(DerivedField));
+}
+
+/* Take a consistent copy of the viewed-car section */
+static inline int readDerivedViewedCar(const volatile DerivedState* shared, DerivedViewedCar* viewed)
+{
+  return readDerivedSection(shared, &shared->viewed.sequence, viewed, sizeof(DerivedViewedCar));
+}
+
+#endif /* DERIVED_STATE_H */
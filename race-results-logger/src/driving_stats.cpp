@@ -0,0 +1,285 @@
+#include "driving_stats.h"
+#include <cmath>
+
+// Pedal position counted as applied; below it the pedal is treated as released
+static const float PEDAL_APPLIED = 0.05f;
+
+// Throttle position counted as flat out
+static const float THROTTLE_FULL = 0.98f;
+
+// Brake pressure that marks a braking point, and the release level that re-arms it
+static const float BRAKE_ON = 0.10f;
+static const float BRAKE_OFF = 0.05f;
+
+// Longest frame step counted towards durations; longer gaps are pauses or reconnects
+static const float MAX_FRAME_STEP = 0.1f;
+
+static const float STANDARD_GRAVITY = 9.80665f;
+
+// Empty sector aggregates
+static void resetSectorStats(SectorStats& sector) {
+    sector.frames = 0;
+    sector.duration = 0.0f;
+    sector.minSpeed = 0.0f;
+    sector.maxSpeed = 0.0f;
+    sector.maxRpm = 0.0f;
+    sector.throttleTime = 0.0f;
+    sector.fullThrottleTime = 0.0f;
+    sector.brakeTime = 0.0f;
+    sector.coastTime = 0.0f;
+    sector.peakLateralG = 0.0f;
+    sector.peakLongitudinalG = 0.0f;
+    sector.peakCombinedG = 0.0f;
+    sector.upshifts = 0;
+    sector.downshifts = 0;
+}
+
+// Start a new lap
+static void resetLapStats(LapStats& lap, int lapNumber) {
+    lap.lap = lapNumber;
+    lap.complete = false;
+    lap.invalidated = false;
+    lap.lapTime = -1.0f;
+    for (int s = 0; s < DRIVING_SECTORS_MAX; ++s) resetSectorStats(lap.sectors[s]);
+    resetSectorStats(lap.total);
+    lap.numBrakingPoints = 0;
+}
+
+// Add one set of aggregates to another
+static void mergeSectorStats(SectorStats& into, const SectorStats& from) {
+    if (from.frames == 0) return;
+    if (into.frames == 0) {
+        into.minSpeed = from.minSpeed;
+        into.maxSpeed = from.maxSpeed;
+    } else {
+        into.minSpeed = std::fmin(into.minSpeed, from.minSpeed);
+        into.maxSpeed = std::fmax(into.maxSpeed, from.maxSpeed);
+    }
+    into.frames += from.frames;
+    into.duration += from.duration;
+    into.maxRpm = std::fmax(into.maxRpm, from.maxRpm);
+    into.throttleTime += from.throttleTime;
+    into.fullThrottleTime += from.fullThrottleTime;
+    into.brakeTime += from.brakeTime;
+    into.coastTime += from.coastTime;
+    into.peakLateralG = std::fmax(into.peakLateralG, from.peakLateralG);
+    into.peakLongitudinalG = std::fmax(into.peakLongitudinalG, from.peakLongitudinalG);
+    into.peakCombinedG = std::fmax(into.peakCombinedG, from.peakCombinedG);
+    into.upshifts += from.upshifts;
+    into.downshifts += from.downshifts;
+}
+
+// Forget all laps, e.g. when a new session starts
+void resetDrivingStats(DrivingStats& stats) {
+    stats.driverName.clear();
+    stats.participantIndex = -1;
+    resetLapStats(stats.current, 0);
+    stats.currentSector = 0;
+    stats.batch.count = 0;
+    stats.hasFrame = false;
+    stats.lastFrameTime = 0.0;
+    stats.lastSequence = 0;
+    stats.lastCurrentTime = 0.0f;
+    stats.lastGear = 0;
+    stats.braking = false;
+    stats.historyStart = 0;
+    stats.historyCount = 0;
+    stats.framesSeen = 0;
+    stats.framesMissed = 0;
+}
+
+// Fold buffered frames into the current sector. The reductions run over fixed-width lanes
+// with no branches, so the compiler turns them into packed min/max/add; gear changes and
+// braking points depend on the previous frame and go through a short scalar scan.
+void flushDrivingStats(DrivingStats& stats) {
+    DrivingFrameBatch& batch = stats.batch;
+    const int count = batch.count;
+    if (count == 0) return;
+
+    // Pad to whole lanes with frames that cannot change any aggregate
+    int padded = (count + DRIVING_STATS_LANES - 1) / DRIVING_STATS_LANES * DRIVING_STATS_LANES;
+    for (int i = count; i < padded; ++i) {
+        batch.speed[i] = batch.speed[0];
+        batch.rpm[i] = 0.0f;
+        batch.throttle[i] = 0.0f;
+        batch.brake[i] = 0.0f;
+        batch.lateral[i] = 0.0f;
+        batch.longitudinal[i] = 0.0f;
+        batch.dt[i] = 0.0f;
+    }
+
+    float minSpeed[DRIVING_STATS_LANES], maxSpeed[DRIVING_STATS_LANES], maxRpm[DRIVING_STATS_LANES];
+    float throttleTime[DRIVING_STATS_LANES], fullThrottleTime[DRIVING_STATS_LANES];
+    float brakeTime[DRIVING_STATS_LANES], coastTime[DRIVING_STATS_LANES], duration[DRIVING_STATS_LANES];
+    float peakLateral[DRIVING_STATS_LANES], peakLongitudinal[DRIVING_STATS_LANES], peakCombinedSquared[DRIVING_STATS_LANES];
+    for (int k = 0; k < DRIVING_STATS_LANES; ++k) {
+        minSpeed[k] = batch.speed[0];
+        maxSpeed[k] = batch.speed[0];
+        maxRpm[k] = 0.0f;
+        throttleTime[k] = 0.0f;
+        fullThrottleTime[k] = 0.0f;
+        brakeTime[k] = 0.0f;
+        coastTime[k] = 0.0f;
+        duration[k] = 0.0f;
+        peakLateral[k] = 0.0f;
+        peakLongitudinal[k] = 0.0f;
+        peakCombinedSquared[k] = 0.0f;
+    }
+
+    for (int base = 0; base < padded; base += DRIVING_STATS_LANES) {
+        for (int k = 0; k < DRIVING_STATS_LANES; ++k) {
+            const int i = base + k;
+            const float dt = batch.dt[i];
+            const float speed = batch.speed[i];
+            const float throttle = batch.throttle[i];
+            const float brake = batch.brake[i];
+            const float lateral = batch.lateral[i] < 0.0f ? -batch.lateral[i] : batch.lateral[i];
+            const float longitudinal = batch.longitudinal[i] < 0.0f ? -batch.longitudinal[i] : batch.longitudinal[i];
+            const float combinedSquared = lateral * lateral + longitudinal * longitudinal;
+
+            minSpeed[k] = speed < minSpeed[k] ? speed : minSpeed[k];
+            maxSpeed[k] = speed > maxSpeed[k] ? speed : maxSpeed[k];
+            maxRpm[k] = batch.rpm[i] > maxRpm[k] ? batch.rpm[i] : maxRpm[k];
+            duration[k] += dt;
+            throttleTime[k] += throttle > PEDAL_APPLIED ? dt : 0.0f;
+            fullThrottleTime[k] += throttle > THROTTLE_FULL ? dt : 0.0f;
+            brakeTime[k] += brake > PEDAL_APPLIED ? dt : 0.0f;
+            coastTime[k] += (throttle <= PEDAL_APPLIED) & (brake <= PEDAL_APPLIED) ? dt : 0.0f;
+            peakLateral[k] = lateral > peakLateral[k] ? lateral : peakLateral[k];
+            peakLongitudinal[k] = longitudinal > peakLongitudinal[k] ? longitudinal : peakLongitudinal[k];
+            peakCombinedSquared[k] = combinedSquared > peakCombinedSquared[k] ? combinedSquared : peakCombinedSquared[k];
+        }
+    }
+
+    SectorStats part;
+    resetSectorStats(part);
+    part.frames = count;
+    part.minSpeed = minSpeed[0];
+    part.maxSpeed = maxSpeed[0];
+    for (int k = 0; k < DRIVING_STATS_LANES; ++k) {
+        part.minSpeed = std::fmin(part.minSpeed, minSpeed[k]);
+        part.maxSpeed = std::fmax(part.maxSpeed, maxSpeed[k]);
+        part.maxRpm = std::fmax(part.maxRpm, maxRpm[k]);
+        part.duration += duration[k];
+        part.throttleTime += throttleTime[k];
+        part.fullThrottleTime += fullThrottleTime[k];
+        part.brakeTime += brakeTime[k];
+        part.coastTime += coastTime[k];
+        part.peakLateralG = std::fmax(part.peakLateralG, peakLateral[k] / STANDARD_GRAVITY);
+        part.peakLongitudinalG = std::fmax(part.peakLongitudinalG, peakLongitudinal[k] / STANDARD_GRAVITY);
+        part.peakCombinedG = std::fmax(part.peakCombinedG, std::sqrt(peakCombinedSquared[k]) / STANDARD_GRAVITY);
+    }
+
+    // Shifts between engaged gears (an H-pattern change through neutral still counts once)
+    // and braking points where the pedal crosses BRAKE_ON after being released
+    LapStats& lap = stats.current;
+    for (int i = 0; i < count; ++i) {
+        const int gear = batch.gear[i];
+        if (gear != 0) {
+            if (stats.lastGear != 0 && gear > stats.lastGear) part.upshifts++;
+            if (stats.lastGear != 0 && gear < stats.lastGear) part.downshifts++;
+            stats.lastGear = gear;
+        }
+        if (!stats.braking && batch.brake[i] > BRAKE_ON) {
+            stats.braking = true;
+            if (lap.numBrakingPoints < BRAKING_POINTS_MAX) lap.brakingPoints[lap.numBrakingPoints++] = batch.lapDistance[i];
+        } else if (stats.braking && batch.brake[i] < BRAKE_OFF) {
+            stats.braking = false;
+        }
+    }
+
+    mergeSectorStats(lap.sectors[stats.currentSector], part);
+    batch.count = 0;
+}
+
+// The lap in progress with its total so far; call flushDrivingStats first to include buffered frames
+LapStats currentLapStats(const DrivingStats& stats) {
+    LapStats lap = stats.current;
+    resetSectorStats(lap.total);
+    for (int s = 0; s < DRIVING_SECTORS_MAX; ++s) mergeSectorStats(lap.total, lap.sectors[s]);
+    return lap;
+}
+
+// Close the current lap and move it into the history ring
+static void finishLap(DrivingStats& stats, float lapTime) {
+    LapStats& lap = stats.current;
+    lap = currentLapStats(stats);
+    if (lap.total.frames == 0) return;
+    lap.complete = true;
+    lap.lapTime = lapTime;
+
+    int slot = (stats.historyStart + stats.historyCount) % LAP_HISTORY_MAX;
+    if (stats.historyCount == LAP_HISTORY_MAX) {
+        stats.historyStart = (stats.historyStart + 1) % LAP_HISTORY_MAX;
+    } else {
+        stats.historyCount++;
+    }
+    stats.history[slot] = lap;
+}
+
+// Feed one game frame taken at 'now' (seconds on a monotonic clock)
+void updateDrivingStats(DrivingStats& stats, const SharedMemory* sharedData, double now) {
+    const int viewed = sharedData->mViewedParticipantIndex;
+    if (viewed < 0 || viewed >= sharedData->mNumParticipants || viewed >= STORED_PARTICIPANTS_MAX) return;
+    const ParticipantInfo& info = sharedData->mParticipantInfo[viewed];
+    if (!info.mIsActive || info.mCurrentLap == 0) return;
+
+    // The player-car block follows the viewed car, so another car means another history
+    if (viewed != stats.participantIndex || stats.driverName != info.mName) {
+        resetDrivingStats(stats);
+        stats.participantIndex = viewed;
+        stats.driverName = info.mName;
+    }
+
+    // The game bumps the sequence number by two per update, so a bigger step means missed frames
+    const unsigned int sequence = sharedData->mSequenceNumber;
+    if (stats.hasFrame && sequence > stats.lastSequence + 2) {
+        stats.framesMissed += (sequence - stats.lastSequence) / 2 - 1;
+    }
+    stats.framesSeen++;
+
+    float dt = stats.hasFrame ? static_cast<float>(now - stats.lastFrameTime) : 0.0f;
+    if (dt < 0.0f || dt > MAX_FRAME_STEP) dt = 0.0f;
+
+    const int lapNumber = static_cast<int>(info.mCurrentLap);
+    int sector = info.mCurrentSector;
+    if (sector < 0 || sector >= DRIVING_SECTORS_MAX) sector = stats.currentSector;
+
+    if (lapNumber != stats.current.lap) {
+        flushDrivingStats(stats);
+        if (stats.current.lap > 0 && lapNumber == stats.current.lap + 1) {
+            // The game's last lap time can trail the rollover by a frame; use the running time then
+            const float lastLap = sharedData->mLastLapTime;
+            finishLap(stats, lastLap > 0.0f && std::fabs(lastLap - stats.lastCurrentTime) < 1.0f ? lastLap : stats.lastCurrentTime);
+        }
+        resetLapStats(stats.current, lapNumber);
+        stats.currentSector = sector;
+    } else if (sector != stats.currentSector) {
+        flushDrivingStats(stats);
+        stats.currentSector = sector;
+    }
+    if (sharedData->mLapInvalidated) stats.current.invalidated = true;
+
+    DrivingFrameBatch& batch = stats.batch;
+    const int i = batch.count++;
+    batch.speed[i] = sharedData->mSpeed;
+    batch.rpm[i] = sharedData->mRpm;
+    batch.throttle[i] = sharedData->mThrottle;
+    batch.brake[i] = sharedData->mBrake;
+    batch.lateral[i] = sharedData->mLocalAcceleration[VEC_X];
+    batch.longitudinal[i] = sharedData->mLocalAcceleration[VEC_Z];
+    batch.dt[i] = dt;
+    batch.lapDistance[i] = info.mCurrentLapDistance;
+    batch.gear[i] = sharedData->mGear;
+    if (batch.count == DRIVING_STATS_BATCH) flushDrivingStats(stats);
+
+    stats.hasFrame = true;
+    stats.lastFrameTime = now;
+    stats.lastSequence = sequence;
+    stats.lastCurrentTime = sharedData->mCurrentTime;
+}
+
+// Completed lap 'index' of the history, oldest first
+const LapStats& lapHistoryAt(const DrivingStats& stats, int index) {
+    return stats.history[(stats.historyStart + index) % LAP_HISTORY_MAX];
+}
@@ -0,0 +1,121 @@
+#ifndef DRIVING_STATS_H
+#define DRIVING_STATS_H
+
+#include <string>
+#include "SharedMemory.h"
+
+// Frames buffered before they are folded into the sector aggregates in one pass
+enum
+{
+  DRIVING_STATS_BATCH = 32
+};
+
+// Width of the per-lane partial aggregates in the batch update; a multiple of the SIMD width
+enum
+{
+  DRIVING_STATS_LANES = 8
+};
+
+// Completed laps kept for the lap history; the oldest is dropped when it is full
+enum
+{
+  LAP_HISTORY_MAX = 64
+};
+
+// Braking points recorded per lap
+enum
+{
+  BRAKING_POINTS_MAX = 32
+};
+
+// Sectors per lap
+enum
+{
+  DRIVING_SECTORS_MAX = 3
+};
+
+// Driver-input and dynamics aggregates over one sector or one lap
+struct SectorStats {
+    int frames;
+    float duration;                                   // [ UNITS = seconds ]
+    float minSpeed;                                   // [ UNITS = Metres per-second ]
+    float maxSpeed;                                   // [ UNITS = Metres per-second ]
+    float maxRpm;
+    float throttleTime;                               // throttle applied [ UNITS = seconds ]
+    float fullThrottleTime;                           // throttle flat out [ UNITS = seconds ]
+    float brakeTime;                                  // [ UNITS = seconds ]
+    float coastTime;                                  // neither pedal applied [ UNITS = seconds ]
+    float peakLateralG;
+    float peakLongitudinalG;
+    float peakCombinedG;
+    int upshifts;
+    int downshifts;
+};
+
+// One lap of the viewed car: sector aggregates, their total and the braking points by lap distance
+struct LapStats {
+    int lap;
+    bool complete;
+    bool invalidated;
+    float lapTime;                                    // [ UNITS = seconds ]   [ UNSET = -1.0f ]
+    SectorStats sectors[DRIVING_SECTORS_MAX];
+    SectorStats total;
+    float brakingPoints[BRAKING_POINTS_MAX];          // [ UNITS = Metres ]
+    int numBrakingPoints;
+};
+
+// Frames waiting for the batch update, one array per channel
+struct DrivingFrameBatch {
+    alignas(32) float speed[DRIVING_STATS_BATCH];
+    alignas(32) float rpm[DRIVING_STATS_BATCH];
+    alignas(32) float throttle[DRIVING_STATS_BATCH];
+    alignas(32) float brake[DRIVING_STATS_BATCH];
+    alignas(32) float lateral[DRIVING_STATS_BATCH];
+    alignas(32) float longitudinal[DRIVING_STATS_BATCH];
+    alignas(32) float dt[DRIVING_STATS_BATCH];
+    float lapDistance[DRIVING_STATS_BATCH];
+    int gear[DRIVING_STATS_BATCH];
+    int count;
+};
+
+// Streaming analytics of the viewed car's inputs, fed every game frame.
+// Everything is fixed-size, so memory stays the same however long the session runs.
+struct DrivingStats {
+    std::string driverName;
+    int participantIndex;                             // [ UNSET = -1 ]
+    LapStats current;
+    int currentSector;
+    DrivingFrameBatch batch;
+
+    // State carried between frames for the event scans
+    bool hasFrame;
+    double lastFrameTime;
+    unsigned int lastSequence;
+    float lastCurrentTime;
+    int lastGear;                                     // last gear other than neutral
+    bool braking;
+
+    LapStats history[LAP_HISTORY_MAX];                // ring, oldest at historyStart
+    int historyStart;
+    int historyCount;
+
+    unsigned long long framesSeen;
+    unsigned long long framesMissed;                  // game updates that happened between two polls
+};
+
+// Forget all laps, e.g. when a new session starts
+void resetDrivingStats(DrivingStats& stats);
+
+// Feed one game frame taken at 'now' (seconds on a monotonic clock)
+void updateDrivingStats(DrivingStats& stats, const SharedMemory* sharedData, double now);
+
+// Fold buffered frames into the current lap, e.g. before it is written out
+void flushDrivingStats(DrivingStats& stats);
+
+// The lap in progress with its total so far; call flushDrivingStats first to include buffered frames
+LapStats currentLapStats(const DrivingStats& stats);
+
+// Completed lap 'index' of the history, oldest first
+const LapStats& lapHistoryAt(const DrivingStats& stats, int index);
+
+#endif // DRIVING_STATS_H
@@ -0,0 +1,194 @@
+#include "gap_tracker.h"
+
+// Largest plausible forward step between two samples, as a fraction of the lap.
+// Anything bigger (teleport to pits, restart) drops the car's previous sample.
+static const float MAX_STEP_FRACTION = 0.25f;
+
+// Clear all crossing tables, e.g. when a new race session starts
+void resetGapTracker(GapTracker& tracker) {
+    tracker.trackLength = 0.0f;
+    tracker.checkpointSpacing = 0.0f;
+    tracker.numCheckpoints = GAP_CHECKPOINTS_MAX;
+    tracker.numParticipants = 0;
+    tracker.hasSample = false;
+    tracker.lastSampleTime = 0.0;
+    tracker.numOrdered = 0;
+    for (int i = 0; i < IDENTITY_MAX; ++i) {
+        tracker.tracked[i] = false;
+        tracker.frozen[i] = false;
+        tracker.stint[i] = 0;
+        tracker.slot[i] = -1;
+        tracker.raceDistance[i] = 0.0f;
+        tracker.lastCheckpoint[i] = -1;
+        tracker.order[i] = i;
+        for (int c = 0; c < GAP_CHECKPOINTS_MAX; ++c) {
+            tracker.crossingTime[i][c] = 0.0;
+            tracker.crossingIndex[i][c] = -1;
+        }
+    }
+    for (int i = 0; i < STORED_PARTICIPANTS_MAX; ++i) {
+        tracker.gaps.gapToLeader[i] = -1.0f;
+        tracker.gaps.interval[i] = -1.0f;
+        tracker.gaps.lapsDown[i] = 0;
+    }
+}
+
+// Timing-screen order: furthest checkpoint first, ties broken by who crossed it first
+static bool isAhead(const GapTracker& tracker, int a, int b) {
+    int checkpointA = tracker.lastCheckpoint[a];
+    int checkpointB = tracker.lastCheckpoint[b];
+    if (checkpointA != checkpointB) return checkpointA > checkpointB;
+    if (checkpointA < 0) return tracker.raceDistance[a] > tracker.raceDistance[b];
+    int slot = checkpointA % tracker.numCheckpoints;
+    return tracker.crossingTime[a][slot] < tracker.crossingTime[b][slot];
+}
+
+// Re-sort the field; the previous order is kept as the starting point so the
+// insertion sort is close to linear between two samples
+static void updateOrder(GapTracker& tracker, const IdentityMap& identities) {
+    bool listed[IDENTITY_MAX] = {};
+    int count = 0;
+    for (int j = 0; j < tracker.numOrdered; ++j) {
+        int i = tracker.order[j];
+        if (tracker.tracked[i] && !listed[i]) {
+            tracker.order[count++] = i;
+            listed[i] = true;
+        }
+    }
+    for (int s = 0; s < tracker.numParticipants; ++s) {
+        int i = identityOfSlot(identities, s);
+        if (i >= 0 && tracker.tracked[i] && !listed[i]) {
+            tracker.order[count++] = i;
+            listed[i] = true;
+        }
+    }
+    tracker.numOrdered = count;
+
+    for (int j = 1; j < count; ++j) {
+        int car = tracker.order[j];
+        int k = j - 1;
+        while (k >= 0 && isAhead(tracker, car, tracker.order[k])) {
+            tracker.order[k + 1] = tracker.order[k];
+            --k;
+        }
+        tracker.order[k + 1] = car;
+    }
+}
+
+// Derive gap to leader, interval to the car ahead and laps down from the crossing tables
+static void updateGaps(GapTracker& tracker) {
+    for (int i = 0; i < STORED_PARTICIPANTS_MAX; ++i) {
+        tracker.gaps.gapToLeader[i] = -1.0f;
+        tracker.gaps.interval[i] = -1.0f;
+        tracker.gaps.lapsDown[i] = 0;
+    }
+    if (tracker.numOrdered == 0) return;
+
+    const int leader = tracker.order[0];
+    const int leaderCheckpoint = tracker.lastCheckpoint[leader];
+    tracker.gaps.gapToLeader[tracker.slot[leader]] = 0.0f;
+    tracker.gaps.interval[tracker.slot[leader]] = 0.0f;
+
+    for (int j = 1; j < tracker.numOrdered; ++j) {
+        int car = tracker.order[j];
+        int checkpoint = tracker.lastCheckpoint[car];
+        if (checkpoint < 0 || leaderCheckpoint < 0) continue;
+
+        const int participant = tracker.slot[car];
+        tracker.gaps.lapsDown[participant] = (leaderCheckpoint - checkpoint) / tracker.numCheckpoints;
+
+        // The leader's ring only still holds this checkpoint if it is less than a lap ahead
+        int slot = checkpoint % tracker.numCheckpoints;
+        double crossed = tracker.crossingTime[car][slot];
+        if (tracker.crossingIndex[leader][slot] == checkpoint) {
+            tracker.gaps.gapToLeader[participant] = static_cast<float>(crossed - tracker.crossingTime[leader][slot]);
+        }
+        int ahead = tracker.order[j - 1];
+        if (tracker.crossingIndex[ahead][slot] == checkpoint) {
+            tracker.gaps.interval[participant] = static_cast<float>(crossed - tracker.crossingTime[ahead][slot]);
+        }
+    }
+}
+
+// Feed the participant table of one snapshot captured at 'now' (seconds on a monotonic clock), with the identities
+// of its slots, and refresh gaps and intervals
+void updateGapTracker(GapTracker& tracker, const ParticipantTable& participants, const IdentityMap& identities, double now) {
+    const float trackLength = participants.trackLength;
+    const int numParticipants = participants.count;
+    if (trackLength <= 0.0f || numParticipants <= 0) return;
+
+    if (trackLength != tracker.trackLength) {
+        resetGapTracker(tracker);
+        tracker.trackLength = trackLength;
+        tracker.checkpointSpacing = trackLength / tracker.numCheckpoints;
+    }
+    tracker.numParticipants = numParticipants;
+
+    // Cars no longer in the field stop being tracked; a car that left and came back since
+    // the last sample (a new stint of its identity) starts over like a new one
+    int car[STORED_PARTICIPANTS_MAX];
+    for (int i = 0; i < IDENTITY_MAX; ++i) tracker.slot[i] = -1;
+    for (int s = 0; s < numParticipants; ++s) {
+        car[s] = identityOfSlot(identities, s);
+        if (car[s] >= 0) tracker.slot[car[s]] = s;
+    }
+    for (int i = 0; i < IDENTITY_MAX; ++i) {
+        const uint32_t stint = tracker.slot[i] >= 0 ? identities.identities[i].stint : 0;
+        if (stint != tracker.stint[i]) {
+            tracker.tracked[i] = false;
+            tracker.frozen[i] = false;
+            tracker.stint[i] = stint;
+        }
+    }
+
+    // Gather each slot's previous distance into a column, then one branch-free pass over both
+    // columns finds the checkpoints reached before and after; GCC and Clang vectorize the second loop
+    const float inverseSpacing = 1.0f / tracker.checkpointSpacing;
+    const float maxStep = trackLength * MAX_STEP_FRACTION;
+    const float* distance = participants.raceDistance;
+    float previousDistance[STORED_PARTICIPANTS_MAX];
+    int previousCheckpoint[STORED_PARTICIPANTS_MAX];
+    int currentCheckpoint[STORED_PARTICIPANTS_MAX];
+    for (int s = 0; s < numParticipants; ++s) {
+        previousDistance[s] = car[s] >= 0 ? tracker.raceDistance[car[s]] : 0.0f;
+    }
+    for (int s = 0; s < numParticipants; ++s) {
+        previousCheckpoint[s] = static_cast<int>(previousDistance[s] * inverseSpacing);
+        currentCheckpoint[s] = static_cast<int>(distance[s] * inverseSpacing);
+    }
+
+    // Only cars that crossed a checkpoint need the interpolation loop
+    const double sampleSpan = now - tracker.lastSampleTime;
+    for (int s = 0; s < numParticipants; ++s) {
+        const int i = car[s];
+        if (i < 0 || tracker.frozen[i]) continue;
+
+        float step = distance[s] - tracker.raceDistance[i];
+        if (!tracker.tracked[i] || !tracker.hasSample || step < 0.0f || step > maxStep) {
+            tracker.tracked[i] = true;
+            tracker.raceDistance[i] = distance[s];
+            tracker.lastCheckpoint[i] = -1;
+            continue;
+        }
+
+        for (int k = previousCheckpoint[s] + 1; k <= currentCheckpoint[s]; ++k) {
+            float fraction = (k * tracker.checkpointSpacing - tracker.raceDistance[i]) / step;
+            int slot = k % tracker.numCheckpoints;
+            tracker.crossingTime[i][slot] = tracker.lastSampleTime + fraction * sampleSpan;
+            tracker.crossingIndex[i][slot] = k;
+            tracker.lastCheckpoint[i] = k;
+        }
+        tracker.raceDistance[i] = distance[s];
+
+        // Keep the gap taken at the line once the car has finished
+        if (participants.raceState[s] == RACESTATE_FINISHED) {
+            tracker.frozen[i] = true;
+        }
+    }
+
+    tracker.hasSample = true;
+    tracker.lastSampleTime = now;
+
+    updateOrder(tracker, identities);
+    updateGaps(tracker);
+}
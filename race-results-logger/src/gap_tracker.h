@@ -0,0 +1,58 @@
+#ifndef GAP_TRACKER_H
+#define GAP_TRACKER_H
+
+#include "SharedMemory.h"
+#include "participant_identity.h"
+#include "participant_table.h"
+
+// Number of timing checkpoints laid out evenly around the lap (index 0 is the start/finish line)
+enum
+{
+  GAP_CHECKPOINTS_MAX = 256
+};
+
+// Gap to the leader, interval to the car ahead and laps down, indexed by participant slot
+struct FieldGaps {
+    float gapToLeader[STORED_PARTICIPANTS_MAX];        // [ UNITS = seconds ]   [ UNSET = -1.0f ]
+    float interval[STORED_PARTICIPANTS_MAX];           // [ UNITS = seconds ]   [ UNSET = -1.0f ]
+    int lapsDown[STORED_PARTICIPANTS_MAX];             // whole laps behind the leader
+};
+
+// Live gap and interval state for the whole field.
+// Every car keeps a one-lap ring of the times it crossed each checkpoint, tagged with the
+// race-distance checkpoint index (lap * checkpoints + checkpoint), so a gap is the difference
+// between two interpolated crossing times of the same checkpoint rather than a speed estimate.
+// It is fed every game frame, so a crossing is interpolated across one frame (about 17 ms at 60 Hz).
+// The rings belong to a car's identity, not its slot, so they survive lobby slot reshuffles.
+struct GapTracker {
+    float trackLength;
+    float checkpointSpacing;
+    int numCheckpoints;
+    int numParticipants;
+    bool hasSample;
+    double lastSampleTime;
+
+    // Per-car state, indexed by identity
+    bool tracked[IDENTITY_MAX];                        // car has a valid previous sample
+    bool frozen[IDENTITY_MAX];                         // car finished, gaps kept as taken at the line
+    uint32_t stint[IDENTITY_MAX];                      // identity stint the state belongs to, 0 if none
+    int slot[IDENTITY_MAX];                            // participant slot in the latest sample, -1 if not in the field
+    float raceDistance[IDENTITY_MAX];                  // metres since the start line
+    int lastCheckpoint[IDENTITY_MAX];                  // race-distance checkpoint index last crossed, -1 if none
+    double crossingTime[IDENTITY_MAX][GAP_CHECKPOINTS_MAX];
+    int crossingIndex[IDENTITY_MAX][GAP_CHECKPOINTS_MAX];
+
+    // Classified order (identities) by race distance, and the derived gaps
+    int order[IDENTITY_MAX];
+    int numOrdered;
+    FieldGaps gaps;
+};
+
+// Clear all crossing tables, e.g. when a new race session starts
+void resetGapTracker(GapTracker& tracker);
+
+// Feed the participant table of one snapshot captured at 'now' (seconds on a monotonic clock), with the identities
+// of its slots, and refresh gaps and intervals
+void updateGapTracker(GapTracker& tracker, const ParticipantTable& participants, const IdentityMap& identities, double now);
+
+#endif // GAP_TRACKER_H
@@ -0,0 +1,26 @@
+#include "logger.h"
+#include <stdio.h>
+#include <ctime>
+#include <sstream>
+#include <mutex>
+
+// Log file for console messages
+std::ofstream logFile;
+
+// Sampler, analytics and detection threads all log
+static std::mutex logMutex;
+
+// Log to both console and file
+void logMessage(const std::string& level, const std::string& message) {
+    time_t now = time(nullptr);
+    char timeStr[32];
+    strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    std::stringstream logEntry;
+    logEntry << timeStr << " [" << level << "] " << message << "\n";
+    std::lock_guard<std::mutex> lock(logMutex);
+    printf("%s", logEntry.str().c_str());
+    if (logFile.is_open()) {
+        logFile << logEntry.str();
+        logFile.flush();
+    }
+}
@@ -0,0 +1,13 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <fstream>
+#include <string>
+
+// Log file for console messages
+extern std::ofstream logFile;
+
+// Log to both console and file
+void logMessage(const std::string& level, const std::string& message);
+
+#endif // LOGGER_H
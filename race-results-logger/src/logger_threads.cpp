@@ -0,0 +1,228 @@
+#include "logger_threads.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "logger.h"
+#include "results.h"
+
+// Seconds on the logger's monotonic clock
+double secondsSince(std::chrono::steady_clock::time_point clockStart) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - clockStart).count();
+}
+
+// Apply a thread's priority and CPUs to the calling thread; a refusal is logged and the thread runs on as it is
+void enterThreadSchedule(const ThreadSchedule& schedule) {
+    if (schedule.priority != SCHEDULING_PRIORITY_NORMAL && !setThreadPriorityLevel(schedule.priority)) {
+        logMessage("WARNING", std::string("Failed to set ") + schedule.name + " thread priority " + schedulingPriorityName(schedule.priority) + ", error " + std::to_string(lastErrorCode()));
+    }
+    if (schedule.cpus != 0 && !setThreadAffinity(schedule.cpus)) {
+        logMessage("WARNING", std::string("Failed to run ") + schedule.name + " thread on CPUs " + formatCpuList(schedule.cpus) + ", error " + std::to_string(lastErrorCode()));
+    }
+}
+
+// Sampler thread: copy every new game frame into the exchange and nothing else, so slow
+// consumers never delay the next read of shared memory. The fine timer resolution is only
+// held while frames arrive, so a paused game or a menu does not keep the system timer fast.
+void runSampler(const SharedMemory* sharedData, SnapshotExchange* exchange, std::chrono::steady_clock::time_point clockStart,
+                ThreadSchedule schedule, SamplerPacing pacing, unsigned int timerResolutionMs) {
+    enterThreadSchedule(schedule);
+    bool haveFrame = false;
+    bool holdingTimer = false;
+    unsigned int lastSequence = 0;
+    while (!exchange->stopped) {
+        countWakeup(*schedule.stats, schedule.activity, threadCpuSeconds());
+
+        // Take a frame once the game has finished writing a new one (even, changed sequence number)
+        int outcome = SAMPLER_NO_FRAME;
+        unsigned int sequence = sharedData->mSequenceNumber;
+        const double now = secondsSince(clockStart);
+        if (sequence % 2 == 0 && (!haveFrame || sequence != lastSequence)) {
+            SharedMemory* snapshot = beginSnapshotWrite(*exchange);
+            memcpy(snapshot, sharedData, sizeof(SharedMemory));
+            if (snapshot->mSequenceNumber != sequence || sharedData->mSequenceNumber != sequence) {
+                // The game wrote during the copy; the pacing decides whether to retry straight away
+                abandonSnapshotWrite(*exchange);
+                outcome = SAMPLER_TORN;
+            } else {
+                haveFrame = true;
+                lastSequence = sequence;
+                publishSnapshot(*exchange, now);
+                outcome = SAMPLER_NEW_FRAME;
+            }
+        }
+
+        const bool wasIdle = pacing.idle;
+        const unsigned int wait = nextSamplerPoll(pacing, outcome, now);
+        if (pacing.idle != wasIdle) {
+            logMessage("DEBUG", pacing.idle ? "No new frames, sampler polls every " + std::to_string(pacing.idlePollMs) + " ms" : std::string("Frames resumed, sampler polls every ") + std::to_string(pacing.pollMs) + " ms");
+        }
+        if (timerResolutionMs > 0 && holdingTimer == pacing.idle) {
+            if (holdingTimer) {
+                endTimerResolution(timerResolutionMs);
+            } else {
+                beginTimerResolution(timerResolutionMs);
+            }
+            holdingTimer = !holdingTimer;
+        }
+        if (wait > 0) sleepMs(wait);
+    }
+    if (holdingTimer) endTimerResolution(timerResolutionMs);
+}
+
+// Switch the lap delta to the track, layout and car in the snapshot and map their reference lap if saved
+static void loadReferenceLap(FrameAnalytics& analytics, const SharedMemory* snapshot) {
+    detachReferenceLap(*analytics.lapDelta);
+    unmapFile(analytics.referenceFile);
+    resetLapDelta(*analytics.lapDelta, snapshot);
+    if (analytics.lapDelta->points == 0 || !analytics.keepReferenceLaps) return;
+    const std::string filename = referenceLapFilename(*analytics.lapDelta);
+    if (!mapFile(filename.c_str(), analytics.referenceFile)) return;
+    if (attachReferenceLap(*analytics.lapDelta, analytics.referenceFile.data, analytics.referenceFile.size)) {
+        logMessage("INFO", "Reference lap loaded from " + filename + ": " + formatTime(analytics.lapDelta->loaded.lapTime));
+    } else {
+        logMessage("ERROR", "Reference lap " + filename + " does not match this track, ignoring it");
+        unmapFile(analytics.referenceFile);
+    }
+}
+
+// Log a completed lap against the reference and save it if it is the new best;
+// the mapped reference has to be let go before its file is overwritten
+static void finishReferenceLap(FrameAnalytics& analytics, int lapResult) {
+    const LapDelta& lapDelta = *analytics.lapDelta;
+    char delta[32] = "";
+    if (lapDelta.lastLapHasDelta) snprintf(delta, sizeof(delta), ", %+.3f to reference", lapDelta.lastLapDelta);
+    logMessage("INFO", "Lap " + std::to_string(lapDelta.lap - 1) + ": " + formatTime(lapDelta.lastLapTime) + delta +
+                       (lapDelta.lastLapCounted ? "" : " (not counted)"));
+    if (lapResult != LAP_DELTA_NEW_BEST || !analytics.keepReferenceLaps) return;
+    detachReferenceLap(*analytics.lapDelta);
+    unmapFile(analytics.referenceFile);
+    const std::string filename = referenceLapFilename(*analytics.lapDelta);
+    if (saveReferenceLap(*analytics.lapDelta, filename)) {
+        logMessage("INFO", "New reference lap " + formatTime(analytics.lapDelta->sessionBestTime) + " saved to " + filename);
+    }
+}
+
+// Log the joins, leaves and rejoins found by the latest identity update
+static void logIdentityEvents(const IdentityMap& identities) {
+    static const char* const EVENT_NAMES[] = {"joined", "left", "rejoined"};
+    int counts[3] = {0, 0, 0};
+    for (int e = 0; e < identities.numEvents; ++e) {
+        const IdentityEvent& event = identities.events[e];
+        const ParticipantIdentity& identity = identities.identities[event.identity];
+        logMessage("DEBUG", std::string(identity.driverName) + " (" + identity.carName + ") " + EVENT_NAMES[event.type] + ", slot " + std::to_string(event.slot) + ", identity " + std::to_string(event.identity));
+        ++counts[event.type];
+    }
+    if (identities.numEvents > 0) {
+        logMessage("INFO", "Field changed: " + std::to_string(counts[IDENTITY_JOIN]) + " joined, " + std::to_string(counts[IDENTITY_LEAVE]) + " left, " + std::to_string(counts[IDENTITY_REJOIN]) + " rejoined, " + std::to_string(identities.present) + " in the field");
+    }
+}
+
+// Analytics thread: feed every snapshot to the driving analytics, the telemetry pyramid, the lap delta
+// and the field (participant table, identities and live gaps)
+void runAnalytics(SnapshotExchange* exchange, int consumer, FrameAnalytics* analytics, ThreadSchedule schedule) {
+    enterThreadSchedule(schedule);
+    unsigned int sessionState = SESSION_INVALID;
+    TelemetrySample telemetrySample;
+    while (!exchange->stopped) {
+        double now = 0.0;
+        const SharedMemory* snapshot = acquireSnapshot(*exchange, consumer, SNAPSHOT_WAIT_MS, &now);
+        countWakeup(*schedule.stats, schedule.activity, threadCpuSeconds());
+        if (snapshot == NULL) continue;
+        const bool newSession = snapshot->mSessionState != sessionState;
+        sessionState = snapshot->mSessionState;
+
+        // Checkpoint crossings are timed on every frame at the sampler's capture time, so a crossing is
+        // interpolated across one frame rather than across a detection interval
+        {
+            std::lock_guard<std::mutex> lock(analytics->fieldMutex);
+            if (newSession) resetGapTracker(*analytics->gaps);
+            updateParticipantTable(*analytics->participants, snapshot);
+            updateIdentityMap(*analytics->identities, *analytics->participants, now);
+            if (snapshot->mSessionState == SESSION_RACE) {
+                updateGapTracker(*analytics->gaps, *analytics->participants, *analytics->identities, now);
+            }
+            analytics->fieldTime = now;
+        }
+        analytics->fieldReady.notify_all();
+        logIdentityEvents(*analytics->identities);
+
+        {
+            std::lock_guard<std::mutex> lock(analytics->mutex);
+            if (newSession) {
+                resetDrivingStats(*analytics->drivingStats);
+                resetTelemetryPyramid(*analytics->telemetry);
+            }
+            updateDrivingStats(*analytics->drivingStats, snapshot, now);
+            if (snapshot->mGameState == GAME_INGAME_PLAYING) {
+                readTelemetrySample(snapshot, telemetrySample);
+                addTelemetrySample(*analytics->telemetry, telemetrySample, now);
+            }
+        }
+        if (!lapDeltaMatches(*analytics->lapDelta, snapshot)) loadReferenceLap(*analytics, snapshot);
+        const int lapResult = updateLapDelta(*analytics->lapDelta, snapshot);
+        if (lapResult != LAP_DELTA_RUNNING) finishReferenceLap(*analytics, lapResult);
+        if (analytics->derivedState != NULL) {
+            {
+                std::lock_guard<std::mutex> lock(analytics->mutex);
+                buildDerivedViewedCar(*analytics->derivedViewed, *analytics->drivingStats, *analytics->lapDelta, now);
+            }
+            publishDerivedViewedCar(analytics->derivedState, *analytics->derivedViewed);
+        }
+        releaseSnapshot(*exchange, consumer);
+    }
+}
+
+// Black box thread: keep the last minutes of frames in memory and write them out once a trigger is due
+void runBlackBox(SnapshotExchange* exchange, int consumer, BlackBox* box, std::chrono::steady_clock::time_point clockStart, ThreadSchedule schedule) {
+    enterThreadSchedule(schedule);
+    while (!exchange->stopped) {
+        double now = 0.0;
+        const SharedMemory* snapshot = acquireSnapshot(*exchange, consumer, SNAPSHOT_WAIT_MS, &now);
+        countWakeup(*schedule.stats, schedule.activity, threadCpuSeconds());
+        if (snapshot == NULL) {
+            // No frames, e.g. the game is paused in a menu: a requested dump still goes out
+            saveBlackBoxIfDue(*box, secondsSince(clockStart));
+            continue;
+        }
+        recordBlackBoxFrame(*box, snapshot, now);
+        checkBlackBoxTriggers(*box, snapshot, now);
+        releaseSnapshot(*exchange, consumer);
+        saveBlackBoxIfDue(*box, now);
+    }
+}
+
+// Detection thread: sleep out the rest of the detection interval, then take the latest snapshot and count the
+// wakeup; NULL on timeout or once the exchange is stopped. 'now' gets the time the snapshot was published.
+const SharedMemory* acquireDetectionSnapshot(SnapshotExchange& exchange, int consumer, const ThreadSchedule& schedule,
+                                             std::chrono::steady_clock::time_point clockStart, double lastDetection, double* now) {
+    // Rounded up so one wakeup covers the interval; the sampler keeps taking frames meanwhile
+    const double wait = lastDetection + DETECTION_INTERVAL_SECONDS - secondsSince(clockStart);
+    if (wait > 0.0) sleepMs(static_cast<unsigned int>(wait * 1000.0 + 0.999));
+    const SharedMemory* snapshot = acquireSnapshot(exchange, consumer, SNAPSHOT_WAIT_MS, now);
+    countWakeup(*schedule.stats, schedule.activity, threadCpuSeconds());
+    return snapshot;
+}
+
+// Copy the field once the analytics thread has analysed the detection snapshot published at 'now'
+// (or waited SNAPSHOT_WAIT_MS for it) and publish its section of the derived state
+void readFieldView(FrameAnalytics& analytics, FieldView& view, DerivedField& derivedField, const SharedMemory* snapshot, double now) {
+    {
+        // Both threads take the same frames, so the analytics thread is at most a frame or two behind;
+        // without the wait a paused game, which publishes no further frames, would never be detected on
+        std::unique_lock<std::mutex> lock(analytics.fieldMutex);
+        analytics.fieldReady.wait_for(lock, std::chrono::milliseconds(SNAPSHOT_WAIT_MS), [&] { return analytics.fieldTime >= now; });
+        view.participants = *analytics.participants;
+        view.gaps = analytics.gaps->gaps;
+        copySlotIdentities(*analytics.identities, view.slots);
+        view.time = analytics.fieldTime;
+        view.identities = analytics.identities->count;
+        view.joins = analytics.identities->joins;
+        view.leaves = analytics.identities->leaves;
+        view.rejoins = analytics.identities->rejoins;
+        view.moves = analytics.identities->moves;
+    }
+    if (analytics.derivedState != NULL) {
+        buildDerivedField(derivedField, snapshot, view.participants, view.gaps, now);
+        publishDerivedField(analytics.derivedState, derivedField);
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef LOGGER_THREADS_H
+#define LOGGER_THREADS_H
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include "SharedMemory.h"
+#include "black_box.h"
+#include "derived_publisher.h"
+#include "driving_stats.h"
+#include "gap_tracker.h"
+#include "participant_identity.h"
+#include "participant_table.h"
+#include "platform.h"
+#include "reference_lap.h"
+#include "scheduling.h"
+#include "snapshot_exchange.h"
+#include "telemetry_pyramid.h"
+
+// The logger's threads: the sampler, the per-frame analytics and black box consumers, and the
+// detection thread's copy of the field. race_logger runs them next to its race detection and
+// logging; ams2interference runs the same code next to a synthetic game to measure what it costs.
+
+// How often race start/end detection, track map and logging run
+#define DETECTION_INTERVAL_SECONDS 0.5
+
+// How long a consumer thread waits for a snapshot before checking for shutdown
+#define SNAPSHOT_WAIT_MS 1000
+
+// Priority, CPUs and activity counters of one of the logger's threads
+struct ThreadSchedule {
+    const char* name;
+    int priority;                                     // SCHEDULING_PRIORITY_*
+    uint64_t cpus;                                    // 0 for any CPU
+    SchedulingStats* stats;
+    int activity;                                     // thread index in stats
+};
+
+// Per-frame analytics, updated by the analytics thread and read when results are logged
+struct FrameAnalytics {
+    DrivingStats* drivingStats;
+    TelemetryPyramid* telemetry;
+    std::mutex mutex;                                 // guards drivingStats and telemetry
+
+    // Only touched by the analytics thread
+    LapDelta* lapDelta;
+    MappedFile referenceFile;
+    bool keepReferenceLaps;                           // load and save reference laps in reference/
+    DerivedState* derivedState;                       // published segment [ UNSET = NULL ]
+    DerivedViewedCar* derivedViewed;                  // writer's copy of its viewed-car section
+
+    // The field, updated on every frame and copied out by the detection thread with readFieldView
+    ParticipantTable* participants;
+    IdentityMap* identities;
+    GapTracker* gaps;
+    double fieldTime;                                 // sampler clock of the frame last analysed [ UNSET = -1.0 ]
+    std::mutex fieldMutex;                            // guards the field for readFieldView
+    std::condition_variable fieldReady;               // signalled whenever fieldTime moves on
+};
+
+// The detection thread's copy of the field as of the latest analysed frame
+struct FieldView {
+    ParticipantTable participants;
+    FieldGaps gaps;
+    SlotIdentities slots;
+    double time;                                      // sampler clock of the frame [ UNSET = -1.0 ]
+    int identities;                                   // cars seen since the logger started
+    unsigned long joins;
+    unsigned long leaves;
+    unsigned long rejoins;
+    unsigned long moves;
+};
+
+// Seconds on the logger's monotonic clock
+double secondsSince(std::chrono::steady_clock::time_point clockStart);
+
+// Apply a thread's priority and CPUs to the calling thread; a refusal is logged and the thread runs on as it is
+void enterThreadSchedule(const ThreadSchedule& schedule);
+
+// Sampler thread: copy every new game frame into the exchange and nothing else, until the exchange is stopped
+void runSampler(const SharedMemory* sharedData, SnapshotExchange* exchange, std::chrono::steady_clock::time_point clockStart,
+                ThreadSchedule schedule, SamplerPacing pacing, unsigned int timerResolutionMs);
+
+// Analytics thread: feed every snapshot to the driving analytics, the telemetry pyramid, the lap delta
+// and the field (participant table, identities and live gaps)
+void runAnalytics(SnapshotExchange* exchange, int consumer, FrameAnalytics* analytics, ThreadSchedule schedule);
+
+// Black box thread: keep the last minutes of frames in memory and write them out once a trigger is due
+void runBlackBox(SnapshotExchange* exchange, int consumer, BlackBox* box, std::chrono::steady_clock::time_point clockStart, ThreadSchedule schedule);
+
+// Detection thread: sleep out the rest of the detection interval, then take the latest snapshot and count the
+// wakeup; NULL on timeout or once the exchange is stopped. 'now' gets the time the snapshot was published.
+const SharedMemory* acquireDetectionSnapshot(SnapshotExchange& exchange, int consumer, const ThreadSchedule& schedule,
+                                             std::chrono::steady_clock::time_point clockStart, double lastDetection, double* now);
+
+// Copy the field once the analytics thread has analysed the detection snapshot published at 'now'
+// (or waited SNAPSHOT_WAIT_MS for it) and publish its section of the derived state
+void readFieldView(FrameAnalytics& analytics, FieldView& view, DerivedField& derivedField, const SharedMemory* snapshot, double now);
+
+#endif // LOGGER_THREADS_H
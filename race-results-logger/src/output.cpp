@@ -0,0 +1,381 @@
+#include "output.h"
+#include <stdio.h>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <filesystem>
+#include "logger.h"
+#include "result_hash.h"
+
+// Douglas-Peucker tolerance for the saved track outline, in metres
+#define TRACK_OUTLINE_TOLERANCE 1.0f
+
+// Format a gap or lap time in seconds for JSON output, -1 when no time is available
+std::string formatGap(float seconds) {
+    if (seconds < 0) return "-1";
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%.3f", seconds);
+    return std::string(buffer);
+}
+
+// Escape string for JSON
+std::string escapeJsonString(const std::string& input) {
+    std::string output;
+    for (char c : input) {
+        if (c == '"') output += "\\\"";
+        else if (c == '\\') output += "\\\\";
+        else output += c;
+    }
+    return output;
+}
+
+// Replace characters that are not allowed in filenames with _
+std::string sanitizeFilename(const std::string& name) {
+    std::string output = name;
+    for (char& c : output) {
+        if (std::string("\\/:*?\"<>| ").find(c) != std::string::npos) c = '_';
+    }
+    return output;
+}
+
+// Generate a unique filename (output/ or raceinfo/results_YYYYMMDD_HHMMSS_<hash>.csv/json),
+// adding a counter if a file with that name already exists
+std::string getResultFilename(const std::string& extension, bool createJsonAtRaceStart, uint64_t resultHash) {
+    time_t now = time(nullptr);
+    char timeStr[32];
+    std::string folder = createJsonAtRaceStart && extension != "csv" ? "raceinfo" : "output";
+    strftime(timeStr, sizeof(timeStr), (folder + "/results_%Y%m%d_%H%M%S").c_str(), localtime(&now));
+    std::string stem = std::string(timeStr) + "_" + formatHash(resultHash).substr(0, 8);
+    std::string filename = stem + "." + extension;
+    for (int counter = 2; std::filesystem::exists(filename); ++counter) {
+        filename = stem + "_" + std::to_string(counter) + "." + extension;
+    }
+    return filename;
+}
+
+// Write results as CSV rows with a header line
+void writeResultsCsv(std::ostream& out, const std::vector<RaceResult>& results) {
+    out << "\"Session Name\",\"TrackName\",\"Position\",\"DriverName\",\"CarName\"\n";
+    for (const auto& result : results) {
+        out << "\"" << result.sessionName << "\","
+            << "\"" << result.trackName << "\","
+            << result.position << ","
+            << "\"" << result.driverName << "\","
+            << "\"" << result.carName << "\"\n";
+    }
+}
+
+// Speeds are reported in km/h
+static const float METRES_PER_SECOND_TO_KPH = 3.6f;
+
+// Share of a duration in percent, for pedal usage
+static std::string formatPercent(float part, float whole) {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%.1f", whole > 0.0f ? part / whole * 100.0f : 0.0f);
+    return std::string(buffer);
+}
+
+// Fixed-point number with 'decimals' digits for the lap history
+static std::string formatFixed(float value, int decimals) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    return std::string(buffer);
+}
+
+// Write the driving aggregates of one sector or lap as JSON members; 'more' if other members follow
+static void writeSectorStatsJson(std::ostream& out, const SectorStats& sector, const std::string& indent, bool more) {
+    out << indent << "\"Duration\": " << formatFixed(sector.duration, 3) << ",\n";
+    out << indent << "\"MinSpeedKph\": " << formatFixed(sector.minSpeed * METRES_PER_SECOND_TO_KPH, 1) << ",\n";
+    out << indent << "\"MaxSpeedKph\": " << formatFixed(sector.maxSpeed * METRES_PER_SECOND_TO_KPH, 1) << ",\n";
+    out << indent << "\"MaxRpm\": " << formatFixed(sector.maxRpm, 0) << ",\n";
+    out << indent << "\"ThrottlePercent\": " << formatPercent(sector.throttleTime, sector.duration) << ",\n";
+    out << indent << "\"FullThrottlePercent\": " << formatPercent(sector.fullThrottleTime, sector.duration) << ",\n";
+    out << indent << "\"BrakePercent\": " << formatPercent(sector.brakeTime, sector.duration) << ",\n";
+    out << indent << "\"CoastTime\": " << formatFixed(sector.coastTime, 3) << ",\n";
+    out << indent << "\"Upshifts\": " << sector.upshifts << ",\n";
+    out << indent << "\"Downshifts\": " << sector.downshifts << ",\n";
+    out << indent << "\"PeakLateralG\": " << formatFixed(sector.peakLateralG, 2) << ",\n";
+    out << indent << "\"PeakLongitudinalG\": " << formatFixed(sector.peakLongitudinalG, 2) << ",\n";
+    out << indent << "\"PeakCombinedG\": " << formatFixed(sector.peakCombinedG, 2) << (more ? ",\n" : "\n");
+}
+
+// Write one lap of the lap history
+static void writeLapStatsJson(std::ostream& out, const LapStats& lap, bool last) {
+    out << "      {\n";
+    out << "        \"Lap\": " << lap.lap << ",\n";
+    out << "        \"Complete\": " << (lap.complete ? "true" : "false") << ",\n";
+    out << "        \"Invalidated\": " << (lap.invalidated ? "true" : "false") << ",\n";
+    out << "        \"LapTime\": " << formatGap(lap.lapTime) << ",\n";
+    writeSectorStatsJson(out, lap.total, "        ", true);
+    out << "        \"BrakingPoints\": [";
+    for (int b = 0; b < lap.numBrakingPoints; ++b) {
+        out << (b ? ", " : "") << formatFixed(lap.brakingPoints[b], 1);
+    }
+    out << "],\n";
+    out << "        \"Sectors\": [\n";
+    for (int s = 0; s < DRIVING_SECTORS_MAX; ++s) {
+        out << "          {\n";
+        out << "            \"Sector\": " << s + 1 << ",\n";
+        writeSectorStatsJson(out, lap.sectors[s], "            ", false);
+        out << "          }" << (s + 1 < DRIVING_SECTORS_MAX ? "," : "") << "\n";
+    }
+    out << "        ]\n";
+    out << "      }" << (last ? "" : ",") << "\n";
+}
+
+// Write results as the JSON document uploaded to the server, with the viewed car's lap history if given
+void writeResultsJson(std::ostream& out, const std::string& sessionName, const std::string& trackName,
+                      const std::string& trackLayout, uint64_t resultHash, const std::vector<RaceResult>& results,
+                      const DrivingStats* drivingStats) {
+    out << "{\n";
+    out << "  \"Session Name\": \"" << escapeJsonString(sessionName) << "\",\n";
+    out << "  \"TrackName\": \"" << escapeJsonString(trackName) << "\",\n";
+    out << "  \"TrackLayout\": \"" << escapeJsonString(trackLayout) << "\",\n";
+    out << "  \"TrackId\": " << trackAssetId(trackName, trackLayout) << ",\n";
+    out << "  \"LocationId\": " << locationAssetId(trackName) << ",\n";
+    out << "  \"ResultHash\": \"" << formatHash(resultHash) << "\",\n";
+    out << "  \"Drivers\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        out << "    {\n";
+        out << "      \"Position\": " << results[i].position << ",\n";
+        out << "      \"DriverName\": \"" << escapeJsonString(results[i].driverName) << "\",\n";
+        out << "      \"CarName\": \"" << escapeJsonString(results[i].carName) << "\",\n";
+        out << "      \"CarClass\": \"" << escapeJsonString(results[i].carClass) << "\",\n";
+        out << "      \"CarId\": " << results[i].carId << ",\n";
+        out << "      \"CarClassId\": " << results[i].carClassId << ",\n";
+        out << "      \"GapToLeader\": " << formatGap(results[i].gapToLeader) << ",\n";
+        out << "      \"Interval\": " << formatGap(results[i].interval) << ",\n";
+        out << "      \"LapsDown\": " << results[i].lapsDown << ",\n";
+        out << "      \"LapsCompleted\": " << results[i].lapsCompleted << ",\n";
+        out << "      \"FastestLapTime\": " << formatGap(results[i].fastestLapTime) << ",\n";
+        out << "      \"LastLapTime\": " << formatGap(results[i].lastLapTime) << "\n";
+        out << "    }" << (i < results.size() - 1 ? "," : "") << "\n";
+    }
+    out << "  ]" << (drivingStats != NULL ? "," : "") << "\n";
+
+    // Completed laps, then the lap in progress if it has any frames
+    if (drivingStats != NULL) {
+        const LapStats current = currentLapStats(*drivingStats);
+        const bool inProgress = current.total.frames > 0;
+        out << "  \"LapHistory\": {\n";
+        out << "    \"DriverName\": \"" << escapeJsonString(drivingStats->driverName) << "\",\n";
+        out << "    \"FramesSeen\": " << drivingStats->framesSeen << ",\n";
+        out << "    \"FramesMissed\": " << drivingStats->framesMissed << ",\n";
+        out << "    \"Laps\": [\n";
+        for (int l = 0; l < drivingStats->historyCount; ++l) {
+            writeLapStatsJson(out, lapHistoryAt(*drivingStats, l), l + 1 == drivingStats->historyCount && !inProgress);
+        }
+        if (inProgress) writeLapStatsJson(out, current, true);
+        out << "    ]\n";
+        out << "  }\n";
+    }
+    out << "}\n";
+}
+
+// Write a list of track points as [x, z, distance] triples
+static void writeTrackPoints(std::ostream& out, const TrackPoint* points, size_t count, const std::string& indent) {
+    for (size_t i = 0; i < count; ++i) {
+        out << indent << "[" << points[i].x << ", " << points[i].z << ", " << points[i].distance << "]"
+            << (i + 1 < count ? "," : "") << "\n";
+    }
+}
+
+// Save the simplified track outline, sector markers and car trajectories to trackmaps/
+void saveTrackMap(const TrackMap& trackMap) {
+    if (trackMap.trackLength <= 0.0f) return;
+    namespace fs = std::filesystem;
+    if (!fs::exists("trackmaps")) {
+        fs::create_directory("trackmaps");
+        logMessage("INFO", "Created trackmaps/ directory");
+    }
+
+    // One file per race, stamped like the results and telemetry, so a later race on the layout keeps this one's trajectories
+    TrackOutline outline = buildTrackOutline(trackMap, TRACK_OUTLINE_TOLERANCE);
+    time_t now = time(nullptr);
+    char timeStr[32];
+    strftime(timeStr, sizeof(timeStr), "_%Y%m%d_%H%M%S", localtime(&now));
+    std::string filename = "trackmaps/" + sanitizeFilename(trackMap.trackName) + "_" + sanitizeFilename(trackMap.trackLayout) + timeStr + ".json";
+    std::ofstream mapFile(filename, std::ios::out);
+    if (!mapFile.is_open()) {
+        logMessage("ERROR", "Failed to open track map file: " + filename);
+        return;
+    }
+
+    mapFile << std::fixed << std::setprecision(2);
+    mapFile << "{\n";
+    mapFile << "  \"TrackName\": \"" << escapeJsonString(trackMap.trackName) << "\",\n";
+    mapFile << "  \"TrackLayout\": \"" << escapeJsonString(trackMap.trackLayout) << "\",\n";
+    mapFile << "  \"TrackLength\": " << trackMap.trackLength << ",\n";
+    mapFile << "  \"Outline\": [\n";
+    writeTrackPoints(mapFile, outline.points.data(), outline.points.size(), "    ");
+    mapFile << "  ],\n";
+    mapFile << "  \"Sectors\": [\n";
+    bool firstSector = true;
+    for (int s = 0; s < TRACK_SECTORS_MAX; ++s) {
+        if (outline.sectorPoint[s] < 0) continue;
+        mapFile << (firstSector ? "" : ",\n") << "    { \"Sector\": " << s << ", \"Distance\": " << outline.sectorDistance[s]
+                << ", \"Point\": " << outline.sectorPoint[s] << " }";
+        firstSector = false;
+    }
+    mapFile << (firstSector ? "" : "\n") << "  ],\n";
+    mapFile << "  \"Trajectories\": [\n";
+    bool firstTrajectory = true;
+    for (int i = 0; i < IDENTITY_MAX; ++i) {
+        const CarTrajectory& trajectory = trackMap.trajectories[i];
+        if (trajectory.count == 0) continue;
+        mapFile << (firstTrajectory ? "" : ",\n") << "    {\n";
+        mapFile << "      \"DriverName\": \"" << escapeJsonString(trackMap.trajectoryNames[i]) << "\",\n";
+        mapFile << "      \"Points\": [\n";
+        writeTrackPoints(mapFile, trajectory.points, trajectory.count, "        ");
+        mapFile << "      ]\n";
+        mapFile << "    }";
+        firstTrajectory = false;
+    }
+    mapFile << (firstTrajectory ? "" : "\n") << "  ]\n";
+    mapFile << "}\n";
+    mapFile.close();
+    logMessage("INFO", "Track map saved to " + filename + " with " + std::to_string(outline.points.size()) + " outline points");
+}
+
+// Channel group names in the telemetry files, in TELEMETRY_* order
+static const char* TELEMETRY_GROUP_NAMES[TELEMETRY_GROUPS_MAX] = {
+    "TyreTemp", "TyreTreadTemp", "BrakeTemp", "TyreWear", "AirPressure", "Environment"
+};
+
+// Write one statistic of a bucket as [[FL, FR, RL, RR], ...] per channel group
+static void writeTelemetryQuads(std::ostream& out, const TelemetryQuad* quads) {
+    out << "[";
+    for (int g = 0; g < TELEMETRY_GROUPS_MAX; ++g) {
+        out << (g ? ", [" : "[");
+        for (int k = 0; k < TYRE_MAX; ++k) {
+            out << (k ? ", " : "") << formatFixed(quads[g].v[k], 3);
+        }
+        out << "]";
+    }
+    out << "]";
+}
+
+// Write one telemetry bucket as a JSON object
+static void writeTelemetryBucketJson(std::ostream& out, const TelemetryBucket& bucket, bool last) {
+    TelemetryQuad mean[TELEMETRY_GROUPS_MAX];
+    const float inverse = bucket.count > 0 ? 1.0f / bucket.count : 0.0f;
+    for (int g = 0; g < TELEMETRY_GROUPS_MAX; ++g) {
+        for (int k = 0; k < TYRE_MAX; ++k) mean[g].v[k] = bucket.sum[g].v[k] * inverse;
+    }
+    out << "    { \"Time\": " << formatFixed(static_cast<float>(bucket.startTime), 1)
+        << ", \"Samples\": " << bucket.count << ", \"Min\": ";
+    writeTelemetryQuads(out, bucket.min);
+    out << ", \"Max\": ";
+    writeTelemetryQuads(out, bucket.max);
+    out << ", \"Mean\": ";
+    writeTelemetryQuads(out, mean);
+    out << " }" << (last ? "" : ",") << "\n";
+}
+
+// Write one level of the telemetry pyramid as JSON, including the bucket still being filled
+void writeTelemetryLevelJson(std::ostream& out, const TelemetryPyramid& pyramid, int level,
+                             const std::string& trackName, const std::string& trackLayout) {
+    const TelemetryLevel& l = pyramid.levels[level];
+    const bool open = l.open.count > 0;
+    out << "{\n";
+    out << "  \"TrackName\": \"" << escapeJsonString(trackName) << "\",\n";
+    out << "  \"TrackLayout\": \"" << escapeJsonString(trackLayout) << "\",\n";
+    out << "  \"TrackId\": " << trackAssetId(trackName, trackLayout) << ",\n";
+    out << "  \"LocationId\": " << locationAssetId(trackName) << ",\n";
+    out << "  \"BucketSeconds\": " << TELEMETRY_LEVEL_SECONDS[level] << ",\n";
+    out << "  \"Channels\": [";
+    for (int g = 0; g < TELEMETRY_GROUPS_MAX; ++g) {
+        out << (g ? ", " : "") << "\"" << TELEMETRY_GROUP_NAMES[g] << "\"";
+    }
+    out << "],\n";
+    out << "  \"Buckets\": [\n";
+    for (int b = 0; b < l.count; ++b) {
+        writeTelemetryBucketJson(out, telemetryBucketAt(pyramid, level, b), b + 1 == l.count && !open);
+    }
+    if (open) writeTelemetryBucketJson(out, l.open, true);
+    out << "  ]\n";
+    out << "}\n";
+}
+
+// Save every level of the telemetry pyramid to telemetry/<Track>_<Layout>_YYYYMMDD_HHMMSS_<seconds>s.json,
+// so a zoomed-out chart only has to load the coarse file
+void saveTelemetry(const TelemetryPyramid& pyramid, const std::string& trackName, const std::string& trackLayout) {
+    if (pyramid.samples == 0) return;
+    namespace fs = std::filesystem;
+    if (!fs::exists("telemetry")) {
+        fs::create_directory("telemetry");
+        logMessage("INFO", "Created telemetry/ directory");
+    }
+
+    time_t now = time(nullptr);
+    char timeStr[32];
+    strftime(timeStr, sizeof(timeStr), "_%Y%m%d_%H%M%S", localtime(&now));
+    std::string stem = "telemetry/" + sanitizeFilename(trackName) + "_" + sanitizeFilename(trackLayout) + timeStr;
+    for (int level = 0; level < TELEMETRY_LEVELS_MAX; ++level) {
+        std::string filename = stem + "_" + std::to_string(static_cast<int>(TELEMETRY_LEVEL_SECONDS[level])) + "s.json";
+        std::ofstream telemetryFile(filename, std::ios::out);
+        if (!telemetryFile.is_open()) {
+            logMessage("ERROR", "Failed to open telemetry file: " + filename);
+            return;
+        }
+        writeTelemetryLevelJson(telemetryFile, pyramid, level, trackName, trackLayout);
+        telemetryFile.close();
+    }
+    logMessage("INFO", "Telemetry saved to " + stem + "_*.json from " + std::to_string(pyramid.samples) + " samples");
+}
+
+// Write one table of tallies in standings order
+static void writeStandingTalliesJson(std::ostream& out, const std::vector<StandingTally>& drivers, const std::string& indent) {
+    const std::vector<int> order = rankStandings(drivers);
+    for (size_t p = 0; p < order.size(); ++p) {
+        const StandingTally& tally = drivers[order[p]];
+        out << indent << "{\"Position\": " << p + 1
+            << ", \"DriverName\": \"" << escapeJsonString(tally.driverName) << "\""
+            << ", \"CarName\": \"" << escapeJsonString(tally.carName) << "\""
+            << ", \"CarId\": " << tally.carId
+            << ", \"Points\": " << tally.points
+            << ", \"Races\": " << tally.races
+            << ", \"Wins\": " << tally.wins
+            << ", \"Podiums\": " << tally.podiums
+            << ", \"BestFinish\": " << tally.bestFinish << "}"
+            << (p + 1 < order.size() ? "," : "") << "\n";
+    }
+}
+
+// Write the overall and per-class standings as JSON, each table in standings order
+void writeStandingsJson(std::ostream& out, const Standings& standings) {
+    out << "{\n";
+    out << "  \"Races\": " << standings.races << ",\n";
+    out << "  \"Drivers\": [\n";
+    writeStandingTalliesJson(out, standings.drivers, "    ");
+    out << "  ],\n";
+    out << "  \"Classes\": [\n";
+    for (size_t c = 0; c < standings.classes.size(); ++c) {
+        const ClassStandings& classStandings = standings.classes[c];
+        out << "    {\n";
+        out << "      \"CarClass\": \"" << escapeJsonString(classStandings.carClass) << "\",\n";
+        out << "      \"CarClassId\": " << classStandings.carClassId << ",\n";
+        out << "      \"Races\": " << classStandings.races << ",\n";
+        out << "      \"Drivers\": [\n";
+        writeStandingTalliesJson(out, classStandings.drivers, "        ");
+        out << "      ]\n";
+        out << "    }" << (c + 1 < standings.classes.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+// Save the standings as JSON to standings/standings.json
+void saveStandingsJson(const Standings& standings) {
+    namespace fs = std::filesystem;
+    if (!fs::exists("standings")) {
+        fs::create_directory("standings");
+        logMessage("INFO", "Created standings/ directory");
+    }
+    std::ofstream standingsFile("standings/standings.json", std::ios::out);
+    if (!standingsFile.is_open()) {
+        logMessage("ERROR", "Failed to open standings file: standings/standings.json");
+        return;
+    }
+    writeStandingsJson(standingsFile, standings);
+}
@@ -0,0 +1,52 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "driving_stats.h"
+#include "results.h"
+#include "standings.h"
+#include "telemetry_pyramid.h"
+#include "track_map.h"
+
+// Format a gap or lap time in seconds for JSON output, -1 when no time is available
+std::string formatGap(float seconds);
+
+// Escape string for JSON
+std::string escapeJsonString(const std::string& input);
+
+// Replace characters that are not allowed in filenames with _
+std::string sanitizeFilename(const std::string& name);
+
+// Generate a unique filename (output/ or raceinfo/results_YYYYMMDD_HHMMSS_<hash>.csv/json/json.zd/amsr),
+// adding a counter if a file with that name already exists
+std::string getResultFilename(const std::string& extension, bool createJsonAtRaceStart, uint64_t resultHash);
+
+// Write results as CSV rows with a header line
+void writeResultsCsv(std::ostream& out, const std::vector<RaceResult>& results);
+
+// Write results as the JSON document uploaded to the server, with the viewed car's lap history if given
+void writeResultsJson(std::ostream& out, const std::string& sessionName, const std::string& trackName,
+                      const std::string& trackLayout, uint64_t resultHash, const std::vector<RaceResult>& results,
+                      const DrivingStats* drivingStats = NULL);
+
+// Save the simplified track outline, sector markers and car trajectories to trackmaps/
+void saveTrackMap(const TrackMap& trackMap);
+
+// Write one level of the telemetry pyramid as JSON, including the bucket still being filled
+void writeTelemetryLevelJson(std::ostream& out, const TelemetryPyramid& pyramid, int level,
+                             const std::string& trackName, const std::string& trackLayout);
+
+// Save every level of the telemetry pyramid to telemetry/<Track>_<Layout>_YYYYMMDD_HHMMSS_<seconds>s.json,
+// so a zoomed-out chart only has to load the coarse file
+void saveTelemetry(const TelemetryPyramid& pyramid, const std::string& trackName, const std::string& trackLayout);
+
+// Write the overall and per-class standings as JSON, each table in standings order
+void writeStandingsJson(std::ostream& out, const Standings& standings);
+
+// Save the standings as JSON to standings/standings.json
+void saveStandingsJson(const Standings& standings);
+
+#endif // OUTPUT_H
@@ -0,0 +1,176 @@
+#include "participant_identity.h"
+#include <string.h>
+#include "result_hash.h"
+
+// Forget every identity, e.g. before the first snapshot
+void resetIdentityMap(IdentityMap& map) {
+    memset(&map, 0, sizeof(IdentityMap));
+    for (int i = 0; i < STORED_PARTICIPANTS_MAX; ++i) map.slotIdentity[i] = -1;
+    for (int b = 0; b < IDENTITY_HASH_BUCKETS; ++b) map.buckets[b] = -1;
+}
+
+// Hash of a driver and car name, NUL-separated so the split between them counts
+static uint64_t identityHash(const char* driverName, const char* carName) {
+    static const char separator = '\0';
+    uint64_t hash = fnv1a64(driverName, strnlen(driverName, STRING_LENGTH_MAX));
+    hash = fnv1a64(&separator, 1, hash);
+    return fnv1a64(carName, strnlen(carName, STRING_LENGTH_MAX), hash);
+}
+
+// First bucket to probe for a hash
+static int firstBucket(uint64_t hash) {
+    return static_cast<int>((hash ^ (hash >> 32)) & (IDENTITY_HASH_BUCKETS - 1));
+}
+
+// Pool index of a hash, -1 if it is not in the pool; the table is never more than half full
+static int findIdentity(const IdentityMap& map, uint64_t hash) {
+    for (int b = firstBucket(hash); map.buckets[b] >= 0; b = (b + 1) & (IDENTITY_HASH_BUCKETS - 1)) {
+        if (map.identities[map.buckets[b]].hash == hash) return map.buckets[b];
+    }
+    return -1;
+}
+
+// Add a pool index to the hash table
+static void insertBucket(IdentityMap& map, int identity) {
+    int b = firstBucket(map.identities[identity].hash);
+    while (map.buckets[b] >= 0) b = (b + 1) & (IDENTITY_HASH_BUCKETS - 1);
+    map.buckets[b] = static_cast<int16_t>(identity);
+}
+
+// Take a pool entry for a new car: a free one, else the departed car seen longest ago; -1 if none is left
+static int allocateIdentity(IdentityMap& map, uint64_t hash, const char* driverName, const char* carName, double now) {
+    int identity = -1;
+    bool recycled = false;
+    if (map.count < IDENTITY_MAX) {
+        identity = map.count++;
+    } else {
+        for (int i = 0; i < IDENTITY_MAX; ++i) {
+            const ParticipantIdentity& candidate = map.identities[i];
+            if (candidate.slot >= 0 || map.claimed[i] == map.generation) continue;
+            if (identity < 0 || candidate.lastSeen < map.identities[identity].lastSeen) identity = i;
+        }
+        if (identity < 0) return -1;
+        recycled = true;
+    }
+
+    ParticipantIdentity& entry = map.identities[identity];
+    entry.hash = hash;
+    strncpy(entry.driverName, driverName, STRING_LENGTH_MAX - 1);
+    entry.driverName[STRING_LENGTH_MAX - 1] = '\0';
+    strncpy(entry.carName, carName, STRING_LENGTH_MAX - 1);
+    entry.carName[STRING_LENGTH_MAX - 1] = '\0';
+    entry.slot = -1;
+    entry.stint = 0;
+    entry.rejoins = 0;
+    entry.lastSeen = now;
+
+    // Recycling is rare, so the table is rebuilt rather than supporting deletion
+    if (recycled) {
+        for (int b = 0; b < IDENTITY_HASH_BUCKETS; ++b) map.buckets[b] = -1;
+        for (int i = 0; i < map.count; ++i) insertBucket(map, i);
+    } else {
+        insertBucket(map, identity);
+    }
+    return identity;
+}
+
+// Identity of the car in a slot, added to the pool if new. Two cars with the same driver
+// and car name are told apart by the order of their slots.
+static int claimIdentity(IdentityMap& map, const ParticipantTable& participants, int slot, double now) {
+    const uint64_t baseHash = identityHash(participants.driverName[slot], participants.carName[slot]);
+    for (uint64_t duplicate = 0; duplicate < STORED_PARTICIPANTS_MAX; ++duplicate) {
+        const uint64_t hash = duplicate == 0 ? baseHash : fnv1a64(&duplicate, sizeof(duplicate), baseHash);
+        int identity = findIdentity(map, hash);
+        if (identity < 0) {
+            identity = allocateIdentity(map, hash, participants.driverName[slot], participants.carName[slot], now);
+            if (identity < 0) return -1;
+        }
+        if (map.claimed[identity] != map.generation) {
+            map.claimed[identity] = map.generation;
+            return identity;
+        }
+    }
+    return -1;
+}
+
+// Record a field change of the latest update
+static void addEvent(IdentityMap& map, int type, int identity, int slot) {
+    if (map.numEvents < IDENTITY_EVENTS_MAX) map.events[map.numEvents++] = {type, identity, slot};
+}
+
+// Reconcile the active slots of the participant table with the pool and record joins, leaves and rejoins
+void updateIdentityMap(IdentityMap& map, const ParticipantTable& participants, double now) {
+    const int count = participants.count;
+    const bool namesUnchanged = map.hasSample && participants.nameChanges == map.lastNameChanges;
+    map.numEvents = 0;
+    ++map.generation;
+
+    // Slots still holding the same car keep their identity without a lookup; claiming these
+    // first keeps a car that just became active from taking one of them as a duplicate
+    int next[STORED_PARTICIPANTS_MAX];
+    for (int i = 0; i < count; ++i) {
+        next[i] = -1;
+        if (!participants.active[i] || !namesUnchanged || i >= map.numSlots || map.slotIdentity[i] < 0) continue;
+        next[i] = map.slotIdentity[i];
+        map.claimed[next[i]] = map.generation;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (participants.active[i] && next[i] < 0) next[i] = claimIdentity(map, participants, i, now);
+    }
+
+    // Cars of the previous sample that were not claimed again have left
+    for (int s = 0; s < map.numSlots; ++s) {
+        const int identity = map.slotIdentity[s];
+        if (identity < 0 || map.claimed[identity] == map.generation) continue;
+        ParticipantIdentity& entry = map.identities[identity];
+        if (entry.slot != s) continue;
+        entry.slot = -1;
+        --map.present;
+        ++map.leaves;
+        addEvent(map, IDENTITY_LEAVE, identity, s);
+    }
+
+    // Then joins, rejoins and cars that only moved to another slot
+    for (int i = 0; i < count; ++i) {
+        const int identity = next[i];
+        if (identity < 0) continue;
+        ParticipantIdentity& entry = map.identities[identity];
+        if (entry.slot < 0) {
+            const bool isNew = entry.stint == 0;
+            entry.stint = ++map.nextStint;
+            ++map.present;
+            if (isNew) {
+                ++map.joins;
+            } else {
+                ++entry.rejoins;
+                ++map.rejoins;
+            }
+            addEvent(map, isNew ? IDENTITY_JOIN : IDENTITY_REJOIN, identity, i);
+        } else if (entry.slot != i) {
+            ++map.moves;
+        }
+        entry.slot = i;
+        entry.lastSeen = now;
+    }
+
+    for (int i = 0; i < count; ++i) map.slotIdentity[i] = next[i];
+    for (int i = count; i < map.numSlots; ++i) map.slotIdentity[i] = -1;
+    map.numSlots = count;
+    map.lastNameChanges = participants.nameChanges;
+    map.hasSample = true;
+}
+
+// Identity of a participant slot, -1 if the slot is inactive
+int identityOfSlot(const IdentityMap& map, int slot) {
+    return slot >= 0 && slot < map.numSlots ? map.slotIdentity[slot] : -1;
+}
+
+// Copy the identity and stint of every slot in the latest sample
+void copySlotIdentities(const IdentityMap& map, SlotIdentities& slots) {
+    slots.numSlots = map.numSlots;
+    for (int s = 0; s < map.numSlots; ++s) {
+        const int identity = map.slotIdentity[s];
+        slots.identity[s] = identity;
+        slots.stint[s] = identity >= 0 ? map.identities[identity].stint : 0;
+    }
+}
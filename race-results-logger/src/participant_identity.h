@@ -0,0 +1,92 @@
+#ifndef PARTICIPANT_IDENTITY_H
+#define PARTICIPANT_IDENTITY_H
+
+#include <stdint.h>
+#include "SharedMemory.h"
+#include "participant_table.h"
+
+// Stable identities for the cars in the field.
+// Online lobbies move drivers between participant slots when someone joins or leaves, so
+// anything kept per slot across samples (crossing times, history) ends up on the wrong car.
+// Each car is identified by the hash of its driver and car name instead and given a dense
+// index from a fixed pool that it keeps for as long as the logger runs, including after it
+// leaves and rejoins. Reconciling the slots of a sample is one hash table probe per car, and
+// only needed at all when a name in the participant table changed or a car became active.
+
+// Pool and table sizes: room for a full field plus as many cars that have left, kept so a
+// rejoining car gets its index back; the least recently seen departed car is recycled first
+enum
+{
+  IDENTITY_MAX = STORED_PARTICIPANTS_MAX * 2,
+  IDENTITY_HASH_BUCKETS = IDENTITY_MAX * 2,
+  IDENTITY_EVENTS_MAX = IDENTITY_MAX
+};
+
+// Field changes reported by an update
+enum
+{
+  IDENTITY_JOIN = 0,                                  // first time in the field
+  IDENTITY_LEAVE = 1,
+  IDENTITY_REJOIN = 2                                 // back in the field after leaving
+};
+
+// One car of the pool
+struct ParticipantIdentity {
+    uint64_t hash;                                    // driver and car name
+    char driverName[STRING_LENGTH_MAX];
+    char carName[STRING_LENGTH_MAX];
+    int slot;                                         // participant slot now   [ UNSET = -1 ] when not in the field
+    uint32_t stint;                                   // changes every time the car (re)enters the field
+    int rejoins;
+    double lastSeen;                                  // [ UNITS = seconds ] on the caller's clock
+};
+
+struct IdentityEvent {
+    int type;                                         // IDENTITY_JOIN, IDENTITY_LEAVE or IDENTITY_REJOIN
+    int identity;
+    int slot;                                         // slot joined, or slot left
+};
+
+// Identities of every car seen, with the slot to identity map of the latest sample
+struct IdentityMap {
+    int count;                                        // pool entries in use
+    int present;                                      // identities in the field now
+    int numSlots;                                     // slots reconciled in the latest sample
+    bool hasSample;
+    unsigned long lastNameChanges;                    // ParticipantTable::nameChanges at the latest sample
+    uint32_t nextStint;
+    uint32_t generation;                              // claim stamp of the current update
+    int slotIdentity[STORED_PARTICIPANTS_MAX];        // [ UNSET = -1 ] for inactive slots
+    ParticipantIdentity identities[IDENTITY_MAX];
+    uint32_t claimed[IDENTITY_MAX];                   // generation that last claimed the identity
+    int16_t buckets[IDENTITY_HASH_BUCKETS];           // open addressing on the hash, pool index or -1
+
+    // Changes found by the latest update, then totals since the last reset
+    IdentityEvent events[IDENTITY_EVENTS_MAX];
+    int numEvents;
+    unsigned long joins;
+    unsigned long leaves;
+    unsigned long rejoins;
+    unsigned long moves;                              // cars that kept their identity in another slot
+};
+
+// Identity and stint of each participant slot of one sample, for a thread that does not own the map
+struct SlotIdentities {
+    int numSlots;
+    int identity[STORED_PARTICIPANTS_MAX];            // [ UNSET = -1 ] for inactive slots
+    uint32_t stint[STORED_PARTICIPANTS_MAX];          // [ UNSET = 0 ] for inactive slots
+};
+
+// Forget every identity, e.g. before the first snapshot
+void resetIdentityMap(IdentityMap& map);
+
+// Reconcile the active slots of the participant table with the pool and record joins, leaves and rejoins
+void updateIdentityMap(IdentityMap& map, const ParticipantTable& participants, double now);
+
+// Identity of a participant slot, -1 if the slot is inactive
+int identityOfSlot(const IdentityMap& map, int slot);
+
+// Copy the identity and stint of every slot in the latest sample
+void copySlotIdentities(const IdentityMap& map, SlotIdentities& slots);
+
+#endif // PARTICIPANT_IDENTITY_H
@@ -0,0 +1,67 @@
+#include "participant_table.h"
+#include <string.h>
+#include "asset_ids.h"
+
+// Empty the table, e.g. before the first snapshot
+void resetParticipantTable(ParticipantTable& table) {
+    memset(&table, 0, sizeof(ParticipantTable));
+}
+
+// Copy one name into the cold table if it differs; true if it did
+static bool refreshName(char* stored, const char* name) {
+    if (strncmp(stored, name, STRING_LENGTH_MAX) == 0) return false;
+    strncpy(stored, name, STRING_LENGTH_MAX - 1);
+    stored[STRING_LENGTH_MAX - 1] = '\0';
+    return true;
+}
+
+// Refresh the table from a snapshot: hot columns in whole-field passes, names only where they changed
+void updateParticipantTable(ParticipantTable& table, const SharedMemory* sharedData) {
+    int count = sharedData->mNumParticipants;
+    if (count < 0) count = 0;
+    if (count > STORED_PARTICIPANTS_MAX) count = STORED_PARTICIPANTS_MAX;
+
+    // Slots that left the field read as inactive
+    for (int i = count; i < table.count; ++i) {
+        table.active[i] = 0;
+        table.classified[i] = 0;
+    }
+    table.count = count;
+    table.trackLength = sharedData->mTrackLength;
+
+    // Gather the strided ParticipantInfo fields once, then derive from the columns
+    for (int i = 0; i < count; ++i) {
+        const ParticipantInfo& info = sharedData->mParticipantInfo[i];
+        table.active[i] = info.mIsActive ? 1 : 0;
+        table.racePosition[i] = info.mRacePosition;
+        table.lapsCompleted[i] = info.mLapsCompleted;
+        table.lapDistance[i] = info.mCurrentLapDistance;
+    }
+    for (int i = 0; i < count; ++i) {
+        const unsigned int state = sharedData->mRaceStates[i];
+        table.raceState[i] = static_cast<uint8_t>(state);
+        table.pitMode[i] = static_cast<uint8_t>(sharedData->mPitModes[i]);
+        table.classified[i] = (state == RACESTATE_FINISHED) | (state == RACESTATE_DISQUALIFIED) |
+                              (state == RACESTATE_RETIRED) | (state == RACESTATE_DNF);
+    }
+    const float trackLength = table.trackLength;
+    for (int i = 0; i < count; ++i) {
+        table.raceDistance[i] = table.lapsCompleted[i] * trackLength + table.lapDistance[i];
+        table.speed[i] = sharedData->mSpeeds[i];
+        table.fastestLapTime[i] = sharedData->mFastestLapTimes[i];
+        table.lastLapTime[i] = sharedData->mLastLapTimes[i];
+    }
+
+    // Names rarely change mid-session; a slot reused by another car is the usual case
+    for (int i = 0; i < count; ++i) {
+        if (refreshName(table.driverName[i], sharedData->mParticipantInfo[i].mName)) ++table.nameChanges;
+        if (refreshName(table.carName[i], sharedData->mCarNames[i])) {
+            table.carId[i] = carAssetId(table.carName[i]);
+            ++table.nameChanges;
+        }
+        if (refreshName(table.carClass[i], sharedData->mCarClassNames[i])) {
+            table.carClassId[i] = carClassAssetId(table.carClass[i]);
+            ++table.nameChanges;
+        }
+    }
+}
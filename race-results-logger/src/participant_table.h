@@ -0,0 +1,47 @@
+#ifndef PARTICIPANT_TABLE_H
+#define PARTICIPANT_TABLE_H
+
+#include <stdint.h>
+#include "SharedMemory.h"
+
+// Structure-of-arrays mirror of the participant state in a snapshot.
+// ParticipantInfo interleaves a 64-byte name with a few numbers per car and the per-car
+// extras (race states, lap times, speeds, car names) live in separate arrays of
+// SharedMemory, so a whole-field test touches a cache line or more per car. Here every
+// number is its own contiguous column (64 cars of a column are one to four cache lines)
+// and the names sit in a cold table that is only rewritten when a name changes, so the
+// finished check, gap timing and result collection are branch-light passes over a few
+// columns.
+struct ParticipantTable {
+    int count;                                        // slots mirrored, mNumParticipants clamped to STORED_PARTICIPANTS_MAX
+    float trackLength;                                // [ UNITS = Metres ]
+
+    // Hot columns, indexed by participant slot and refreshed on every update
+    alignas(64) uint8_t active[STORED_PARTICIPANTS_MAX];
+    alignas(64) uint8_t classified[STORED_PARTICIPANTS_MAX];       // finished, disqualified, retired or DNF
+    alignas(64) uint8_t raceState[STORED_PARTICIPANTS_MAX];        // [ enum (Type#3) Race State ]
+    alignas(64) uint8_t pitMode[STORED_PARTICIPANTS_MAX];          // [ enum (Type#7) Pit Mode ]
+    alignas(64) uint32_t racePosition[STORED_PARTICIPANTS_MAX];    // [ UNSET = 0 ]
+    alignas(64) uint32_t lapsCompleted[STORED_PARTICIPANTS_MAX];
+    alignas(64) float lapDistance[STORED_PARTICIPANTS_MAX];        // [ UNITS = Metres ]
+    alignas(64) float raceDistance[STORED_PARTICIPANTS_MAX];       // [ UNITS = Metres ] since the start line
+    alignas(64) float speed[STORED_PARTICIPANTS_MAX];              // [ UNITS = Metres per-second ]
+    alignas(64) float fastestLapTime[STORED_PARTICIPANTS_MAX];     // [ UNITS = seconds ]   [ UNSET = -1.0f ]
+    alignas(64) float lastLapTime[STORED_PARTICIPANTS_MAX];        // [ UNITS = seconds ]   [ UNSET = -1.0f ]
+
+    // Cold columns, only copied (and the asset IDs resolved) when a slot's name changes
+    char driverName[STORED_PARTICIPANTS_MAX][STRING_LENGTH_MAX];
+    char carName[STORED_PARTICIPANTS_MAX][STRING_LENGTH_MAX];
+    char carClass[STORED_PARTICIPANTS_MAX][STRING_LENGTH_MAX];
+    uint32_t carId[STORED_PARTICIPANTS_MAX];          // [ UNSET = ASSET_ID_UNKNOWN ]
+    uint32_t carClassId[STORED_PARTICIPANTS_MAX];     // [ UNSET = ASSET_ID_UNKNOWN ]
+    unsigned long nameChanges;                        // cold rows rewritten since the last reset
+};
+
+// Empty the table, e.g. before the first snapshot
+void resetParticipantTable(ParticipantTable& table);
+
+// Refresh the table from a snapshot: hot columns in whole-field passes, names only where they changed
+void updateParticipantTable(ParticipantTable& table, const SharedMemory* sharedData);
+
+#endif // PARTICIPANT_TABLE_H
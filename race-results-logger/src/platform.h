@@ -0,0 +1,83 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SharedMemory.h"
+
+// Thin shims over the OS calls the logger needs, so the rest of the code
+// builds on any platform (Win32 in platform_win32.cpp, POSIX in platform_posix.cpp)
+
+// Mapping of the game's shared memory block
+struct SharedMemoryMapping {
+    void* handle;
+    const SharedMemory* data;
+};
+
+// Open the $pcars2$ mapping object; false if the game is not running
+bool openSharedMemory(SharedMemoryMapping& mapping);
+
+// Map the opened object read-only into this process
+bool mapSharedMemory(SharedMemoryMapping& mapping);
+
+// Unmap and close whatever was opened
+void closeSharedMemory(SharedMemoryMapping& mapping);
+
+// Read-only mapping of a whole file
+struct MappedFile {
+    void* handle;
+    void* mapping;
+    const void* data;
+    size_t size;
+};
+
+// Map a file read-only; false if it does not exist or is empty
+bool mapFile(const char* filename, MappedFile& file);
+
+// Unmap and close a mapped file; safe on one that is not mapped
+void unmapFile(MappedFile& file);
+
+// Writable shared memory object this process publishes for other local tools
+struct PublishedMemory {
+    void* handle;
+    void* data;
+    size_t size;
+};
+
+// Create the named shared memory object (POSIX gets a leading /) and map it read-write; false on failure
+bool createPublishedMemory(const char* name, size_t size, PublishedMemory& memory);
+
+// Unmap and close a published object; on POSIX its name is removed too; safe on one that is not mapped
+void closePublishedMemory(PublishedMemory& memory);
+
+// Play a WAV file without blocking
+bool playSound(const char* filename);
+
+// Sleep the calling thread
+void sleepMs(unsigned int milliseconds);
+
+// Ask for 'milliseconds' scheduler granularity so short sleeps are not rounded up (Win32 defaults to ~15.6 ms)
+void beginTimerResolution(unsigned int milliseconds);
+
+// Undo beginTimerResolution
+void endTimerResolution(unsigned int milliseconds);
+
+// Set the calling thread's priority to a SCHEDULING_PRIORITY_* level; false if the OS refused
+bool setThreadPriorityLevel(int level);
+
+// Run the calling thread only on the CPUs of a mask (bit n is CPU n); false if the OS refused or cannot pin threads
+bool setThreadAffinity(uint64_t mask);
+
+// CPU time used so far by the calling thread, in seconds
+double threadCpuSeconds();
+
+// CPU time used so far by the whole process, in seconds
+double processCpuSeconds();
+
+// Whether the black box dump hotkey (Ctrl+Shift+B) is down, wherever the focus is
+bool isBlackBoxHotkeyDown();
+
+// Error code of the last failed OS call
+unsigned long lastErrorCode();
+
+#endif // PLATFORM_H
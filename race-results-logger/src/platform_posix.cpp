@@ -0,0 +1,192 @@
+#include "platform.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include "scheduling.h"
+
+// POSIX shared memory object published by Wine/Proton bridges for the game's $pcars2$ mapping
+#define MAP_OBJECT_NAME "/$pcars2$"
+
+// Open the $pcars2$ mapping object; false if the game is not running
+bool openSharedMemory(SharedMemoryMapping& mapping) {
+    mapping.data = NULL;
+    int fd = shm_open(MAP_OBJECT_NAME, O_RDONLY, 0);
+    mapping.handle = fd < 0 ? NULL : reinterpret_cast<void*>(static_cast<intptr_t>(fd) + 1);
+    return mapping.handle != NULL;
+}
+
+// Map the opened object read-only into this process
+bool mapSharedMemory(SharedMemoryMapping& mapping) {
+    int fd = static_cast<int>(reinterpret_cast<intptr_t>(mapping.handle) - 1);
+    void* view = mmap(NULL, sizeof(SharedMemory), PROT_READ, MAP_SHARED, fd, 0);
+    mapping.data = view == MAP_FAILED ? NULL : static_cast<const SharedMemory*>(view);
+    return mapping.data != NULL;
+}
+
+// Unmap and close whatever was opened
+void closeSharedMemory(SharedMemoryMapping& mapping) {
+    if (mapping.data != NULL) munmap(const_cast<SharedMemory*>(mapping.data), sizeof(SharedMemory));
+    if (mapping.handle != NULL) close(static_cast<int>(reinterpret_cast<intptr_t>(mapping.handle) - 1));
+    mapping.data = NULL;
+    mapping.handle = NULL;
+}
+
+// Map a file read-only; false if it does not exist or is empty
+bool mapFile(const char* filename, MappedFile& file) {
+    file.handle = NULL;
+    file.mapping = NULL;
+    file.data = NULL;
+    file.size = 0;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* view = mmap(NULL, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (view == MAP_FAILED) return false;
+    file.mapping = view;
+    file.data = view;
+    file.size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+// Unmap and close a mapped file; safe on one that is not mapped
+void unmapFile(MappedFile& file) {
+    if (file.mapping != NULL) munmap(file.mapping, file.size);
+    file.handle = NULL;
+    file.mapping = NULL;
+    file.data = NULL;
+    file.size = 0;
+}
+
+// Create the named shared memory object (POSIX gets a leading /) and map it read-write; false on failure
+bool createPublishedMemory(const char* name, size_t size, PublishedMemory& memory) {
+    memory.handle = NULL;
+    memory.data = NULL;
+    memory.size = 0;
+    std::string* objectName = new std::string(std::string("/") + name);
+    int fd = shm_open(objectName->c_str(), O_CREAT | O_RDWR, 0644);
+    bool mapped = false;
+    if (fd >= 0 && ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        void* view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        mapped = view != MAP_FAILED;
+        if (mapped) memory.data = view;
+    }
+    if (fd >= 0) close(fd); // the mapping keeps the object open
+    if (!mapped) {
+        delete objectName;
+        return false;
+    }
+    memory.handle = objectName; // kept so closing can remove the name
+    memory.size = size;
+    return true;
+}
+
+// Unmap and close a published object; on POSIX its name is removed too; safe on one that is not mapped
+void closePublishedMemory(PublishedMemory& memory) {
+    if (memory.data != NULL) munmap(memory.data, memory.size);
+    if (memory.handle != NULL) {
+        std::string* objectName = static_cast<std::string*>(memory.handle);
+        shm_unlink(objectName->c_str());
+        delete objectName;
+    }
+    memory.handle = NULL;
+    memory.data = NULL;
+    memory.size = 0;
+}
+
+// Play a WAV file without blocking; there is no system sound API to rely on here
+bool playSound(const char* filename) {
+    (void)filename;
+    errno = ENOTSUP;
+    return false;
+}
+
+// Sleep the calling thread
+void sleepMs(unsigned int milliseconds) {
+    usleep(static_cast<useconds_t>(milliseconds) * 1000);
+}
+
+// Sleeps are already fine-grained here
+void beginTimerResolution(unsigned int milliseconds) {
+    (void)milliseconds;
+}
+
+// Undo beginTimerResolution
+void endTimerResolution(unsigned int milliseconds) {
+    (void)milliseconds;
+}
+
+// Set the calling thread's priority to a SCHEDULING_PRIORITY_* level; false if the OS refused.
+// Linux keeps a nice value per thread; raising it above normal needs CAP_SYS_NICE.
+bool setThreadPriorityLevel(int level) {
+    static const int NICE_VALUES[] = {19, 10, 0, -5};
+    if (level < SCHEDULING_PRIORITY_IDLE || level > SCHEDULING_PRIORITY_HIGH) {
+        errno = EINVAL;
+        return false;
+    }
+#ifdef __linux__
+    return setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), NICE_VALUES[level]) == 0;
+#else
+    (void)NICE_VALUES;
+    errno = ENOTSUP;
+    return false;
+#endif
+}
+
+// Run the calling thread only on the CPUs of a mask (bit n is CPU n); false if the OS refused or cannot pin threads
+bool setThreadAffinity(uint64_t mask) {
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu = 0; cpu < 64; ++cpu) {
+        if (mask >> cpu & 1) CPU_SET(cpu, &cpus);
+    }
+    const int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (error != 0) errno = error;
+    return error == 0;
+#else
+    (void)mask;
+    errno = ENOTSUP;
+    return false;
+#endif
+}
+
+// CPU time of a POSIX clock, in seconds
+static double clockSeconds(clockid_t clock) {
+    struct timespec time;
+    if (clock_gettime(clock, &time) != 0) return 0.0;
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+// CPU time used so far by the calling thread, in seconds
+double threadCpuSeconds() {
+    return clockSeconds(CLOCK_THREAD_CPUTIME_ID);
+}
+
+// CPU time used so far by the whole process, in seconds
+double processCpuSeconds() {
+    return clockSeconds(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+// No global hotkeys without a window system; use the dump request file instead
+bool isBlackBoxHotkeyDown() {
+    return false;
+}
+
+// Error code of the last failed OS call
+unsigned long lastErrorCode() {
+    return static_cast<unsigned long>(errno);
+}
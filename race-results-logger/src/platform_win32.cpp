@@ -0,0 +1,153 @@
+#include "platform.h"
+#include <windows.h>
+#include <mmsystem.h>
+#include "scheduling.h"
+
+// Link with winmm
+#pragma comment(lib, "winmm.lib")
+
+// Name of the shared memory-mapped file (wide-character)
+#define MAP_OBJECT_NAME L"$pcars2$"
+
+// Open the $pcars2$ mapping object; false if the game is not running
+bool openSharedMemory(SharedMemoryMapping& mapping) {
+    mapping.data = NULL;
+    mapping.handle = OpenFileMappingW(PAGE_READONLY, FALSE, MAP_OBJECT_NAME);
+    return mapping.handle != NULL;
+}
+
+// Map the opened object read-only into this process
+bool mapSharedMemory(SharedMemoryMapping& mapping) {
+    mapping.data = (SharedMemory*)MapViewOfFile(mapping.handle, PAGE_READONLY, 0, 0, sizeof(SharedMemory));
+    return mapping.data != NULL;
+}
+
+// Unmap and close whatever was opened
+void closeSharedMemory(SharedMemoryMapping& mapping) {
+    if (mapping.data != NULL) UnmapViewOfFile(mapping.data);
+    if (mapping.handle != NULL) CloseHandle(mapping.handle);
+    mapping.data = NULL;
+    mapping.handle = NULL;
+}
+
+// Map a file read-only; false if it does not exist or is empty
+bool mapFile(const char* filename, MappedFile& file) {
+    file.handle = NULL;
+    file.mapping = NULL;
+    file.data = NULL;
+    file.size = 0;
+    HANDLE handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        CloseHandle(handle);
+        return false;
+    }
+    file.handle = handle;
+    file.mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (file.mapping != NULL) file.data = MapViewOfFile(file.mapping, FILE_MAP_READ, 0, 0, 0);
+    if (file.data == NULL) {
+        unmapFile(file);
+        return false;
+    }
+    file.size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+// Unmap and close a mapped file; safe on one that is not mapped
+void unmapFile(MappedFile& file) {
+    if (file.data != NULL) UnmapViewOfFile(file.data);
+    if (file.mapping != NULL) CloseHandle(file.mapping);
+    if (file.handle != NULL) CloseHandle(file.handle);
+    file.handle = NULL;
+    file.mapping = NULL;
+    file.data = NULL;
+    file.size = 0;
+}
+
+// Create the named shared memory object (POSIX gets a leading /) and map it read-write; false on failure
+bool createPublishedMemory(const char* name, size_t size, PublishedMemory& memory) {
+    memory.data = NULL;
+    memory.size = 0;
+    memory.handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, static_cast<DWORD>(size), name);
+    if (memory.handle == NULL) return false;
+    memory.data = MapViewOfFile(memory.handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (memory.data == NULL) {
+        closePublishedMemory(memory);
+        return false;
+    }
+    memory.size = size;
+    return true;
+}
+
+// Unmap and close a published object; on POSIX its name is removed too; safe on one that is not mapped
+void closePublishedMemory(PublishedMemory& memory) {
+    if (memory.data != NULL) UnmapViewOfFile(memory.data);
+    if (memory.handle != NULL) CloseHandle(memory.handle);
+    memory.handle = NULL;
+    memory.data = NULL;
+    memory.size = 0;
+}
+
+// Play a WAV file without blocking
+bool playSound(const char* filename) {
+    return PlaySoundA(filename, NULL, SND_FILENAME | SND_ASYNC) != FALSE;
+}
+
+// Sleep the calling thread
+void sleepMs(unsigned int milliseconds) {
+    Sleep(milliseconds);
+}
+
+// Ask for 'milliseconds' scheduler granularity so short sleeps are not rounded up (Win32 defaults to ~15.6 ms)
+void beginTimerResolution(unsigned int milliseconds) {
+    timeBeginPeriod(milliseconds);
+}
+
+// Undo beginTimerResolution
+void endTimerResolution(unsigned int milliseconds) {
+    timeEndPeriod(milliseconds);
+}
+
+// Set the calling thread's priority to a SCHEDULING_PRIORITY_* level; false if the OS refused
+bool setThreadPriorityLevel(int level) {
+    static const int PRIORITIES[] = {THREAD_PRIORITY_IDLE, THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_ABOVE_NORMAL};
+    if (level < SCHEDULING_PRIORITY_IDLE || level > SCHEDULING_PRIORITY_HIGH) return false;
+    return SetThreadPriority(GetCurrentThread(), PRIORITIES[level]) != FALSE;
+}
+
+// Run the calling thread only on the CPUs of a mask (bit n is CPU n); false if the OS refused or cannot pin threads
+bool setThreadAffinity(uint64_t mask) {
+    return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(mask)) != 0;
+}
+
+// Kernel plus user time of a GetThreadTimes/GetProcessTimes pair, in seconds
+static double filetimeSeconds(const FILETIME& kernel, const FILETIME& user) {
+    const ULONGLONG ticks = ((static_cast<ULONGLONG>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime) +
+                            ((static_cast<ULONGLONG>(user.dwHighDateTime) << 32) | user.dwLowDateTime);
+    return ticks * 1e-7; // 100 ns units
+}
+
+// CPU time used so far by the calling thread, in seconds
+double threadCpuSeconds() {
+    FILETIME created, exited, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user)) return 0.0;
+    return filetimeSeconds(kernel, user);
+}
+
+// CPU time used so far by the whole process, in seconds
+double processCpuSeconds() {
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0.0;
+    return filetimeSeconds(kernel, user);
+}
+
+// Whether the black box dump hotkey (Ctrl+Shift+B) is down, wherever the focus is
+bool isBlackBoxHotkeyDown() {
+    return (GetAsyncKeyState(VK_CONTROL) & 0x8000) && (GetAsyncKeyState(VK_SHIFT) & 0x8000) && (GetAsyncKeyState('B') & 0x8001);
+}
+
+// Error code of the last failed OS call
+unsigned long lastErrorCode() {
+    return GetLastError();
+}
@@ -1,245 +1,97 @@
-#include <windows.h>
-#include <mmsystem.h>
-#include <curl/curl.h>
 #include <stdio.h>
+#include <string.h>
 #include <string>
-#include <sstream>
 #include <fstream>
 #include <vector>
-#include <iomanip>
-#include <ctime>
-#include <algorithm>
 #include <filesystem>
+#include <chrono>
+#include <sstream>
+#include <mutex>
+#include <thread>
 #include "SharedMemory.h"
+#include "black_box.h"
+#include "compression.h"
+#include "config.h"
+#include "derived_publisher.h"
+#include "driving_stats.h"
+#include "gap_tracker.h"
+#include "logger.h"
+#include "logger_threads.h"
+#include "output.h"
+#include "participant_identity.h"
+#include "participant_table.h"
+#include "platform.h"
+#include "reference_lap.h"
+#include "result_hash.h"
+#include "result_wire.h"
+#include "results.h"
+#include "scheduling.h"
+#include "snapshot_exchange.h"
+#include "standings.h"
+#include "telemetry_pyramid.h"
+#include "track_map.h"
+#include "upload.h"
+
+// How often the CPU time and wakeups of the logger's threads are logged, besides at race end
+#define SCHEDULING_REPORT_SECONDS 600.0
+
+// Ask for a black box dump when the hotkey goes down or the request file appears
+static void checkBlackBoxCommands(BlackBox& box, bool& hotkeyWasDown, double now) {
+    const bool hotkeyDown = isBlackBoxHotkeyDown();
+    if (hotkeyDown && !hotkeyWasDown) requestBlackBoxDump(box, "hotkey", now);
+    hotkeyWasDown = hotkeyDown;
 
-// Link with winmm and curl
-#pragma comment(lib, "winmm.lib")
-#pragma comment(lib, "libcurl.lib")
-
-// Name of the shared memory-mapped file (wide-character)
-#define MAP_OBJECT_NAME L"$pcars2$"
-
-// Log file for console messages
-std::ofstream logFile;
-
-// Structure to hold race result data for sorting
-struct RaceResult {
-    unsigned int position;
-    std::string driverName;
-    std::string sessionName;
-    std::string carName;
-    std::string trackName;
-    std::string trackLayout;
-    std::string carClass;
-};
-
-// Structure to hold server config
-struct ServerConfig {
-    std::string server;
-    int port;
-    bool createJsonAtRaceStart;
-    bool disableUpload;
-};
-
-// Format time from seconds to MM:SS.sss (not used in CSV/JSON but kept for future use)
-std::string formatTime(float seconds) {
-    if (seconds <= 0 || seconds == -1.0f) return "N/A";
-    int minutes = static_cast<int>(seconds / 60);
-    float secs = seconds - (minutes * 60);
-    char buffer[16];
-    snprintf(buffer, sizeof(buffer), "%02d:%06.3f", minutes, secs);
-    return std::string(buffer);
-}
-
-// Log to both console and file
-void logMessage(const std::string& level, const std::string& message) {
-    time_t now = time(nullptr);
-    char timeStr[32];
-    strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", localtime(&now));
-    std::stringstream logEntry;
-    logEntry << timeStr << " [" << level << "] " << message << "\n";
-    printf("%s", logEntry.str().c_str());
-    if (logFile.is_open()) {
-        logFile << logEntry.str();
-        logFile.flush();
-    }
-}
-
-// Get session name from mSessionState
-std::string getSessionName(unsigned int sessionState) {
-    switch (sessionState) {
-        case SESSION_INVALID: return "Invalid";
-        case SESSION_PRACTICE: return "Practice";
-        case SESSION_TEST: return "Test";
-        case SESSION_QUALIFY: return "Qualify";
-        case SESSION_FORMATION_LAP: return "Formation Lap";
-        case SESSION_RACE: return "Race";
-        case SESSION_TIME_ATTACK: return "Time Attack";
-        default: return "Unknown";
-    }
-}
-
-// Get race status from mRaceStates
-std::string getRaceStatus(unsigned int raceState) {
-    switch (raceState) {
-        case RACESTATE_INVALID: return "Invalid";
-        case RACESTATE_NOT_STARTED: return "Not Started";
-        case RACESTATE_RACING: return "Racing";
-        case RACESTATE_FINISHED: return "Finished";
-        case RACESTATE_DISQUALIFIED: return "Disqualified";
-        case RACESTATE_RETIRED: return "Retired";
-        case RACESTATE_DNF: return "DNF";
-        default: return "Unknown";
-    }
-}
-
-// Read server config from config.properties
-ServerConfig readConfig() {
-    ServerConfig config = {"example.com", 3000, false, false};
-    std::ifstream configFile("config.properties");
-    if (!configFile.is_open()) {
-        logMessage("ERROR", "Failed to open config.properties, using default server: example.com:3000, createJsonAtRaceStart: no, disableUpload: no");
-        return config;
-    }
-    std::string line;
-    while (std::getline(configFile, line)) {
-        if (line.find("server=") == 0) {
-            config.server = line.substr(7);
-        } else if (line.find("port=") == 0) {
-            config.port = std::stoi(line.substr(5));
-        } else if (line.find("createJsonAtRaceStart=") == 0) {
-            config.createJsonAtRaceStart = (line.substr(22) == "yes");
-        } else if (line.find("disableUpload=") == 0) {
-            config.disableUpload = (line.substr(14) == "yes");
-        }
-    }
-    configFile.close();
-    logMessage("INFO", "Server config loaded: " + config.server + ":" + std::to_string(config.port) + ", createJsonAtRaceStart: " + (config.createJsonAtRaceStart ? "yes" : "no") + ", disableUpload: " + (config.disableUpload ? "yes" : "no"));
-    return config;
-}
-
-// Callback for libcurl to ignore response data
-size_t writeCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    return size * nmemb;
-}
-
-// Send JSON file content via HTTP POST
-bool sendJsonFile(const std::string& filename, const ServerConfig& config) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        logMessage("ERROR", "Failed to initialize curl for " + filename);
-        return false;
-    }
-
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        logMessage("ERROR", "Failed to read JSON file: " + filename);
-        curl_easy_cleanup(curl);
-        return false;
-    }
-
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string jsonData = buffer.str();
-    file.close();
-
-    std::string url = "http://" + config.server + ":" + std::to_string(config.port) + "/upload";
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, jsonData.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, jsonData.length());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-
-    struct curl_slist* headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-
-    CURLcode res = curl_easy_perform(curl);
-    long httpCode = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK) {
-        logMessage("ERROR", "Failed to send " + filename + ": " + curl_easy_strerror(res));
-        return false;
-    }
-    if (httpCode != 200) {
-        logMessage("ERROR", "Server returned HTTP " + std::to_string(httpCode) + " for " + filename);
-        return false;
+    namespace fs = std::filesystem;
+    std::error_code error;
+    if (!fs::exists(BLACK_BOX_REQUEST_FILE, error)) return;
+    std::string reason;
+    {
+        std::ifstream request(BLACK_BOX_REQUEST_FILE);
+        std::getline(request, reason);
     }
-
-    logMessage("INFO", "Successfully sent " + filename + " to server");
-    return true;
+    fs::remove(BLACK_BOX_REQUEST_FILE, error);
+    requestBlackBoxDump(box, reason.empty() ? "command" : reason, now);
 }
 
-// Process and send all JSON files in output/ and raceinfo/
-void processOutputFiles(const ServerConfig& config) {
-    if (config.disableUpload) {
-        logMessage("INFO", "Upload disabled, skipping processOutputFiles");
+// Count a finished race towards the season standings, then persist and export them
+static void updateStandings(Standings& standings, uint64_t resultHash, const std::vector<RaceResult>& results) {
+    if (!applyRaceResult(standings, resultHash, results)) {
+        logMessage("DEBUG", "Result " + formatHash(resultHash) + " already counted in the standings");
         return;
     }
-    namespace fs = std::filesystem;
-    if (!fs::exists("sent")) {
-        fs::create_directory("sent");
-        logMessage("INFO", "Created sent/ directory");
-    }
-    if (!fs::exists("output")) {
-        fs::create_directory("output");
-        logMessage("INFO", "Created output/ directory");
-    }
-    if (!fs::exists("raceinfo")) {
-        fs::create_directory("raceinfo");
-        logMessage("INFO", "Created raceinfo/ directory");
-    }
-
-    // Process files in both output/ and raceinfo/
-    std::vector<std::string> folders = {"output", "raceinfo"};
-    for (const auto& folder : folders) {
-        for (const auto& entry : fs::directory_iterator(folder)) {
-            if (entry.path().extension() != ".json") continue;
-
-            std::string filename = entry.path().string();
-            while (!sendJsonFile(filename, config)) {
-                logMessage("INFO", "Retrying " + filename + " in 15 seconds");
-                Sleep(15000); // Retry every 15 seconds
-            }
-
-            std::string sentFilename = "sent/" + entry.path().filename().string();
-            try {
-                fs::rename(filename, sentFilename);
-                logMessage("INFO", "Moved " + filename + " to " + sentFilename);
-            } catch (const fs::filesystem_error& e) {
-                logMessage("ERROR", "Failed to move " + filename + " to sent/: " + e.what());
-            }
-        }
-    }
+    saveStandings(STANDINGS_SNAPSHOT_FILE, standings);
+    saveStandingsJson(standings);
+    const std::vector<int> order = rankStandings(standings.drivers);
+    const StandingTally& leader = standings.drivers[order.front()];
+    logMessage("INFO", "Standings after " + std::to_string(standings.races) + " races: " + leader.driverName + " leads with " + std::to_string(leader.points) + " points");
 }
 
-// Generate timestamped filename (output/ or raceinfo/results_YYYYMMDD_HHMM.csv/json)
-std::string getResultFilename(const std::string& extension, bool createJsonAtRaceStart) {
-    time_t now = time(nullptr);
-    char timeStr[32];
-    std::string folder = createJsonAtRaceStart && extension == "json" ? "raceinfo" : "output";
-    strftime(timeStr, sizeof(timeStr), (folder + "/results_%Y%m%d_%H%M").c_str(), localtime(&now));
-    return std::string(timeStr) + "." + extension;
-}
+// Log race results to CSV and JSON
+void logResults(const SharedMemory* sharedData, const ParticipantTable& participants, const FieldGaps& gaps, FrameAnalytics& analytics, SeenResults& seenResults, Standings* standings, const CompressionDictionary* dictionary, bool enableCsv, const ServerConfig& config, bool isRaceStart = false) {
+    // Collect results
+    std::string sessionName = getSessionName(sharedData->mSessionState);
+    std::string trackName = getTrackName(sharedData);
+    std::string trackLayout = getTrackLayout(sharedData);
+    std::vector<RaceResult> results = collectResults(sharedData, participants, gaps);
 
-// Escape string for JSON
-std::string escapeJsonString(const std::string& input) {
-    std::string output;
-    for (char c : input) {
-        if (c == '"') output += "\\\"";
-        else if (c == '\\') output += "\\\\";
-        else output += c;
+    // Sort by position or carName
+    sortResults(results, config);
+
+    // A capture identical to one already written, by this run or an earlier one, is not written again;
+    // files still waiting in output/ and raceinfo/ are retried all the same
+    uint64_t resultHash = hashResults(sessionName, trackName, trackLayout, results);
+    if (isResultSeen(seenResults, resultHash)) {
+        logMessage("DEBUG", "Result " + formatHash(resultHash) + " already logged, skipping write");
+        processOutputFiles(config, dictionary);
+        return;
     }
-    return output;
-}
 
-// Log race results to CSV and JSON
-void logResults(const SharedMemory* sharedData, bool enableCsv, const ServerConfig& config, bool isRaceStart = false) {
-    std::string csvFilename = getResultFilename("csv", config.createJsonAtRaceStart);
-    std::string jsonFilename = getResultFilename("json", config.createJsonAtRaceStart);
+    std::string csvFilename = getResultFilename("csv", config.createJsonAtRaceStart, resultHash);
+    // Spool files are binary with resultFormat=binary, otherwise JSON, deflated against
+    // the shared dictionary when compressSpool is on
+    const bool compressSpool = !config.binaryResults && config.compressSpool && dictionary != NULL;
+    const char* spoolExtension = config.binaryResults ? "amsr" : compressSpool ? "json" COMPRESSED_SPOOL_EXTENSION : "json";
+    std::string jsonFilename = getResultFilename(spoolExtension, config.createJsonAtRaceStart, resultHash);
 
     // Ensure raceinfo/ folder exists for JSON if createJsonAtRaceStart is true
     namespace fs = std::filesystem;
@@ -248,55 +100,14 @@ void logResults(const SharedMemory* sharedData, bool enableCsv, const ServerConf
         logMessage("INFO", "Created raceinfo/ directory");
     }
 
-    // Collect results
-    std::vector<RaceResult> results;
-    std::string sessionName = getSessionName(sharedData->mSessionState);
-    std::string trackName = std::string(sharedData->mTranslatedTrackLocation);
-    if (trackName.empty()) trackName = std::string(sharedData->mTrackLocation);
-    std::string trackLayout = std::string(sharedData->mTranslatedTrackVariation);
-    if (trackLayout.empty()) trackLayout = std::string(sharedData->mTrackVariation);
-
-    for (int i = 0; i < sharedData->mNumParticipants && i < STORED_PARTICIPANTS_MAX; ++i) {
-        if (!sharedData->mParticipantInfo[i].mIsActive) continue;
-
-        RaceResult result;
-        result.position = sharedData->mParticipantInfo[i].mRacePosition;
-        result.driverName = std::string(sharedData->mParticipantInfo[i].mName);
-        result.sessionName = sessionName;
-        result.carName = std::string(sharedData->mCarNames[i]);
-        result.trackName = trackName;
-        result.trackLayout = trackLayout;
-        result.carClass = std::string(sharedData->mCarClassNames[i]);
-        results.push_back(result);
-    }
-
-    // Sort by position or carName
-    if (config.createJsonAtRaceStart && config.disableUpload) {
-        std::sort(results.begin(), results.end(), [](const RaceResult& a, const RaceResult& b) {
-            return a.carName < b.carName;
-        });
-    } else {
-        std::sort(results.begin(), results.end(), [](const RaceResult& a, const RaceResult& b) {
-            return a.position < b.position;
-        });
-    }
-
     // Write CSV if enabled
     if (enableCsv) {
         std::ofstream csvFile(csvFilename, std::ios::out); // Overwrite for new race
         if (!csvFile.is_open()) {
             logMessage("ERROR", "Failed to open CSV file: " + csvFilename);
         } else {
-            csvFile << "\"Session Name\",\"TrackName\",\"Position\",\"DriverName\",\"CarName\"\n";
             logMessage("INFO", "CSV file created: " + csvFilename);
-
-            for (const auto& result : results) {
-                csvFile << "\"" << result.sessionName << "\","
-                        << "\"" << result.trackName << "\","
-                        << result.position << ","
-                        << "\"" << result.driverName << "\","
-                        << "\"" << result.carName << "\"\n";
-            }
+            writeResultsCsv(csvFile, results);
             csvFile.close();
             logMessage("INFO", "CSV results logged to " + csvFilename + " for " + std::to_string(results.size()) + " participants");
         }
@@ -306,49 +117,53 @@ void logResults(const SharedMemory* sharedData, bool enableCsv, const ServerConf
 
     // Write JSON if not race start or if createJsonAtRaceStart is true
     if (!isRaceStart || config.createJsonAtRaceStart) {
-        std::ofstream jsonFile(jsonFilename, std::ios::out);
+        std::string jsonData;
+        if (config.binaryResults) {
+            encodeResultsWire(sessionName, trackName, trackLayout, resultHash, results, jsonData);
+        } else {
+            std::ostringstream json;
+            {
+                // Only the serialization holds up the analytics thread, not the file write and upload
+                std::lock_guard<std::mutex> lock(analytics.mutex);
+                flushDrivingStats(*analytics.drivingStats);
+                writeResultsJson(json, sessionName, trackName, trackLayout, resultHash, results, analytics.drivingStats);
+            }
+            jsonData = json.str();
+        }
+        if (compressSpool) {
+            std::string compressed;
+            if (!compressWithDictionary(jsonData, *dictionary, compressed)) {
+                logMessage("ERROR", "Failed to compress JSON for " + jsonFilename);
+                return;
+            }
+            logMessage("DEBUG", "JSON compressed from " + std::to_string(jsonData.size()) + " to " + std::to_string(compressed.size()) + " bytes");
+            jsonData.swap(compressed);
+        }
+
+        std::ofstream jsonFile(jsonFilename, std::ios::out | std::ios::binary);
         if (!jsonFile.is_open()) {
             logMessage("ERROR", "Failed to open JSON file: " + jsonFilename);
             return;
         }
-
-        jsonFile << "{\n";
-        jsonFile << "  \"Session Name\": \"" << escapeJsonString(sessionName) << "\",\n";
-        jsonFile << "  \"TrackName\": \"" << escapeJsonString(trackName) << "\",\n";
-        jsonFile << "  \"TrackLayout\": \"" << escapeJsonString(trackLayout) << "\",\n";
-        jsonFile << "  \"Drivers\": [\n";
-        for (size_t i = 0; i < results.size(); ++i) {
-            jsonFile << "    {\n";
-            jsonFile << "      \"Position\": " << results[i].position << ",\n";
-            jsonFile << "      \"DriverName\": \"" << escapeJsonString(results[i].driverName) << "\",\n";
-            jsonFile << "      \"CarName\": \"" << escapeJsonString(results[i].carName) << "\",\n";
-            jsonFile << "      \"CarClass\": \"" << escapeJsonString(results[i].carClass) << "\"\n";
-            jsonFile << "    }" << (i < results.size() - 1 ? "," : "") << "\n";
-        }
-        jsonFile << "  ]\n";
-        jsonFile << "}\n";
+        jsonFile.write(jsonData.data(), jsonData.size());
         jsonFile.close();
-        logMessage("INFO", "JSON results logged to " + jsonFilename + " for " + std::to_string(results.size()) + " participants");
+        markResultSeen(seenResults, resultHash);
+        logMessage("INFO", std::string(config.binaryResults ? "Binary" : "JSON") + " results logged to " + jsonFilename + " for " + std::to_string(results.size()) + " participants");
+        if (standings != NULL && !isRaceStart && sharedData->mSessionState == SESSION_RACE) {
+            updateStandings(*standings, resultHash, results);
+        }
         logMessage("DEBUG", "Shared memory data fetched for race results");
 
         // Play WAV file after writing files
-        if (!PlaySoundA("audio/racesavednotify.wav", NULL, SND_FILENAME | SND_ASYNC)) {
-            logMessage("ERROR", "Failed to play audio/racesavednotify.wav (error code: " + std::to_string(GetLastError()) + ")");
+        if (!playSound("audio/racesavednotify.wav")) {
+            logMessage("ERROR", "Failed to play audio/racesavednotify.wav (error code: " + std::to_string(lastErrorCode()) + ")");
         } else {
             logMessage("INFO", "Notification sound played for file write");
         }
     }
 
     // Send JSON files to server from output/ (race end) or raceinfo/ (race start)
-    processOutputFiles(config);
-}
-
-// Method to check if we should log JSON at start based on number of participants > 0
-bool shouldLogAtStart(const SharedMemory* localCopy, bool logged, const ServerConfig& config) {
-    if (config.createJsonAtRaceStart && localCopy->mNumParticipants > 0 && !logged) {
-        return true;
-    }
-    return false;
+    processOutputFiles(config, dictionary);
 }
 
 int main() {
@@ -365,55 +180,111 @@ int main() {
     logMessage("INFO", "CSV output " + std::string(enableCsv ? "enabled" : "disabled"));
 
     // Test WAV file at startup
-    if (!PlaySoundA("audio/startup.wav", NULL, SND_FILENAME | SND_ASYNC)) {
-        logMessage("ERROR", "Failed to play audio/startup.wav at startup (error code: " + std::to_string(GetLastError()) + ")");
+    if (!playSound("audio/startup.wav")) {
+        logMessage("ERROR", "Failed to play audio/startup.wav at startup (error code: " + std::to_string(lastErrorCode()) + ")");
     } else {
         logMessage("INFO", "Test notification sound played at startup");
     }
 
     // Initialize curl
-    curl_global_init(CURL_GLOBAL_ALL);
+    initUpload();
 
     // Read server config and process existing JSON files
     ServerConfig config = readConfig();
-    processOutputFiles(config);
+
+    // Dictionary shared with the server for compressed spool files and uploads
+    CompressionDictionary dictionary;
+    const CompressionDictionary* activeDictionary = NULL;
+    if (config.compressSpool || config.compressUpload) {
+        if (loadDictionary(config.dictionary, dictionary)) {
+            activeDictionary = &dictionary;
+            logMessage("INFO", "Compression dictionary loaded: " + config.dictionary + " (" + std::to_string(dictionary.data.size()) + " bytes)");
+        } else {
+            logMessage("ERROR", "Failed to load compression dictionary " + config.dictionary + ", spool files and uploads stay uncompressed");
+        }
+    }
+    processOutputFiles(config, activeDictionary);
+
+    // Hashes of results already written, so identical captures are not written or uploaded again
+    SeenResults seenResults = loadSeenResults("log/seen_results.txt");
+
+    // Season standings, updated from every finished race this logger writes
+    Standings* standings = NULL;
+    if (config.standings) {
+        standings = new Standings;
+        loadStandings(STANDINGS_SNAPSHOT_FILE, *standings);
+        logMessage("INFO", "Standings loaded: " + std::to_string(standings->races) + " races, " + std::to_string(standings->drivers.size()) + " drivers, " + std::to_string(standings->classes.size()) + " classes");
+    }
 
     // Retry shared memory connection
-    HANDLE fileHandle = NULL;
+    SharedMemoryMapping mapping = {NULL, NULL};
     const SharedMemory* sharedData = NULL;
-    SharedMemory* localCopy = NULL;
+    const SharedMemory* localCopy = NULL;
 
     while (true) {
-        fileHandle = OpenFileMappingW(PAGE_READONLY, FALSE, MAP_OBJECT_NAME);
-        if (fileHandle == NULL) {
-            logMessage("INFO", "Failed to open shared memory, retrying in 30 seconds (error code: " + std::to_string(GetLastError()) + ")");
-            Sleep(30000); // Retry every 30 seconds
+        if (!openSharedMemory(mapping)) {
+            logMessage("INFO", "Failed to open shared memory, retrying in 30 seconds (error code: " + std::to_string(lastErrorCode()) + ")");
+            sleepMs(30000); // Retry every 30 seconds
             continue;
         }
 
-        sharedData = (SharedMemory*)MapViewOfFile(fileHandle, PAGE_READONLY, 0, 0, sizeof(SharedMemory));
-        if (sharedData == NULL) {
-            logMessage("INFO", "Failed to map shared memory, retrying in 30 seconds (error code: " + std::to_string(GetLastError()) + ")");
-            CloseHandle(fileHandle);
-            fileHandle = NULL;
-            Sleep(30000); // Retry every 30 seconds
+        if (!mapSharedMemory(mapping)) {
+            logMessage("INFO", "Failed to map shared memory, retrying in 30 seconds (error code: " + std::to_string(lastErrorCode()) + ")");
+            closeSharedMemory(mapping);
+            sleepMs(30000); // Retry every 30 seconds
             continue;
         }
+        sharedData = mapping.data;
 
         logMessage("INFO", "Connection established to shared memory");
         break;
     }
 
-    localCopy = new SharedMemory;
+    // Live gaps are timed against a monotonic clock started with the logger
+    TrackMap* trackMap = new TrackMap;
+    resetTrackMap(*trackMap);
+    FrameAnalytics analytics;
+    analytics.drivingStats = new DrivingStats;
+    resetDrivingStats(*analytics.drivingStats);
+    analytics.telemetry = new TelemetryPyramid;
+    createTelemetryPyramid(*analytics.telemetry);
+    analytics.lapDelta = new LapDelta;
+    analytics.lapDelta->trackLength = -1.0f; // matches no snapshot, so the first frame loads the reference
+    analytics.referenceFile = {NULL, NULL, NULL, 0};
+    analytics.keepReferenceLaps = true;
+    analytics.derivedState = NULL;
+    analytics.derivedViewed = new DerivedViewedCar;
+    analytics.participants = new ParticipantTable;
+    resetParticipantTable(*analytics.participants);
+    analytics.identities = new IdentityMap;
+    resetIdentityMap(*analytics.identities);
+    analytics.gaps = new GapTracker;
+    resetGapTracker(*analytics.gaps);
+    analytics.fieldTime = -1.0;
+    FieldView* field = new FieldView;
+    resetParticipantTable(field->participants);
+    field->time = -1.0;
+    DerivedField* derivedField = new DerivedField;
+    const auto clockStart = std::chrono::steady_clock::now();
 
     // Check version
     if (sharedData->mVersion != SHARED_MEMORY_VERSION) {
         logMessage("ERROR", "Data version mismatch. Expected " + std::to_string(SHARED_MEMORY_VERSION) + ", got " + std::to_string(sharedData->mVersion));
-        UnmapViewOfFile(sharedData);
-        CloseHandle(fileHandle);
+        closeSharedMemory(mapping);
         logFile.close();
-        delete localCopy;
-        curl_global_cleanup();
+        delete trackMap;
+        delete analytics.drivingStats;
+        destroyTelemetryPyramid(*analytics.telemetry);
+        delete analytics.telemetry;
+        delete analytics.lapDelta;
+        delete analytics.derivedViewed;
+        delete analytics.participants;
+        delete analytics.identities;
+        delete analytics.gaps;
+        delete field;
+        delete derivedField;
+        delete standings;
+        cleanupUpload();
         return 1;
     }
 
@@ -425,22 +296,62 @@ int main() {
     unsigned int lastSessionStateDebug = 0;
     unsigned int lastRaceState = 0;
 
+    // The sampler thread copies every game frame; the analytics and black box threads take every
+    // one of them and this thread takes the latest every 500 ms for detection, track map and logging
+    SnapshotExchange* exchange = new SnapshotExchange;
+    createSnapshotExchange(*exchange);
+
+    // Every thread but the sampler runs at the background priority, and each counts its wakeups and CPU time
+    SchedulingStats* scheduling = new SchedulingStats;
+    resetSchedulingStats(*scheduling, secondsSince(clockStart), processCpuSeconds());
+    const ThreadSchedule samplerSchedule = {"sampler", config.samplerPriority, config.samplerCpus, scheduling, addSchedulingThread(*scheduling, "sampler")};
+    const ThreadSchedule analyticsSchedule = {"analytics", config.backgroundPriority, config.backgroundCpus, scheduling, addSchedulingThread(*scheduling, "analytics")};
+    const ThreadSchedule detectionSchedule = {"detection", config.backgroundPriority, config.backgroundCpus, scheduling, addSchedulingThread(*scheduling, "detection")};
+    const int detectionConsumer = addSnapshotConsumer(*exchange, "detection");
+    const int analyticsConsumer = addSnapshotConsumer(*exchange, "analytics");
+    BlackBox* blackBox = NULL;
+    std::thread blackBoxThread;
+    if (config.blackBoxMinutes > 0) {
+        blackBox = new BlackBox;
+        createBlackBox(*blackBox, config.blackBoxMemoryMB, config.blackBoxMinutes, config.blackBoxCollision);
+        const ThreadSchedule blackBoxSchedule = {"blackbox", config.backgroundPriority, config.backgroundCpus, scheduling, addSchedulingThread(*scheduling, "blackbox")};
+        blackBoxThread = std::thread(runBlackBox, exchange, addSnapshotConsumer(*exchange, "blackbox"), blackBox, clockStart, blackBoxSchedule);
+    }
+    bool blackBoxHotkeyDown = false;
+
+    // Standings, gaps and the viewed car's laps for overlays and dashboards, so they need not map $pcars2$ themselves
+    PublishedMemory derivedMemory = {NULL, NULL, 0};
+    if (config.derivedState) {
+        if (createPublishedMemory(DERIVED_STATE_NAME, sizeof(DerivedState), derivedMemory)) {
+            analytics.derivedState = static_cast<DerivedState*>(derivedMemory.data);
+            initDerivedState(analytics.derivedState);
+            *derivedField = analytics.derivedState->field;
+            *analytics.derivedViewed = analytics.derivedState->viewed;
+            logMessage("INFO", std::string("Publishing derived state as ") + DERIVED_STATE_NAME + " (" + std::to_string(sizeof(DerivedState)) + " bytes)");
+        } else {
+            logMessage("ERROR", std::string("Failed to create ") + DERIVED_STATE_NAME + ", error " + std::to_string(lastErrorCode()));
+        }
+    }
+    SamplerPacing pacing;
+    resetSamplerPacing(pacing, SAMPLER_POLL_MS, static_cast<unsigned int>(config.idlePollMs), config.gameScheduling, secondsSince(clockStart));
+    std::thread samplerThread(runSampler, sharedData, exchange, clockStart, samplerSchedule, pacing, static_cast<unsigned int>(config.timerResolutionMs));
+    std::thread analyticsThread(runAnalytics, exchange, analyticsConsumer, &analytics, analyticsSchedule);
+    enterThreadSchedule(detectionSchedule);
+    double lastDetection = -DETECTION_INTERVAL_SECONDS;
+    double lastSchedulingReport = secondsSince(clockStart);
+
     while (true) {
-        // Skip if writing is in progress (odd sequence number)
-        if (sharedData->mSequenceNumber % 2) {
-            continue;
+        double now = 0.0;
+        localCopy = acquireDetectionSnapshot(*exchange, detectionConsumer, detectionSchedule, clockStart, lastDetection, &now);
+        if (now - lastSchedulingReport >= SCHEDULING_REPORT_SECONDS) {
+            logMessage("INFO", "Scheduling: " + formatSchedulingReport(*scheduling, now, processCpuSeconds()));
+            lastSchedulingReport = now;
         }
+        if (localCopy == NULL) continue;
+        lastDetection = now;
 
-        // Copy shared memory with error handling
-        try {
-            memcpy(localCopy, sharedData, sizeof(SharedMemory));
-            if (localCopy->mSequenceNumber != sharedData->mSequenceNumber) {
-                logMessage("DEBUG", "Sequence number mismatch, skipping");
-                continue;
-            }
-        } catch (...) {
-            logMessage("ERROR", "Exception during shared memory copy");
-            continue;
+        if (blackBox != NULL) {
+            checkBlackBoxCommands(*blackBox, blackBoxHotkeyDown, now);
         }
 
         // Debug logging for state changes
@@ -473,25 +384,40 @@ int main() {
             }
         }
 
+        // The analytics thread keeps the field and its live gaps up to date on every frame; take a copy
+        readFieldView(analytics, *field, *derivedField, localCopy, now);
+        if (field->time < 0.0) {
+            releaseSnapshot(*exchange, detectionConsumer);
+            continue;
+        }
+
+        // Accumulate racing-line samples and trajectories for the track map
+        updateTrackMap(*trackMap, localCopy, field->slots);
+
         // Detect if we should log at start based on number of participants > 0
         if (shouldLogAtStart(localCopy, raceStarted, config)) {
             logMessage("INFO", "Number of participants > 0, logging results");
-            logResults(localCopy, enableCsv, config, true);
+            logResults(localCopy, field->participants, field->gaps, analytics, seenResults, standings, activeDictionary, enableCsv, config, true);
             raceStarted = true;
         }
 
         // Detect race end (session is Race and all participants finished)
         if (localCopy->mSessionState == SESSION_RACE && !raceEnded && !config.createJsonAtRaceStart) {
-            bool allFinished = true;
-            for (int i = 0; i < localCopy->mNumParticipants && i < STORED_PARTICIPANTS_MAX; ++i) {
-                if (localCopy->mParticipantInfo[i].mIsActive && localCopy->mRaceStates[i] != RACESTATE_FINISHED && localCopy->mRaceStates[i] != RACESTATE_DISQUALIFIED && localCopy->mRaceStates[i] != RACESTATE_RETIRED && localCopy->mRaceStates[i] != RACESTATE_DNF) {
-                    allFinished = false;
-                    break;
-                }
-            }
-            if (allFinished) {
+            if (allParticipantsFinished(field->participants)) {
                 logMessage("INFO", "Race ends");
-                logResults(localCopy, enableCsv, config);
+                if (blackBox != NULL && isResultDisputed(field->participants)) {
+                    requestBlackBoxDump(*blackBox, "disputed result", now);
+                }
+                logResults(localCopy, field->participants, field->gaps, analytics, seenResults, standings, activeDictionary, enableCsv, config);
+                saveTrackMap(*trackMap);
+                {
+                    std::lock_guard<std::mutex> lock(analytics.mutex);
+                    saveTelemetry(*analytics.telemetry, getTrackName(localCopy), getTrackLayout(localCopy));
+                }
+                logSnapshotExchangeStats(*exchange);
+                logMessage("INFO", "Scheduling: " + formatSchedulingReport(*scheduling, now, processCpuSeconds()));
+                lastSchedulingReport = now;
+                logMessage("INFO", "Participants: " + std::to_string(field->identities) + " identities, " + std::to_string(field->joins) + " joins, " + std::to_string(field->leaves) + " leaves, " + std::to_string(field->rejoins) + " rejoins, " + std::to_string(field->moves) + " slot moves");
                 raceEnded = true;
             }
         }
@@ -503,15 +429,40 @@ int main() {
             raceStarted = false;
         }
 
-        Sleep(500); // Check every 500ms
+        releaseSnapshot(*exchange, detectionConsumer);
     }
 
     // Cleanup
-    UnmapViewOfFile(sharedData);
-    CloseHandle(fileHandle);
-    delete localCopy;
+    stopSnapshotExchange(*exchange);
+    samplerThread.join();
+    analyticsThread.join();
+    if (blackBoxThread.joinable()) blackBoxThread.join();
+    logSnapshotExchangeStats(*exchange);
+    logMessage("INFO", "Scheduling: " + formatSchedulingReport(*scheduling, secondsSince(clockStart), processCpuSeconds()));
+    destroySnapshotExchange(*exchange);
+    delete exchange;
+    delete scheduling;
+    if (blackBox != NULL) {
+        destroyBlackBox(*blackBox);
+        delete blackBox;
+    }
+    closePublishedMemory(derivedMemory);
+    closeSharedMemory(mapping);
+    delete trackMap;
+    delete analytics.drivingStats;
+    destroyTelemetryPyramid(*analytics.telemetry);
+    delete analytics.telemetry;
+    unmapFile(analytics.referenceFile);
+    delete analytics.lapDelta;
+    delete analytics.derivedViewed;
+    delete analytics.participants;
+    delete analytics.identities;
+    delete analytics.gaps;
+    delete field;
+    delete derivedField;
+    delete standings;
     logFile.close();
-    curl_global_cleanup();
+    cleanupUpload();
     logMessage("INFO", "AMS2 Race Logger stopped");
 
     printf("Press Enter to exit...\n");
@@ -0,0 +1,192 @@
+#include "reference_lap.h"
+#include <string.h>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include "logger.h"
+#include "output.h"
+#include "results.h"
+
+static const char REFERENCE_LAP_MAGIC[4] = {'A', 'M', 'S', 'L'};
+
+// Share of the grid a lap must have been recorded over to count, so laps joined mid-way are skipped
+static const float MIN_LAP_COVERAGE = 0.95f;
+
+// Start over for the track, layout and car in the snapshot, with no reference
+void resetLapDelta(LapDelta& lapDelta, const SharedMemory* sharedData) {
+    const int viewed = sharedData->mViewedParticipantIndex;
+    lapDelta.trackName = getTrackName(sharedData);
+    lapDelta.trackLayout = getTrackLayout(sharedData);
+    lapDelta.trackVariation = sharedData->mTrackVariation;
+    lapDelta.carName = viewed >= 0 && viewed < STORED_PARTICIPANTS_MAX ? sharedData->mCarNames[viewed] : "";
+    lapDelta.trackLength = sharedData->mTrackLength;
+    lapDelta.points = 0;
+    if (lapDelta.trackLength > 0.0f) {
+        const int points = static_cast<int>(std::ceil(lapDelta.trackLength / REFERENCE_LAP_SPACING)) + 1;
+        lapDelta.points = points < REFERENCE_LAP_POINTS_MAX ? points : REFERENCE_LAP_POINTS_MAX;
+    }
+    lapDelta.lap = 0;
+    lapDelta.lapInvalidated = true;
+    lapDelta.recordedPoints = 0;
+    lapDelta.lastDistance = 0.0f;
+    lapDelta.lastTime = 0.0f;
+    lapDelta.sessionBestTime = 0.0f;
+    lapDelta.loaded = {NULL, 0, 0.0f};
+    lapDelta.reference = {NULL, 0, 0.0f};
+    lapDelta.delta = 0.0f;
+    lapDelta.hasDelta = false;
+    lapDelta.lastLapTime = -1.0f;
+    lapDelta.lastLapDelta = 0.0f;
+    lapDelta.lastLapHasDelta = false;
+    lapDelta.lastLapCounted = false;
+}
+
+// Whether the snapshot still shows the same track, layout and car
+bool lapDeltaMatches(const LapDelta& lapDelta, const SharedMemory* sharedData) {
+    const int viewed = sharedData->mViewedParticipantIndex;
+    if (viewed < 0 || viewed >= STORED_PARTICIPANTS_MAX) return true; // nothing to time, keep what we have
+    return sharedData->mTrackLength == lapDelta.trackLength &&
+           strncmp(sharedData->mCarNames[viewed], lapDelta.carName.c_str(), STRING_LENGTH_MAX) == 0 &&
+           strncmp(sharedData->mTrackVariation, lapDelta.trackVariation.c_str(), STRING_LENGTH_MAX) == 0;
+}
+
+// reference/<Track>_<Layout>_<Car>.lap for the current combination
+std::string referenceLapFilename(const LapDelta& lapDelta) {
+    return "reference/" + sanitizeFilename(lapDelta.trackName) + "_" + sanitizeFilename(lapDelta.trackLayout) + "_" +
+           sanitizeFilename(lapDelta.carName) + REFERENCE_LAP_EXTENSION;
+}
+
+// Use a reference file's contents, e.g. from a file mapping, in place; false if it does not fit this track.
+// The data must stay valid until detachReferenceLap or resetLapDelta.
+bool attachReferenceLap(LapDelta& lapDelta, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    if (size < REFERENCE_LAP_HEADER_SIZE || memcmp(bytes, REFERENCE_LAP_MAGIC, sizeof(REFERENCE_LAP_MAGIC)) != 0) return false;
+    uint32_t version, points;
+    float spacing, trackLength, lapTime;
+    memcpy(&version, bytes + 4, 4);
+    memcpy(&points, bytes + 8, 4);
+    memcpy(&spacing, bytes + 12, 4);
+    memcpy(&trackLength, bytes + 16, 4);
+    memcpy(&lapTime, bytes + 20, 4);
+    if (version != REFERENCE_LAP_VERSION || spacing != REFERENCE_LAP_SPACING || trackLength != lapDelta.trackLength ||
+        static_cast<int>(points) != lapDelta.points || lapTime <= 0.0f ||
+        size < REFERENCE_LAP_HEADER_SIZE + static_cast<size_t>(points) * sizeof(float)) {
+        return false;
+    }
+    lapDelta.loaded = {reinterpret_cast<const float*>(bytes + REFERENCE_LAP_HEADER_SIZE), lapDelta.points, lapTime};
+    if (lapDelta.reference.times == NULL || lapTime < lapDelta.reference.lapTime) lapDelta.reference = lapDelta.loaded;
+    return true;
+}
+
+// Stop using the attached reference file
+void detachReferenceLap(LapDelta& lapDelta) {
+    if (lapDelta.reference.times != NULL && lapDelta.reference.times == lapDelta.loaded.times) {
+        lapDelta.reference = {NULL, 0, 0.0f};
+        if (lapDelta.sessionBestTime > 0.0f) lapDelta.reference = {lapDelta.sessionBest, lapDelta.points, lapDelta.sessionBestTime};
+    }
+    lapDelta.loaded = {NULL, 0, 0.0f};
+}
+
+// Reference time at a lap distance, interpolated between the two grid points around it
+static float referenceTimeAt(const ReferenceLapTable& reference, float distance) {
+    const float position = distance * (1.0f / REFERENCE_LAP_SPACING);
+    int index = static_cast<int>(position);
+    if (index > reference.points - 2) index = reference.points - 2;
+    const float fraction = position - index;
+    return reference.times[index] + (reference.times[index + 1] - reference.times[index]) * fraction;
+}
+
+// Fill the grid points from the last recorded one up to 'distance', on the line to (distance, time)
+static void recordUpTo(LapDelta& lapDelta, float distance, float time, int lastPoint) {
+    const float slope = (time - lapDelta.lastTime) / (distance - lapDelta.lastDistance);
+    for (int g = lapDelta.recordedPoints; g <= lastPoint; ++g) {
+        lapDelta.recording[g] = lapDelta.lastTime + (g * REFERENCE_LAP_SPACING - lapDelta.lastDistance) * slope;
+    }
+    if (lastPoint + 1 > lapDelta.recordedPoints) lapDelta.recordedPoints = lastPoint + 1;
+    lapDelta.lastDistance = distance;
+    lapDelta.lastTime = time;
+}
+
+// Close the recorded lap at the line; true if it is a new best against every reference
+static bool finishLap(LapDelta& lapDelta, float lapTime) {
+    lapDelta.lastLapTime = lapTime;
+    lapDelta.lastLapHasDelta = lapDelta.reference.times != NULL;
+    lapDelta.lastLapDelta = lapDelta.lastLapHasDelta ? lapTime - lapDelta.reference.lapTime : 0.0f;
+    lapDelta.lastLapCounted = !lapDelta.lapInvalidated && lapDelta.recordedPoints >= lapDelta.points * MIN_LAP_COVERAGE;
+    if (!lapDelta.lastLapCounted) return false;
+    if (lapDelta.sessionBestTime > 0.0f && lapTime >= lapDelta.sessionBestTime) return false;
+
+    recordUpTo(lapDelta, lapDelta.trackLength, lapTime, lapDelta.points - 1);
+    memcpy(lapDelta.sessionBest, lapDelta.recording, lapDelta.points * sizeof(float));
+    lapDelta.sessionBestTime = lapTime;
+    if (lapDelta.reference.times != NULL && lapDelta.reference.lapTime <= lapTime) return false;
+    lapDelta.reference = {lapDelta.sessionBest, lapDelta.points, lapTime};
+    return true;
+}
+
+// Feed one game frame; returns LAP_DELTA_*
+int updateLapDelta(LapDelta& lapDelta, const SharedMemory* sharedData) {
+    const int viewed = sharedData->mViewedParticipantIndex;
+    if (lapDelta.points < 2 || viewed < 0 || viewed >= sharedData->mNumParticipants || viewed >= STORED_PARTICIPANTS_MAX) return LAP_DELTA_RUNNING;
+    const ParticipantInfo& info = sharedData->mParticipantInfo[viewed];
+    if (!info.mIsActive || info.mCurrentLap == 0) return LAP_DELTA_RUNNING;
+
+    int result = LAP_DELTA_RUNNING;
+    const int lapNumber = static_cast<int>(info.mCurrentLap);
+    if (lapNumber != lapDelta.lap) {
+        // Only a lap started at the line is a full lap; the first one seen may have been joined half way
+        const bool rollover = lapDelta.lap > 0 && lapNumber == lapDelta.lap + 1;
+        if (rollover) {
+            const float lastLap = sharedData->mLastLapTime;
+            const bool newBest = finishLap(lapDelta, lastLap > 0.0f && std::fabs(lastLap - lapDelta.lastTime) < 1.0f ? lastLap : lapDelta.lastTime);
+            result = newBest ? LAP_DELTA_NEW_BEST : LAP_DELTA_LAP_DONE;
+        }
+        lapDelta.lap = lapNumber;
+        lapDelta.lapInvalidated = !rollover;
+        lapDelta.recordedPoints = 0;
+        lapDelta.lastDistance = 0.0f;
+        lapDelta.lastTime = 0.0f;
+    }
+    if (sharedData->mLapInvalidated) lapDelta.lapInvalidated = true;
+
+    const float distance = info.mCurrentLapDistance;
+    const float time = sharedData->mCurrentTime;
+    if (time < 0.0f || distance < 0.0f || distance >= lapDelta.trackLength) {
+        lapDelta.hasDelta = false;
+        return result;
+    }
+    // Going backwards (a spin) keeps the times already recorded
+    if (distance > lapDelta.lastDistance && time >= lapDelta.lastTime) {
+        int lastPoint = static_cast<int>(distance * (1.0f / REFERENCE_LAP_SPACING));
+        if (lastPoint > lapDelta.points - 1) lastPoint = lapDelta.points - 1;
+        recordUpTo(lapDelta, distance, time, lastPoint);
+    }
+
+    lapDelta.hasDelta = lapDelta.reference.times != NULL;
+    if (lapDelta.hasDelta) lapDelta.delta = time - referenceTimeAt(lapDelta.reference, distance);
+    return result;
+}
+
+// Write the session best lap to a reference file
+bool saveReferenceLap(const LapDelta& lapDelta, const std::string& filename) {
+    if (lapDelta.sessionBestTime <= 0.0f) return false;
+    namespace fs = std::filesystem;
+    const fs::path folder = fs::path(filename).parent_path();
+    if (!folder.empty() && !fs::exists(folder)) {
+        fs::create_directories(folder);
+        logMessage("INFO", "Created " + folder.string() + "/ directory");
+    }
+    std::ofstream file(filename, std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        logMessage("ERROR", "Failed to open reference lap file: " + filename);
+        return false;
+    }
+    const uint32_t header[2] = {REFERENCE_LAP_VERSION, static_cast<uint32_t>(lapDelta.points)};
+    const float lapHeader[3] = {REFERENCE_LAP_SPACING, lapDelta.trackLength, lapDelta.sessionBestTime};
+    file.write(REFERENCE_LAP_MAGIC, sizeof(REFERENCE_LAP_MAGIC));
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(lapHeader), sizeof(lapHeader));
+    file.write(reinterpret_cast<const char*>(lapDelta.sessionBest), lapDelta.points * sizeof(float));
+    file.close();
+    return !file.fail();
+}
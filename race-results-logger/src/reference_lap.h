@@ -0,0 +1,98 @@
+#ifndef REFERENCE_LAP_H
+#define REFERENCE_LAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include "SharedMemory.h"
+
+// Reference laps are saved to reference/<Track>_<Layout>_<Car>.lap
+#define REFERENCE_LAP_EXTENSION ".lap"
+
+// Lap times are kept on a fixed distance grid, so the reference time at any lap distance is
+// one multiply to find the grid point and one interpolation, never a search along the lap
+enum
+{
+  REFERENCE_LAP_POINTS_MAX = 32768,                   // 32 km at 1 m
+  REFERENCE_LAP_VERSION = 1
+};
+static const float REFERENCE_LAP_SPACING = 1.0f;     // [ UNITS = metres ]
+
+// What a frame did to the lap delta
+enum
+{
+  LAP_DELTA_RUNNING = 0,
+  LAP_DELTA_LAP_DONE,                                 // a lap was completed, see lastLapTime and lastLapDelta
+  LAP_DELTA_NEW_BEST                                  // ... and it is the new best, to be saved with saveReferenceLap
+};
+
+// Reference file: "AMSL", u32 version, u32 points, f32 spacing, f32 track length, f32 lap time,
+// then one f32 time per grid point. Loaded files are used in place from a read-only mapping.
+enum
+{
+  REFERENCE_LAP_HEADER_SIZE = 24
+};
+
+// Elapsed lap time at every grid point of one lap
+struct ReferenceLapTable {
+    const float* times;                               // [ UNITS = seconds ]   [ UNSET = NULL ]
+    int points;
+    float lapTime;                                    // [ UNITS = seconds ]
+};
+
+// Live delta of the viewed car to the best lap of this track, layout and car:
+// the faster of the session best and the reference loaded from disk
+struct LapDelta {
+    std::string trackName;
+    std::string trackLayout;
+    std::string carName;
+    std::string trackVariation;                       // untranslated layout, to notice a change cheaply
+    float trackLength;
+    int points;                                       // grid points of this track
+
+    // Lap being recorded
+    int lap;                                          // [ UNSET = 0 ]
+    bool lapInvalidated;
+    int recordedPoints;                               // grid points filled so far
+    float lastDistance;
+    float lastTime;
+    float recording[REFERENCE_LAP_POINTS_MAX];
+
+    // Fastest complete, valid lap of this session
+    float sessionBest[REFERENCE_LAP_POINTS_MAX];
+    float sessionBestTime;                            // [ UNSET = 0.0f ]
+
+    ReferenceLapTable loaded;                         // reference mapped from disk
+    ReferenceLapTable reference;                      // the one the delta is taken against
+
+    float delta;                                      // [ UNITS = seconds ]   positive when slower than the reference
+    bool hasDelta;
+    float lastLapTime;                                // last completed lap and its delta at the line [ UNSET = -1.0f ]
+    float lastLapDelta;
+    bool lastLapHasDelta;                             // there was a reference to take lastLapDelta against
+    bool lastLapCounted;                              // valid and recorded from the line
+};
+
+// Start over for the track, layout and car in the snapshot, with no reference
+void resetLapDelta(LapDelta& lapDelta, const SharedMemory* sharedData);
+
+// Whether the snapshot still shows the same track, layout and car
+bool lapDeltaMatches(const LapDelta& lapDelta, const SharedMemory* sharedData);
+
+// reference/<Track>_<Layout>_<Car>.lap for the current combination
+std::string referenceLapFilename(const LapDelta& lapDelta);
+
+// Use a reference file's contents, e.g. from a file mapping, in place; false if it does not fit this track.
+// The data must stay valid until detachReferenceLap or resetLapDelta.
+bool attachReferenceLap(LapDelta& lapDelta, const void* data, size_t size);
+
+// Stop using the attached reference file
+void detachReferenceLap(LapDelta& lapDelta);
+
+// Feed one game frame; returns LAP_DELTA_*
+int updateLapDelta(LapDelta& lapDelta, const SharedMemory* sharedData);
+
+// Write the session best lap to a reference file
+bool saveReferenceLap(const LapDelta& lapDelta, const std::string& filename);
+
+#endif // REFERENCE_LAP_H
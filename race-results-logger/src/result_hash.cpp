@@ -0,0 +1,129 @@
+#include "result_hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include "logger.h"
+
+// FNV-1a 64-bit hash of a byte range, continuing from 'hash'
+uint64_t fnv1a64(const void* data, size_t length, uint64_t hash) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Hash a string field including its terminator, so "ab"+"c" and "a"+"bc" differ
+static uint64_t hashField(const std::string& value, uint64_t hash) {
+    return fnv1a64(value.c_str(), value.size() + 1, hash);
+}
+
+// Canonical content hash of a result: session, track and the set of driver records, with their
+// laps and lap times. Driver records are hashed on their own and combined in sorted order, so the
+// order the drivers were written in (by position or by car name) does not change the hash. Only
+// game data goes in, so a logger restarted on the same grid or results screen gets the same hash;
+// two races with the same field and order still differ in their lap times.
+uint64_t hashResults(const std::string& sessionName, const std::string& trackName,
+                     const std::string& trackLayout, const std::vector<RaceResult>& results) {
+    std::vector<uint64_t> driverHashes;
+    driverHashes.reserve(results.size());
+    for (const auto& result : results) {
+        // Live gaps and laps down are left out: the logger derives them from its own tracking, so they
+        // drift between otherwise identical captures and start over when the logger restarts
+        uint64_t hash = fnv1a64(&result.position, sizeof(result.position));
+        hash = hashField(result.driverName, hash);
+        hash = hashField(result.carName, hash);
+        hash = hashField(result.carClass, hash);
+        hash = fnv1a64(&result.lapsCompleted, sizeof(result.lapsCompleted), hash);
+        hash = fnv1a64(&result.fastestLapTime, sizeof(result.fastestLapTime), hash);
+        hash = fnv1a64(&result.lastLapTime, sizeof(result.lastLapTime), hash);
+        driverHashes.push_back(hash);
+    }
+    std::sort(driverHashes.begin(), driverHashes.end());
+
+    uint64_t hash = hashField(sessionName, FNV_OFFSET_BASIS);
+    hash = hashField(trackName, hash);
+    hash = hashField(trackLayout, hash);
+    return fnv1a64(driverHashes.data(), driverHashes.size() * sizeof(uint64_t), hash);
+}
+
+// Hash as a fixed-width lowercase hex string
+std::string formatHash(uint64_t hash) {
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+    return std::string(buffer);
+}
+
+// Forget the oldest hashes past SEEN_RESULTS_MAX
+static void trimSeenResults(SeenResults& seen) {
+    while (seen.order.size() > SEEN_RESULTS_MAX) {
+        seen.hashes.erase(seen.order.front());
+        seen.order.pop_front();
+    }
+}
+
+// Rewrite the file with the hashes still remembered; written aside and renamed over the old file,
+// so a crash leaves one or the other; false if the file could not be replaced
+static bool compactSeenResults(SeenResults& seen) {
+    const std::string temporary = seen.filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file.is_open()) {
+            logMessage("ERROR", "Failed to rewrite seen results file: " + temporary);
+            return false;
+        }
+        for (uint64_t hash : seen.order) file << formatHash(hash) << "\n";
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, seen.filename, error);
+    if (error) {
+        logMessage("ERROR", "Failed to replace " + seen.filename + ": " + error.message());
+        return false;
+    }
+    seen.fileLines = seen.order.size();
+    return true;
+}
+
+// Load the newest SEEN_RESULTS_MAX hashes of the seen-set from disk; a missing file is an empty set
+SeenResults loadSeenResults(const std::string& filename) {
+    SeenResults seen;
+    seen.filename = filename;
+    seen.fileLines = 0;
+    std::ifstream file(filename);
+    std::string line;
+    while (std::getline(file, line)) {
+        ++seen.fileLines;
+        if (line.size() < 16) continue;
+        const uint64_t hash = strtoull(line.c_str(), nullptr, 16);
+        if (seen.hashes.insert(hash).second) seen.order.push_back(hash);
+    }
+    file.close();
+    trimSeenResults(seen);
+    if (seen.fileLines > seen.order.size()) compactSeenResults(seen);
+    logMessage("INFO", "Loaded " + std::to_string(seen.hashes.size()) + " seen result hashes from " + filename);
+    return seen;
+}
+
+// Check whether a result with this hash was already written
+bool isResultSeen(const SeenResults& seen, uint64_t hash) {
+    return seen.hashes.count(hash) != 0;
+}
+
+// Record a hash, appending it to the file and forgetting the oldest past SEEN_RESULTS_MAX; false if it was already seen
+bool markResultSeen(SeenResults& seen, uint64_t hash) {
+    if (!seen.hashes.insert(hash).second) return false;
+    seen.order.push_back(hash);
+    trimSeenResults(seen);
+    if (seen.fileLines + 1 >= 2 * SEEN_RESULTS_MAX && compactSeenResults(seen)) return true;
+    std::ofstream file(seen.filename, std::ios::app);
+    if (!file.is_open()) {
+        logMessage("ERROR", "Failed to append to seen results file: " + seen.filename);
+        return true;
+    }
+    file << formatHash(hash) << "\n";
+    ++seen.fileLines;
+    return true;
+}
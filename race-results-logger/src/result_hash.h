@@ -0,0 +1,52 @@
+#ifndef RESULT_HASH_H
+#define RESULT_HASH_H
+
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "results.h"
+
+// FNV-1a 64-bit offset basis, the starting value of a new hash
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+// FNV-1a 64-bit hash of a byte range, continuing from 'hash'
+uint64_t fnv1a64(const void* data, size_t length, uint64_t hash = FNV_OFFSET_BASIS);
+
+// Canonical content hash of a result: session, track and the set of driver records, with their
+// laps and lap times. Driver records are hashed on their own and combined in sorted order, so the
+// order the drivers were written in (by position or by car name) does not change the hash. Only
+// game data goes in, so a logger restarted on the same grid or results screen gets the same hash;
+// two races with the same field and order still differ in their lap times.
+uint64_t hashResults(const std::string& sessionName, const std::string& trackName,
+                     const std::string& trackLayout, const std::vector<RaceResult>& results);
+
+// Hash as a fixed-width lowercase hex string
+std::string formatHash(uint64_t hash);
+
+// Result hashes remembered; older ones are forgotten, far more than a season of races and grids
+enum
+{
+  SEEN_RESULTS_MAX = 4096
+};
+
+// Hashes of the results written most recently, persisted one hex hash per line. New hashes are
+// appended; once the file holds twice SEEN_RESULTS_MAX lines it is rewritten with the newest.
+struct SeenResults {
+    std::string filename;
+    std::unordered_set<uint64_t> hashes;
+    std::deque<uint64_t> order;                       // oldest first
+    size_t fileLines;                                 // lines in the file, including forgotten hashes
+};
+
+// Load the newest SEEN_RESULTS_MAX hashes of the seen-set from disk; a missing file is an empty set
+SeenResults loadSeenResults(const std::string& filename);
+
+// Check whether a result with this hash was already written
+bool isResultSeen(const SeenResults& seen, uint64_t hash);
+
+// Record a hash, appending it to the file and forgetting the oldest past SEEN_RESULTS_MAX; false if it was already seen
+bool markResultSeen(SeenResults& seen, uint64_t hash);
+
+#endif // RESULT_HASH_H
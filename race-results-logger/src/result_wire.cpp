@@ -0,0 +1,170 @@
+#include "result_wire.h"
+#include <string.h>
+#include <algorithm>
+#include <unordered_map>
+
+static const char RESULT_WIRE_MAGIC[4] = {'A', 'M', 'S', 'R'};
+
+// Little-endian writers into a buffer sized up front
+static unsigned char* putU16(unsigned char* out, unsigned int value) {
+    out[0] = static_cast<unsigned char>(value);
+    out[1] = static_cast<unsigned char>(value >> 8);
+    return out + 2;
+}
+
+static unsigned char* putU32(unsigned char* out, uint32_t value) {
+    out[0] = static_cast<unsigned char>(value);
+    out[1] = static_cast<unsigned char>(value >> 8);
+    out[2] = static_cast<unsigned char>(value >> 16);
+    out[3] = static_cast<unsigned char>(value >> 24);
+    return out + 4;
+}
+
+static unsigned char* putFloat(unsigned char* out, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return putU32(out, bits);
+}
+
+static unsigned int getU16(const unsigned char* in) {
+    return in[0] | (in[1] << 8);
+}
+
+static uint32_t getU32(const unsigned char* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+static float getFloat(const unsigned char* in) {
+    uint32_t bits = getU32(in);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Name table built while encoding; each distinct string gets the next index
+struct StringTable {
+    std::vector<const std::string*> strings;
+    std::unordered_map<std::string, unsigned int> index;
+    size_t bytes;
+};
+
+static unsigned int internString(StringTable& table, const std::string& value) {
+    auto found = table.index.find(value);
+    if (found != table.index.end()) return found->second;
+    unsigned int id = static_cast<unsigned int>(table.strings.size());
+    table.index.emplace(value, id);
+    table.strings.push_back(&value);
+    table.bytes += 2 + std::min(value.size(), static_cast<size_t>(0xFFFF));
+    return id;
+}
+
+// Encode a result document; output is replaced
+void encodeResultsWire(const std::string& sessionName, const std::string& trackName, const std::string& trackLayout,
+                       uint64_t resultHash, const std::vector<RaceResult>& results, std::string& output) {
+    StringTable table;
+    table.bytes = 0;
+    table.index.reserve(results.size() * 2 + 3);
+    const unsigned int sessionId = internString(table, sessionName);
+    const unsigned int trackId = internString(table, trackName);
+    const unsigned int layoutId = internString(table, trackLayout);
+    const size_t count = std::min(results.size(), static_cast<size_t>(0xFFFF));
+    std::vector<unsigned int> names(count * 3);
+    for (size_t i = 0; i < count; ++i) {
+        names[i * 3] = internString(table, results[i].driverName);
+        names[i * 3 + 1] = internString(table, results[i].carName);
+        names[i * 3 + 2] = internString(table, results[i].carClass);
+    }
+
+    output.resize(RESULT_WIRE_HEADER_SIZE + table.bytes + count * RESULT_WIRE_DRIVER_SIZE);
+    unsigned char* out = reinterpret_cast<unsigned char*>(&output[0]);
+    memcpy(out, RESULT_WIRE_MAGIC, sizeof(RESULT_WIRE_MAGIC));
+    out += sizeof(RESULT_WIRE_MAGIC);
+    out = putU16(out, RESULT_WIRE_VERSION);
+    out = putU16(out, static_cast<unsigned int>(count));
+    out = putU16(out, static_cast<unsigned int>(table.strings.size()));
+    out = putU16(out, sessionId);
+    out = putU16(out, trackId);
+    out = putU16(out, layoutId);
+    out = putU32(out, static_cast<uint32_t>(resultHash));
+    out = putU32(out, static_cast<uint32_t>(resultHash >> 32));
+
+    for (const std::string* value : table.strings) {
+        const size_t length = std::min(value->size(), static_cast<size_t>(0xFFFF));
+        out = putU16(out, static_cast<unsigned int>(length));
+        memcpy(out, value->data(), length);
+        out += length;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const RaceResult& result = results[i];
+        out = putU16(out, result.position);
+        out = putU16(out, names[i * 3]);
+        out = putU16(out, names[i * 3 + 1]);
+        out = putU16(out, names[i * 3 + 2]);
+        out = putU16(out, result.lapsCompleted);
+        out = putU16(out, static_cast<uint16_t>(static_cast<int16_t>(result.lapsDown)));
+        out = putFloat(out, result.gapToLeader);
+        out = putFloat(out, result.interval);
+        out = putFloat(out, result.fastestLapTime);
+        out = putFloat(out, result.lastLapTime);
+    }
+}
+
+// Decode a document made by encodeResultsWire; false if it is truncated, malformed or a newer version
+bool decodeResultsWire(const std::string& input, ResultDocument& document) {
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(input.data());
+    const unsigned char* end = in + input.size();
+    if (input.size() < RESULT_WIRE_HEADER_SIZE || memcmp(in, RESULT_WIRE_MAGIC, sizeof(RESULT_WIRE_MAGIC)) != 0) return false;
+    if (getU16(in + 4) != RESULT_WIRE_VERSION) return false;
+    const unsigned int count = getU16(in + 6);
+    const unsigned int stringCount = getU16(in + 8);
+    const unsigned int sessionId = getU16(in + 10);
+    const unsigned int trackId = getU16(in + 12);
+    const unsigned int layoutId = getU16(in + 14);
+    document.resultHash = getU32(in + 16) | (static_cast<uint64_t>(getU32(in + 20)) << 32);
+    in += RESULT_WIRE_HEADER_SIZE;
+
+    // String table as offsets into the input; strings are copied only where they are used
+    std::vector<std::pair<const char*, unsigned int>> strings(stringCount);
+    for (unsigned int s = 0; s < stringCount; ++s) {
+        if (end - in < 2) return false;
+        const unsigned int length = getU16(in);
+        in += 2;
+        if (static_cast<unsigned int>(end - in) < length) return false;
+        strings[s] = std::make_pair(reinterpret_cast<const char*>(in), length);
+        in += length;
+    }
+    if (static_cast<size_t>(end - in) != static_cast<size_t>(count) * RESULT_WIRE_DRIVER_SIZE) return false;
+    if (sessionId >= stringCount || trackId >= stringCount || layoutId >= stringCount) return false;
+
+    document.sessionName.assign(strings[sessionId].first, strings[sessionId].second);
+    document.trackName.assign(strings[trackId].first, strings[trackId].second);
+    document.trackLayout.assign(strings[layoutId].first, strings[layoutId].second);
+    document.results.resize(count);
+    for (unsigned int i = 0; i < count; ++i) {
+        const unsigned int driverId = getU16(in + 2);
+        const unsigned int carId = getU16(in + 4);
+        const unsigned int classId = getU16(in + 6);
+        if (driverId >= stringCount || carId >= stringCount || classId >= stringCount) return false;
+
+        RaceResult& result = document.results[i];
+        result.position = getU16(in);
+        result.driverName.assign(strings[driverId].first, strings[driverId].second);
+        result.carName.assign(strings[carId].first, strings[carId].second);
+        result.carClass.assign(strings[classId].first, strings[classId].second);
+        result.carId = carAssetId(result.carName);
+        result.carClassId = carClassAssetId(result.carClass);
+        result.sessionName = document.sessionName;
+        result.trackName = document.trackName;
+        result.trackLayout = document.trackLayout;
+        result.lapsCompleted = getU16(in + 8);
+        result.lapsDown = static_cast<int16_t>(getU16(in + 10));
+        result.gapToLeader = getFloat(in + 12);
+        result.interval = getFloat(in + 16);
+        result.fastestLapTime = getFloat(in + 20);
+        result.lastLapTime = getFloat(in + 24);
+        in += RESULT_WIRE_DRIVER_SIZE;
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef RESULT_WIRE_H
+#define RESULT_WIRE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "results.h"
+
+// Compact binary encoding of one result document, an alternative to the JSON upload.
+// All integers and floats are little-endian.
+//
+//   header   24 bytes  magic "AMSR", version u16, driver count u16, string count u16,
+//                      session/track/layout string indices u16 x3, result hash u64
+//   strings            string count x (length u16, UTF-8 bytes); every distinct name once
+//   drivers  28 bytes  per driver: position u16, driver/car/class string indices u16 x3,
+//                      laps completed u16, laps down i16, gap to leader f32, interval f32,
+//                      fastest lap f32, last lap f32 (times in seconds, -1 when unset)
+
+// Content-Type of binary result uploads
+#define RESULT_WIRE_CONTENT_TYPE "application/x-ams2-results"
+
+// Header of /upload responses listing the body types the server decodes; binary results are only
+// sent once it names RESULT_WIRE_CONTENT_TYPE
+#define RESULT_WIRE_ACCEPT_HEADER "Accept-Post"
+
+// Response header in which the server echoes the ResultHash of a binary upload it decoded
+#define RESULT_WIRE_HASH_HEADER "X-Result-Hash"
+
+// Extension of binary result spool files
+#define RESULT_WIRE_EXTENSION ".amsr"
+
+enum
+{
+  RESULT_WIRE_VERSION = 1,
+  RESULT_WIRE_HEADER_SIZE = 24,
+  RESULT_WIRE_DRIVER_SIZE = 28
+};
+
+// A decoded result document
+struct ResultDocument {
+    std::string sessionName;
+    std::string trackName;
+    std::string trackLayout;
+    uint64_t resultHash;
+    std::vector<RaceResult> results;
+};
+
+// Encode a result document; output is replaced
+void encodeResultsWire(const std::string& sessionName, const std::string& trackName, const std::string& trackLayout,
+                       uint64_t resultHash, const std::vector<RaceResult>& results, std::string& output);
+
+// Decode a document made by encodeResultsWire; false if it is truncated, malformed or a newer version
+bool decodeResultsWire(const std::string& input, ResultDocument& document);
+
+#endif // RESULT_WIRE_H
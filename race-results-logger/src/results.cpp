@@ -0,0 +1,136 @@
+#include "results.h"
+#include <stdio.h>
+#include <algorithm>
+
+// Format time from seconds to MM:SS.sss (not used in CSV/JSON but kept for future use)
+std::string formatTime(float seconds) {
+    if (seconds <= 0 || seconds == -1.0f) return "N/A";
+    int minutes = static_cast<int>(seconds / 60);
+    float secs = seconds - (minutes * 60);
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%02d:%06.3f", minutes, secs);
+    return std::string(buffer);
+}
+
+// Get session name from mSessionState
+std::string getSessionName(unsigned int sessionState) {
+    switch (sessionState) {
+        case SESSION_INVALID: return "Invalid";
+        case SESSION_PRACTICE: return "Practice";
+        case SESSION_TEST: return "Test";
+        case SESSION_QUALIFY: return "Qualify";
+        case SESSION_FORMATION_LAP: return "Formation Lap";
+        case SESSION_RACE: return "Race";
+        case SESSION_TIME_ATTACK: return "Time Attack";
+        default: return "Unknown";
+    }
+}
+
+// Get race status from mRaceStates
+std::string getRaceStatus(unsigned int raceState) {
+    switch (raceState) {
+        case RACESTATE_INVALID: return "Invalid";
+        case RACESTATE_NOT_STARTED: return "Not Started";
+        case RACESTATE_RACING: return "Racing";
+        case RACESTATE_FINISHED: return "Finished";
+        case RACESTATE_DISQUALIFIED: return "Disqualified";
+        case RACESTATE_RETIRED: return "Retired";
+        case RACESTATE_DNF: return "DNF";
+        default: return "Unknown";
+    }
+}
+
+// Track name, preferring the translated one
+std::string getTrackName(const SharedMemory* sharedData) {
+    std::string trackName = std::string(sharedData->mTranslatedTrackLocation);
+    if (trackName.empty()) trackName = std::string(sharedData->mTrackLocation);
+    return trackName;
+}
+
+// Track layout, preferring the translated one
+std::string getTrackLayout(const SharedMemory* sharedData) {
+    std::string trackLayout = std::string(sharedData->mTranslatedTrackVariation);
+    if (trackLayout.empty()) trackLayout = std::string(sharedData->mTrackVariation);
+    return trackLayout;
+}
+
+// Collect one result per active participant, with live gaps and asset IDs (unknown names are logged once)
+std::vector<RaceResult> collectResults(const SharedMemory* sharedData, const ParticipantTable& participants, const FieldGaps& gaps) {
+    std::vector<RaceResult> results;
+    std::string sessionName = getSessionName(sharedData->mSessionState);
+    std::string trackName = getTrackName(sharedData);
+    std::string trackLayout = getTrackLayout(sharedData);
+    if (locationAssetId(trackName) == ASSET_ID_UNKNOWN) warnUnknownAsset("location", trackName);
+    if (trackAssetId(trackName, trackLayout) == ASSET_ID_UNKNOWN) warnUnknownAsset("track layout", trackName + " / " + trackLayout);
+
+    results.reserve(participants.count);
+    for (int i = 0; i < participants.count; ++i) {
+        if (!participants.active[i]) continue;
+
+        RaceResult result;
+        result.position = participants.racePosition[i];
+        result.driverName = participants.driverName[i];
+        result.sessionName = sessionName;
+        result.carName = participants.carName[i];
+        result.trackName = trackName;
+        result.trackLayout = trackLayout;
+        result.carClass = participants.carClass[i];
+        result.carId = participants.carId[i];
+        result.carClassId = participants.carClassId[i];
+        if (result.carId == ASSET_ID_UNKNOWN) warnUnknownAsset("car", result.carName);
+        if (result.carClassId == ASSET_ID_UNKNOWN) warnUnknownAsset("car class", result.carClass);
+        result.gapToLeader = gaps.gapToLeader[i];
+        result.interval = gaps.interval[i];
+        result.lapsDown = gaps.lapsDown[i];
+        result.lapsCompleted = participants.lapsCompleted[i];
+        result.fastestLapTime = participants.fastestLapTime[i];
+        result.lastLapTime = participants.lastLapTime[i];
+        results.push_back(result);
+    }
+    return results;
+}
+
+// Sort by position, or by car name for the race-start grid capture without upload
+void sortResults(std::vector<RaceResult>& results, const ServerConfig& config) {
+    if (config.createJsonAtRaceStart && config.disableUpload) {
+        std::sort(results.begin(), results.end(), [](const RaceResult& a, const RaceResult& b) {
+            return a.carName < b.carName;
+        });
+    } else {
+        std::sort(results.begin(), results.end(), [](const RaceResult& a, const RaceResult& b) {
+            return a.position < b.position;
+        });
+    }
+}
+
+// Method to check if we should log JSON at start based on number of participants > 0
+bool shouldLogAtStart(const SharedMemory* localCopy, bool logged, const ServerConfig& config) {
+    if (config.createJsonAtRaceStart && localCopy->mNumParticipants > 0 && !logged) {
+        return true;
+    }
+    return false;
+}
+
+// Check whether every active participant has finished, retired, DNF'd or been disqualified
+bool allParticipantsFinished(const ParticipantTable& participants) {
+    // One pass over two byte columns, no early exit, so it vectorizes
+    uint8_t running = 0;
+    for (int i = 0; i < participants.count; ++i) {
+        running |= participants.active[i] & (participants.classified[i] ^ 1);
+    }
+    return running == 0;
+}
+
+// Check whether the classification needs a steward's look: a disqualification or two active cars on one position
+bool isResultDisputed(const ParticipantTable& participants) {
+    bool positionTaken[STORED_PARTICIPANTS_MAX + 1] = {false};
+    for (int i = 0; i < participants.count; ++i) {
+        if (!participants.active[i]) continue;
+        if (participants.raceState[i] == RACESTATE_DISQUALIFIED) return true;
+        const uint32_t position = participants.racePosition[i];
+        if (position == 0 || position > STORED_PARTICIPANTS_MAX) continue;
+        if (positionTaken[position]) return true;
+        positionTaken[position] = true;
+    }
+    return false;
+}
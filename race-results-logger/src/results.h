@@ -0,0 +1,62 @@
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "SharedMemory.h"
+#include "asset_ids.h"
+#include "config.h"
+#include "gap_tracker.h"
+#include "participant_table.h"
+
+// Structure to hold race result data for sorting
+struct RaceResult {
+    unsigned int position;
+    std::string driverName;
+    std::string sessionName;
+    std::string carName;
+    std::string trackName;
+    std::string trackLayout;
+    std::string carClass;
+    uint32_t carId;                                   // [ UNSET = ASSET_ID_UNKNOWN ]
+    uint32_t carClassId;                              // [ UNSET = ASSET_ID_UNKNOWN ]
+    float gapToLeader;
+    float interval;
+    int lapsDown;
+    unsigned int lapsCompleted;
+    float fastestLapTime;                             // [ UNITS = seconds ]   [ UNSET = -1.0f ]
+    float lastLapTime;                                // [ UNITS = seconds ]   [ UNSET = -1.0f ]
+};
+
+// Format time from seconds to MM:SS.sss (not used in CSV/JSON but kept for future use)
+std::string formatTime(float seconds);
+
+// Get session name from mSessionState
+std::string getSessionName(unsigned int sessionState);
+
+// Get race status from mRaceStates
+std::string getRaceStatus(unsigned int raceState);
+
+// Track name, preferring the translated one
+std::string getTrackName(const SharedMemory* sharedData);
+
+// Track layout, preferring the translated one
+std::string getTrackLayout(const SharedMemory* sharedData);
+
+// Collect one result per active participant, with live gaps and asset IDs (unknown names are logged once)
+std::vector<RaceResult> collectResults(const SharedMemory* sharedData, const ParticipantTable& participants, const FieldGaps& gaps);
+
+// Sort by position, or by car name for the race-start grid capture without upload
+void sortResults(std::vector<RaceResult>& results, const ServerConfig& config);
+
+// Method to check if we should log JSON at start based on number of participants > 0
+bool shouldLogAtStart(const SharedMemory* localCopy, bool logged, const ServerConfig& config);
+
+// Check whether every active participant has finished, retired, DNF'd or been disqualified
+bool allParticipantsFinished(const ParticipantTable& participants);
+
+// Check whether the classification needs a steward's look: a disqualification or two active cars on one position
+bool isResultDisputed(const ParticipantTable& participants);
+
+#endif // RESULTS_H
@@ -0,0 +1,149 @@
+#include "scheduling.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char* const PRIORITY_NAMES[] = {"idle", "low", "normal", "high"};
+
+// Priority level of a name (idle, low, normal, high); -1 if unknown
+int parseSchedulingPriority(const std::string& name) {
+    for (int level = SCHEDULING_PRIORITY_IDLE; level <= SCHEDULING_PRIORITY_HIGH; ++level) {
+        if (name == PRIORITY_NAMES[level]) return level;
+    }
+    return -1;
+}
+
+// Name of a priority level
+const char* schedulingPriorityName(int level) {
+    return level >= SCHEDULING_PRIORITY_IDLE && level <= SCHEDULING_PRIORITY_HIGH ? PRIORITY_NAMES[level] : "unknown";
+}
+
+// CPU mask of a list like "2,3" or "4-7" (bit n is CPU n, CPUs 0 to 63); an empty list is 0 (any CPU); false if malformed
+bool parseCpuList(const std::string& list, uint64_t& mask) {
+    mask = 0;
+    const char* text = list.c_str();
+    while (*text != '\0') {
+        char* end = NULL;
+        const long first = strtol(text, &end, 10);
+        if (end == text || first < 0 || first > 63) return false;
+        long last = first;
+        text = end;
+        if (*text == '-') {
+            last = strtol(text + 1, &end, 10);
+            if (end == text + 1 || last < first || last > 63) return false;
+            text = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) mask |= 1ULL << cpu;
+        if (*text == ',') {
+            ++text;
+        } else if (*text != '\0') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// List of the CPUs in a mask, "any" for 0
+std::string formatCpuList(uint64_t mask) {
+    if (mask == 0) return "any";
+    std::string list;
+    for (int cpu = 0; cpu < 64; ++cpu) {
+        if (!(mask >> cpu & 1)) continue;
+        int last = cpu;
+        while (last < 63 && (mask >> (last + 1) & 1)) ++last;
+        if (!list.empty()) list += ",";
+        list += std::to_string(cpu);
+        if (last > cpu) list += "-" + std::to_string(last);
+        cpu = last;
+    }
+    return list;
+}
+
+// Start pacing as if a frame had just arrived
+void resetSamplerPacing(SamplerPacing& pacing, unsigned int pollMs, unsigned int idlePollMs, bool alignToFrames, double now) {
+    pacing.pollMs = pollMs;
+    pacing.idlePollMs = idlePollMs;
+    pacing.alignToFrames = alignToFrames;
+    pacing.framePeriod = 0.0;
+    pacing.lastFrameTime = now;
+    pacing.tornInRow = 0;
+    pacing.idle = false;
+}
+
+// Milliseconds to sleep after a poll with the given outcome (SAMPLER_*), 0 to retry a torn copy now;
+// updates 'idle', which the caller can watch to drop and restore its timer resolution
+unsigned int nextSamplerPoll(SamplerPacing& pacing, int outcome, double now) {
+    // A torn copy is worth an immediate retry, but a game that writes through every copy
+    // must not turn the sampler into a spin loop
+    if (outcome == SAMPLER_TORN && ++pacing.tornInRow <= SAMPLER_TORN_RETRIES) return 0;
+    pacing.tornInRow = 0;
+
+    if (outcome == SAMPLER_NEW_FRAME) {
+        const double interval = now - pacing.lastFrameTime;
+        const bool wasIdle = pacing.idle;
+        pacing.lastFrameTime = now;
+        pacing.idle = false;
+        if (wasIdle || interval <= 0.0 || interval >= SAMPLER_IDLE_SECONDS) return pacing.pollMs;
+        pacing.framePeriod = pacing.framePeriod == 0.0 ? interval : pacing.framePeriod * 0.9 + interval * 0.1;
+
+        // Wake two polls ahead of the next expected frame, so a frame is still taken within one poll
+        // interval but a 60 Hz game costs three wakeups a frame rather than eight
+        const double aligned = pacing.framePeriod * 1000.0 - 2.0 * pacing.pollMs;
+        if (pacing.alignToFrames && aligned > pacing.pollMs) return static_cast<unsigned int>(aligned);
+    } else if (pacing.idlePollMs > pacing.pollMs && now - pacing.lastFrameTime >= SAMPLER_IDLE_SECONDS) {
+        pacing.idle = true;
+    }
+    return pacing.idle ? pacing.idlePollMs : pacing.pollMs;
+}
+
+// Start counting; threads are added before they start
+void resetSchedulingStats(SchedulingStats& stats, double now, double processCpuSeconds) {
+    for (int t = 0; t < SCHEDULING_THREADS_MAX; ++t) {
+        ThreadActivity& activity = stats.threads[t];
+        activity.name = "";
+        activity.wakeups = 0;
+        activity.cpuMicroseconds = 0;
+        activity.reportedWakeups = 0;
+        activity.reportedCpuMicroseconds = 0;
+    }
+    stats.numThreads = 0;
+    stats.reportedTime = now;
+    stats.reportedProcessCpu = processCpuSeconds;
+}
+
+// Add a thread to report on; returns its index, or -1 when all are taken
+int addSchedulingThread(SchedulingStats& stats, const char* name) {
+    if (stats.numThreads >= SCHEDULING_THREADS_MAX) return -1;
+    stats.threads[stats.numThreads].name = name;
+    return stats.numThreads++;
+}
+
+// Count one wakeup of a thread and store the CPU time it has used so far
+void countWakeup(SchedulingStats& stats, int thread, double cpuSeconds) {
+    if (thread < 0) return;
+    ThreadActivity& activity = stats.threads[thread];
+    activity.wakeups.fetch_add(1, std::memory_order_relaxed);
+    activity.cpuMicroseconds.store(static_cast<unsigned long long>(cpuSeconds * 1e6), std::memory_order_relaxed);
+}
+
+// Process CPU share and each thread's wakeups per second and CPU share since the previous report; starts the next interval
+std::string formatSchedulingReport(SchedulingStats& stats, double now, double processCpuSeconds) {
+    const double span = now - stats.reportedTime;
+    if (span <= 0.0) return "no time elapsed";
+    char line[160];
+    snprintf(line, sizeof(line), "process %.2f%% CPU (%.2f s over %.0f s)", 100.0 * (processCpuSeconds - stats.reportedProcessCpu) / span,
+             processCpuSeconds - stats.reportedProcessCpu, span);
+    std::string report = line;
+    for (int t = 0; t < stats.numThreads; ++t) {
+        ThreadActivity& activity = stats.threads[t];
+        const unsigned long long wakeups = activity.wakeups.load(std::memory_order_relaxed);
+        const unsigned long long cpu = activity.cpuMicroseconds.load(std::memory_order_relaxed);
+        snprintf(line, sizeof(line), ", %s %.1f wakeups/s %.2f%% CPU", activity.name, (wakeups - activity.reportedWakeups) / span,
+                 100.0 * (cpu - activity.reportedCpuMicroseconds) / 1e6 / span);
+        report += line;
+        activity.reportedWakeups = wakeups;
+        activity.reportedCpuMicroseconds = cpu;
+    }
+    stats.reportedTime = now;
+    stats.reportedProcessCpu = processCpuSeconds;
+    return report;
+}
@@ -0,0 +1,110 @@
+#ifndef SCHEDULING_H
+#define SCHEDULING_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+// Scheduling of the logger's own threads next to the game on the same PC: the priority and
+// CPUs they run on, how often the sampler wakes up, and what the logger costs in CPU time
+// and wakeups. The OS calls behind priorities, CPU masks and CPU time are in platform.h.
+
+// Thread priorities, mapped to the nearest OS level by setThreadPriorityLevel
+enum
+{
+  SCHEDULING_PRIORITY_IDLE = 0,
+  SCHEDULING_PRIORITY_LOW = 1,
+  SCHEDULING_PRIORITY_NORMAL = 2,
+  SCHEDULING_PRIORITY_HIGH = 3
+};
+
+// Threads that report their activity
+enum
+{
+  SCHEDULING_THREADS_MAX = 8
+};
+
+// Outcome of one sampler poll
+enum
+{
+  SAMPLER_NEW_FRAME = 0,
+  SAMPLER_NO_FRAME = 1,                               // nothing new, or the game is mid-write
+  SAMPLER_TORN = 2                                    // the game wrote during the copy
+};
+
+// Sampler poll interval while frames arrive, and its idle interval under scheduling=game
+enum
+{
+  SAMPLER_POLL_MS = 2,
+  SAMPLER_GAME_IDLE_POLL_MS = 50
+};
+
+// Torn copies retried straight away before the sampler sleeps like on any other poll
+enum
+{
+  SAMPLER_TORN_RETRIES = 2
+};
+
+// Seconds without a new frame (menus, pause, loading) before the sampler polls at its idle interval
+#define SAMPLER_IDLE_SECONDS 1.0
+
+// Priority level of a name (idle, low, normal, high); -1 if unknown
+int parseSchedulingPriority(const std::string& name);
+
+// Name of a priority level
+const char* schedulingPriorityName(int level);
+
+// CPU mask of a list like "2,3" or "4-7" (bit n is CPU n, CPUs 0 to 63); an empty list is 0 (any CPU); false if malformed
+bool parseCpuList(const std::string& list, uint64_t& mask);
+
+// List of the CPUs in a mask, "any" for 0
+std::string formatCpuList(uint64_t mask);
+
+// How often the sampler thread polls shared memory
+struct SamplerPacing {
+    unsigned int pollMs;                              // while frames arrive
+    unsigned int idlePollMs;                          // once none arrived for SAMPLER_IDLE_SECONDS; no backoff if <= pollMs
+    bool alignToFrames;                               // sleep most of a frame after each new one instead of polling through it
+    double framePeriod;                               // [ UNITS = seconds ]   [ UNSET = 0.0 ] smoothed time between frames
+    double lastFrameTime;                             // [ UNITS = seconds ] on the caller's clock
+    int tornInRow;
+    bool idle;
+};
+
+// Start pacing as if a frame had just arrived
+void resetSamplerPacing(SamplerPacing& pacing, unsigned int pollMs, unsigned int idlePollMs, bool alignToFrames, double now);
+
+// Milliseconds to sleep after a poll with the given outcome (SAMPLER_*), 0 to retry a torn copy now;
+// updates 'idle', which the caller can watch to drop and restore its timer resolution
+unsigned int nextSamplerPoll(SamplerPacing& pacing, int outcome, double now);
+
+// Wakeups and CPU time of one thread, written by that thread and read by the reporter
+struct ThreadActivity {
+    const char* name;
+    std::atomic<unsigned long long> wakeups;
+    std::atomic<unsigned long long> cpuMicroseconds;  // as last measured by the thread itself
+    unsigned long long reportedWakeups;               // at the previous report
+    unsigned long long reportedCpuMicroseconds;
+};
+
+// Activity of the logger's threads and of the whole process since the previous report
+struct SchedulingStats {
+    ThreadActivity threads[SCHEDULING_THREADS_MAX];
+    int numThreads;
+    double reportedTime;                              // [ UNITS = seconds ] on the caller's clock
+    double reportedProcessCpu;                        // [ UNITS = seconds ]
+};
+
+// Start counting; threads are added before they start
+void resetSchedulingStats(SchedulingStats& stats, double now, double processCpuSeconds);
+
+// Add a thread to report on; returns its index, or -1 when all are taken
+int addSchedulingThread(SchedulingStats& stats, const char* name);
+
+// Count one wakeup of a thread and store the CPU time it has used so far
+void countWakeup(SchedulingStats& stats, int thread, double cpuSeconds);
+
+// Process CPU share and each thread's wakeups per second and CPU share since the previous report; starts the next interval
+std::string formatSchedulingReport(SchedulingStats& stats, double now, double processCpuSeconds);
+
+#endif // SCHEDULING_H
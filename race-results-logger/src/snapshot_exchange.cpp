@@ -0,0 +1,133 @@
+#include "snapshot_exchange.h"
+#include <chrono>
+#include "logger.h"
+
+// Allocate the slots and start with nothing published
+void createSnapshotExchange(SnapshotExchange& exchange) {
+    for (int s = 0; s < SNAPSHOT_SLOTS_MAX; ++s) {
+        exchange.slots[s].data = new SharedMemory;
+        exchange.slots[s].refs = 0;
+        exchange.slots[s].serial = 0;
+        exchange.slots[s].time = 0.0;
+    }
+    exchange.numConsumers = 0;
+    exchange.latest = -1;
+    exchange.writing = -1;
+    exchange.published = 0;
+    exchange.torn = 0;
+    exchange.stopped = false;
+}
+
+// Free the slots; every thread must have stopped using the exchange
+void destroySnapshotExchange(SnapshotExchange& exchange) {
+    for (int s = 0; s < SNAPSHOT_SLOTS_MAX; ++s) {
+        delete exchange.slots[s].data;
+        exchange.slots[s].data = NULL;
+    }
+}
+
+// Register a consumer before the threads start; returns its index, or -1 when all are taken
+int addSnapshotConsumer(SnapshotExchange& exchange, const std::string& name) {
+    std::lock_guard<std::mutex> lock(exchange.mutex);
+    if (exchange.numConsumers >= SNAPSHOT_CONSUMERS_MAX) {
+        logMessage("ERROR", "No snapshot consumer left for " + name);
+        return -1;
+    }
+    SnapshotConsumer& consumer = exchange.consumers[exchange.numConsumers];
+    consumer.name = name;
+    consumer.heldSlot = -1;
+    consumer.lastSerial = 0;
+    consumer.taken = 0;
+    consumer.dropped = 0;
+    return exchange.numConsumers++;
+}
+
+// Sampler: a free slot to copy the next snapshot into
+SharedMemory* beginSnapshotWrite(SnapshotExchange& exchange) {
+    std::lock_guard<std::mutex> lock(exchange.mutex);
+    if (exchange.writing < 0) {
+        // Each consumer holds at most one slot and one more is the latest, so one is always free
+        for (int s = 0; s < SNAPSHOT_SLOTS_MAX; ++s) {
+            if (s != exchange.latest && exchange.slots[s].refs == 0) {
+                exchange.writing = s;
+                break;
+            }
+        }
+    }
+    return exchange.slots[exchange.writing].data;
+}
+
+// Sampler: publish the slot from beginSnapshotWrite as the latest snapshot and wake the consumers
+void publishSnapshot(SnapshotExchange& exchange, double time) {
+    {
+        std::lock_guard<std::mutex> lock(exchange.mutex);
+        if (exchange.writing < 0) return;
+        SnapshotSlot& slot = exchange.slots[exchange.writing];
+        slot.serial = ++exchange.published;
+        slot.time = time;
+        exchange.latest = exchange.writing;
+        exchange.writing = -1;
+    }
+    exchange.ready.notify_all();
+}
+
+// Sampler: give back the slot from beginSnapshotWrite without publishing it (torn copy)
+void abandonSnapshotWrite(SnapshotExchange& exchange) {
+    std::lock_guard<std::mutex> lock(exchange.mutex);
+    exchange.writing = -1;
+    exchange.torn++;
+}
+
+// Drop the slot a consumer holds, with the exchange locked
+static void releaseHeldSlot(SnapshotExchange& exchange, SnapshotConsumer& consumer) {
+    if (consumer.heldSlot < 0) return;
+    exchange.slots[consumer.heldSlot].refs--;
+    consumer.heldSlot = -1;
+}
+
+// Consumer: wait up to timeoutMs for a snapshot newer than the last one taken and hold it until
+// releaseSnapshot; NULL on timeout or once the exchange is stopped
+const SharedMemory* acquireSnapshot(SnapshotExchange& exchange, int consumer, unsigned int timeoutMs, double* time) {
+    std::unique_lock<std::mutex> lock(exchange.mutex);
+    SnapshotConsumer& reader = exchange.consumers[consumer];
+    releaseHeldSlot(exchange, reader);
+    const bool ready = exchange.ready.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&] {
+        return exchange.stopped || exchange.published > reader.lastSerial;
+    });
+    if (!ready || exchange.stopped) return NULL;
+
+    SnapshotSlot& slot = exchange.slots[exchange.latest];
+    if (reader.lastSerial > 0) reader.dropped += slot.serial - reader.lastSerial - 1;
+    reader.lastSerial = slot.serial;
+    reader.heldSlot = exchange.latest;
+    reader.taken++;
+    slot.refs++;
+    if (time != NULL) *time = slot.time;
+    return slot.data;
+}
+
+// Consumer: let the sampler reuse the held snapshot
+void releaseSnapshot(SnapshotExchange& exchange, int consumer) {
+    std::lock_guard<std::mutex> lock(exchange.mutex);
+    releaseHeldSlot(exchange, exchange.consumers[consumer]);
+}
+
+// Wake every waiting consumer and make further waits return NULL
+void stopSnapshotExchange(SnapshotExchange& exchange) {
+    {
+        std::lock_guard<std::mutex> lock(exchange.mutex);
+        exchange.stopped = true;
+    }
+    exchange.ready.notify_all();
+}
+
+// Log published, torn, taken and dropped snapshot counts
+void logSnapshotExchangeStats(SnapshotExchange& exchange) {
+    std::lock_guard<std::mutex> lock(exchange.mutex);
+    logMessage("INFO", "Snapshots published: " + std::to_string(exchange.published) + ", torn copies discarded: " + std::to_string(exchange.torn));
+    for (int c = 0; c < exchange.numConsumers; ++c) {
+        const SnapshotConsumer& consumer = exchange.consumers[c];
+        logMessage("INFO", "Snapshot consumer " + consumer.name + ": " + std::to_string(consumer.taken) + " taken, " +
+                           std::to_string(consumer.dropped) + " dropped");
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef SNAPSHOT_EXCHANGE_H
+#define SNAPSHOT_EXCHANGE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include "SharedMemory.h"
+
+// Consumers that can read snapshots at the same time, and the slots that needs:
+// one held by each consumer, the latest published one and the one being written
+enum
+{
+  SNAPSHOT_CONSUMERS_MAX = 4,
+  SNAPSHOT_SLOTS_MAX = SNAPSHOT_CONSUMERS_MAX + 2
+};
+
+// One snapshot buffer
+struct SnapshotSlot {
+    SharedMemory* data;
+    int refs;                                         // consumers currently reading it
+    unsigned long long serial;                        // publish number [ UNSET = 0 ]
+    double time;                                      // sampler clock when published [ UNITS = seconds ]
+};
+
+// A reader of the published snapshots and what it has missed
+struct SnapshotConsumer {
+    std::string name;
+    int heldSlot;                                     // [ UNSET = -1 ]
+    unsigned long long lastSerial;                    // serial of the last snapshot taken
+    unsigned long long taken;
+    unsigned long long dropped;                       // snapshots published and overwritten before this consumer took them
+};
+
+// Hands consistent copies of the game's shared memory from one sampler thread to several
+// consumer threads without copying them again. The sampler writes into a slot no one reads,
+// publishes it as the latest and wakes the consumers; each consumer takes a reference to the
+// latest slot, reads it at its own pace and releases it. Slots are only reused at zero references,
+// so with SNAPSHOT_SLOTS_MAX slots the sampler never waits for a consumer.
+struct SnapshotExchange {
+    SnapshotSlot slots[SNAPSHOT_SLOTS_MAX];
+    SnapshotConsumer consumers[SNAPSHOT_CONSUMERS_MAX];
+    int numConsumers;
+    int latest;                                       // slot of the newest snapshot [ UNSET = -1 ]
+    int writing;                                      // slot the sampler is filling [ UNSET = -1 ]
+    unsigned long long published;
+    unsigned long long torn;                          // copies discarded because the game wrote during them
+    std::atomic<bool> stopped;
+    std::mutex mutex;
+    std::condition_variable ready;
+};
+
+// Allocate the slots and start with nothing published
+void createSnapshotExchange(SnapshotExchange& exchange);
+
+// Free the slots; every thread must have stopped using the exchange
+void destroySnapshotExchange(SnapshotExchange& exchange);
+
+// Register a consumer before the threads start; returns its index, or -1 when all are taken
+int addSnapshotConsumer(SnapshotExchange& exchange, const std::string& name);
+
+// Sampler: a free slot to copy the next snapshot into
+SharedMemory* beginSnapshotWrite(SnapshotExchange& exchange);
+
+// Sampler: publish the slot from beginSnapshotWrite as the latest snapshot and wake the consumers
+void publishSnapshot(SnapshotExchange& exchange, double time);
+
+// Sampler: give back the slot from beginSnapshotWrite without publishing it (torn copy)
+void abandonSnapshotWrite(SnapshotExchange& exchange);
+
+// Consumer: wait up to timeoutMs for a snapshot newer than the last one taken and hold it until
+// releaseSnapshot; NULL on timeout or once the exchange is stopped
+const SharedMemory* acquireSnapshot(SnapshotExchange& exchange, int consumer, unsigned int timeoutMs, double* time);
+
+// Consumer: let the sampler reuse the held snapshot
+void releaseSnapshot(SnapshotExchange& exchange, int consumer);
+
+// Wake every waiting consumer and make further waits return NULL
+void stopSnapshotExchange(SnapshotExchange& exchange);
+
+// Log published, torn, taken and dropped snapshot counts
+void logSnapshotExchangeStats(SnapshotExchange& exchange);
+
+#endif // SNAPSHOT_EXCHANGE_H
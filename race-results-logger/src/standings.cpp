@@ -0,0 +1,278 @@
+#include "standings.h"
+#include <string.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include "logger.h"
+
+// Points for the first ten places, the same as POINTS_SYSTEM in race-results-server/src/utils/constants.js
+const int STANDINGS_POINTS[STANDINGS_POINTS_PLACES] = {25, 18, 15, 12, 10, 8, 6, 4, 2, 1};
+
+// Snapshot header: magic, then version and the table sizes
+static const char STANDINGS_MAGIC[4] = {'A', 'M', 'S', 'S'};
+enum
+{
+  STANDINGS_VERSION = 1
+};
+
+// Start an empty season
+void resetStandings(Standings& standings) {
+    standings.races = 0;
+    standings.drivers.clear();
+    standings.driverIndex.clear();
+    standings.classes.clear();
+    standings.classIndex.clear();
+    standings.appliedResults.clear();
+}
+
+// Points for a finishing place, 0 outside the points or for an unset place
+static int pointsForPlace(unsigned int place) {
+    return place >= 1 && place <= STANDINGS_POINTS_PLACES ? STANDINGS_POINTS[place - 1] : 0;
+}
+
+// Tally of a driver in a table, added on first appearance
+static StandingTally& tallyFor(std::vector<StandingTally>& drivers, std::unordered_map<std::string, int>& index,
+                               const std::string& driverName) {
+    auto found = index.find(driverName);
+    if (found != index.end()) return drivers[found->second];
+    index.emplace(driverName, static_cast<int>(drivers.size()));
+    drivers.push_back({driverName, "", ASSET_ID_UNKNOWN, 0, 0, 0, 0, 0});
+    return drivers.back();
+}
+
+// Count one finish in a tally
+static void addFinish(StandingTally& tally, const RaceResult& result, unsigned int place) {
+    tally.carName = result.carName;
+    tally.carId = result.carId;
+    tally.points += pointsForPlace(place);
+    tally.races += 1;
+    tally.wins += place == 1;
+    tally.podiums += place >= 1 && place <= 3;
+    if (place >= 1 && (tally.bestFinish == 0 || static_cast<int>(place) < tally.bestFinish)) tally.bestFinish = static_cast<int>(place);
+}
+
+// Count one race result (any driver order) towards the standings; false if this result hash was already counted
+bool applyRaceResult(Standings& standings, uint64_t resultHash, const std::vector<RaceResult>& results) {
+    if (results.empty() || !standings.appliedResults.insert(resultHash).second) return false;
+    standings.races += 1;
+
+    // Class places follow overall places, so walk the field in position order once
+    std::vector<int> order(results.size());
+    for (size_t i = 0; i < results.size(); ++i) order[i] = static_cast<int>(i);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        const unsigned int positionA = results[a].position == 0 ? UINT32_MAX : results[a].position;
+        const unsigned int positionB = results[b].position == 0 ? UINT32_MAX : results[b].position;
+        return positionA < positionB;
+    });
+
+    std::vector<int> classPlaces;                     // places handed out so far, per class index
+    std::vector<bool> classCounted;                   // class raced in this result
+    for (int i : order) {
+        const RaceResult& result = results[i];
+        addFinish(tallyFor(standings.drivers, standings.driverIndex, result.driverName), result, result.position);
+
+        auto found = standings.classIndex.find(result.carClass);
+        int classSlot;
+        if (found != standings.classIndex.end()) {
+            classSlot = found->second;
+        } else {
+            classSlot = static_cast<int>(standings.classes.size());
+            standings.classIndex.emplace(result.carClass, classSlot);
+            standings.classes.push_back({result.carClass, result.carClassId, 0, {}, {}});
+        }
+        if (static_cast<int>(classPlaces.size()) <= classSlot) {
+            classPlaces.resize(classSlot + 1, 0);
+            classCounted.resize(classSlot + 1, false);
+        }
+        ClassStandings& classStandings = standings.classes[classSlot];
+        if (!classCounted[classSlot]) {
+            classStandings.races += 1;
+            classCounted[classSlot] = true;
+        }
+        const unsigned int classPlace = result.position == 0 ? 0 : ++classPlaces[classSlot];
+        addFinish(tallyFor(classStandings.drivers, classStandings.driverIndex, result.driverName), result, classPlace);
+    }
+    return true;
+}
+
+// Indices of a table's drivers in standings order: points, then wins, podiums, best finish and name
+std::vector<int> rankStandings(const std::vector<StandingTally>& drivers) {
+    std::vector<int> order(drivers.size());
+    for (size_t i = 0; i < drivers.size(); ++i) order[i] = static_cast<int>(i);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        const StandingTally& x = drivers[a];
+        const StandingTally& y = drivers[b];
+        if (x.points != y.points) return x.points > y.points;
+        if (x.wins != y.wins) return x.wins > y.wins;
+        if (x.podiums != y.podiums) return x.podiums > y.podiums;
+        const int bestX = x.bestFinish == 0 ? INT32_MAX : x.bestFinish;
+        const int bestY = y.bestFinish == 0 ? INT32_MAX : y.bestFinish;
+        if (bestX != bestY) return bestX < bestY;
+        return x.driverName < y.driverName;
+    });
+    return order;
+}
+
+// Standings of one car class, NULL if it has not raced yet
+const ClassStandings* findClassStandings(const Standings& standings, const std::string& carClass) {
+    auto found = standings.classIndex.find(carClass);
+    return found == standings.classIndex.end() ? NULL : &standings.classes[found->second];
+}
+
+// Length-prefixed string and fixed-size values of the snapshot
+static void writeString(std::ostream& out, const std::string& text) {
+    const uint16_t length = static_cast<uint16_t>(std::min<size_t>(text.size(), UINT16_MAX));
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(text.data(), length);
+}
+
+template <typename Value>
+static void writeValue(std::ostream& out, Value value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static bool readString(std::istream& in, std::string& text) {
+    uint16_t length = 0;
+    if (!in.read(reinterpret_cast<char*>(&length), sizeof(length))) return false;
+    text.resize(length);
+    return length == 0 || static_cast<bool>(in.read(&text[0], length));
+}
+
+template <typename Value>
+static bool readValue(std::istream& in, Value& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+// Smallest snapshot records: a tally is two empty strings, the car ID and five counts; a class
+// header is an empty string, the class ID and its race count. Counts read from a snapshot are
+// checked against what the rest of the file could hold before anything is allocated for them.
+static const uint64_t TALLY_MIN_BYTES = 2 * sizeof(uint16_t) + sizeof(uint32_t) + 5 * sizeof(int32_t);
+static const uint64_t CLASS_MIN_BYTES = sizeof(uint16_t) + sizeof(uint32_t) + sizeof(int32_t);
+
+// Bytes from the read position to the end of the snapshot
+static uint64_t bytesLeft(std::istream& in) {
+    const std::streampos position = in.tellg();
+    in.seekg(0, std::ios::end);
+    const std::streampos end = in.tellg();
+    in.seekg(position);
+    return position < 0 || end < position ? 0 : static_cast<uint64_t>(end - position);
+}
+
+// One table of tallies
+static void writeTallies(std::ostream& out, const std::vector<StandingTally>& drivers) {
+    writeValue<uint32_t>(out, static_cast<uint32_t>(drivers.size()));
+    for (const StandingTally& tally : drivers) {
+        writeString(out, tally.driverName);
+        writeString(out, tally.carName);
+        writeValue<uint32_t>(out, tally.carId);
+        writeValue<int32_t>(out, tally.points);
+        writeValue<int32_t>(out, tally.races);
+        writeValue<int32_t>(out, tally.wins);
+        writeValue<int32_t>(out, tally.podiums);
+        writeValue<int32_t>(out, tally.bestFinish);
+    }
+}
+
+static bool readTallies(std::istream& in, std::vector<StandingTally>& drivers, std::unordered_map<std::string, int>& index) {
+    uint32_t count = 0;
+    if (!readValue(in, count) || count > bytesLeft(in) / TALLY_MIN_BYTES) return false;
+    drivers.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        StandingTally& tally = drivers[i];
+        int32_t values[5];
+        if (!readString(in, tally.driverName) || !readString(in, tally.carName) || !readValue(in, tally.carId) ||
+            !in.read(reinterpret_cast<char*>(values), sizeof(values))) {
+            return false;
+        }
+        tally.points = values[0];
+        tally.races = values[1];
+        tally.wins = values[2];
+        tally.podiums = values[3];
+        tally.bestFinish = values[4];
+        index[tally.driverName] = static_cast<int>(i);
+    }
+    return true;
+}
+
+// Read a whole snapshot; false if it is cut short or not a snapshot of this version
+static bool readSnapshot(std::istream& in, Standings& standings) {
+    char magic[4];
+    uint32_t header[4];                               // version, races, result hashes, classes
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, STANDINGS_MAGIC, sizeof(magic)) != 0) return false;
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != STANDINGS_VERSION) return false;
+    standings.races = static_cast<int>(header[1]);
+    if (header[2] > bytesLeft(in) / sizeof(uint64_t)) return false;
+    for (uint32_t i = 0; i < header[2]; ++i) {
+        uint64_t hash = 0;
+        if (!readValue(in, hash)) return false;
+        standings.appliedResults.insert(hash);
+    }
+    if (!readTallies(in, standings.drivers, standings.driverIndex)) return false;
+    if (header[3] > bytesLeft(in) / CLASS_MIN_BYTES) return false;
+    standings.classes.resize(header[3]);
+    for (uint32_t c = 0; c < header[3]; ++c) {
+        ClassStandings& classStandings = standings.classes[c];
+        int32_t races = 0;
+        if (!readString(in, classStandings.carClass) || !readValue(in, classStandings.carClassId) || !readValue(in, races) ||
+            !readTallies(in, classStandings.drivers, classStandings.driverIndex)) {
+            return false;
+        }
+        classStandings.races = races;
+        standings.classIndex[classStandings.carClass] = static_cast<int>(c);
+    }
+    return true;
+}
+
+// Load a snapshot; a missing file is an empty season, a damaged one is logged and ignored
+bool loadStandings(const std::string& filename, Standings& standings) {
+    resetStandings(standings);
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if (!file.is_open()) return true;
+    if (!readSnapshot(file, standings)) {
+        logMessage("ERROR", "Standings snapshot " + filename + " is damaged or of another version, starting an empty season");
+        resetStandings(standings);
+        return false;
+    }
+    return true;
+}
+
+// Write a snapshot, replacing the previous one only once the new one is complete
+bool saveStandings(const std::string& filename, const Standings& standings) {
+    namespace fs = std::filesystem;
+    const fs::path folder = fs::path(filename).parent_path();
+    if (!folder.empty() && !fs::exists(folder)) {
+        fs::create_directories(folder);
+        logMessage("INFO", "Created " + folder.string() + "/ directory");
+    }
+    const std::string temporary = filename + ".tmp";
+    std::ofstream file(temporary, std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        logMessage("ERROR", "Failed to open standings snapshot: " + temporary);
+        return false;
+    }
+    const uint32_t header[4] = {STANDINGS_VERSION, static_cast<uint32_t>(standings.races),
+                                static_cast<uint32_t>(standings.appliedResults.size()),
+                                static_cast<uint32_t>(standings.classes.size())};
+    file.write(STANDINGS_MAGIC, sizeof(STANDINGS_MAGIC));
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    for (uint64_t hash : standings.appliedResults) writeValue<uint64_t>(file, hash);
+    writeTallies(file, standings.drivers);
+    for (const ClassStandings& classStandings : standings.classes) {
+        writeString(file, classStandings.carClass);
+        writeValue<uint32_t>(file, classStandings.carClassId);
+        writeValue<int32_t>(file, classStandings.races);
+        writeTallies(file, classStandings.drivers);
+    }
+    file.close();
+    if (file.fail()) {
+        logMessage("ERROR", "Failed to write standings snapshot: " + temporary);
+        return false;
+    }
+    std::error_code error;
+    fs::rename(temporary, filename, error);
+    if (error) {
+        logMessage("ERROR", "Failed to replace standings snapshot " + filename + ": " + error.message());
+        return false;
+    }
+    return true;
+}
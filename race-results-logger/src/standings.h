@@ -0,0 +1,77 @@
+#ifndef STANDINGS_H
+#define STANDINGS_H
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "results.h"
+
+// Championship standings kept up to date by the logger itself: each race result is applied
+// once, in time proportional to the drivers in that race, to an overall table (points by
+// overall position, as the server's pointsService counts them) and to one table per car class
+// (points by position within the class). The tables are persisted as a binary snapshot after
+// every race and exported as JSON, so the standings never have to be recomputed from the
+// archive of result files.
+
+// Points for the first ten places, the same as POINTS_SYSTEM in race-results-server/src/utils/constants.js
+enum
+{
+  STANDINGS_POINTS_PLACES = 10
+};
+extern const int STANDINGS_POINTS[STANDINGS_POINTS_PLACES];
+
+// Snapshot file the logger keeps the standings in
+#define STANDINGS_SNAPSHOT_FILE "standings/standings.dat"
+
+// Tallies of one driver in one table
+struct StandingTally {
+    std::string driverName;
+    std::string carName;                              // car of the last race counted
+    uint32_t carId;                                   // [ UNSET = ASSET_ID_UNKNOWN ]
+    int points;
+    int races;
+    int wins;
+    int podiums;
+    int bestFinish;                                   // [ UNSET = 0 ]
+};
+
+// Standings of one car class
+struct ClassStandings {
+    std::string carClass;
+    uint32_t carClassId;                              // [ UNSET = ASSET_ID_UNKNOWN ]
+    int races;
+    std::vector<StandingTally> drivers;               // in order of first appearance
+    std::unordered_map<std::string, int> driverIndex;
+};
+
+// Overall and per-class standings of a season
+struct Standings {
+    int races;
+    std::vector<StandingTally> drivers;               // overall, in order of first appearance
+    std::unordered_map<std::string, int> driverIndex;
+    std::vector<ClassStandings> classes;
+    std::unordered_map<std::string, int> classIndex;
+    std::unordered_set<uint64_t> appliedResults;      // result hashes already counted, kept in the snapshot across restarts
+};
+
+// Start an empty season
+void resetStandings(Standings& standings);
+
+// Count one race result (any driver order) towards the standings; false if this result hash was already counted
+bool applyRaceResult(Standings& standings, uint64_t resultHash, const std::vector<RaceResult>& results);
+
+// Indices of a table's drivers in standings order: points, then wins, podiums, best finish and name
+std::vector<int> rankStandings(const std::vector<StandingTally>& drivers);
+
+// Standings of one car class, NULL if it has not raced yet
+const ClassStandings* findClassStandings(const Standings& standings, const std::string& carClass);
+
+// Load a snapshot; a missing file is an empty season, a damaged one is logged and ignored
+bool loadStandings(const std::string& filename, Standings& standings);
+
+// Write a snapshot, replacing the previous one only once the new one is complete
+bool saveStandings(const std::string& filename, const Standings& standings);
+
+#endif // STANDINGS_H
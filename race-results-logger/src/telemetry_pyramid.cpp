@@ -0,0 +1,142 @@
+#include "telemetry_pyramid.h"
+#include <cmath>
+#include <cfloat>
+
+// Start an empty bucket at the given time
+static void resetBucket(TelemetryBucket& bucket, double startTime) {
+    for (int g = 0; g < TELEMETRY_GROUPS_MAX; ++g) {
+        for (int k = 0; k < TYRE_MAX; ++k) {
+            bucket.min[g].v[k] = FLT_MAX;
+            bucket.max[g].v[k] = -FLT_MAX;
+            bucket.sum[g].v[k] = 0.0f;
+        }
+    }
+    bucket.startTime = startTime;
+    bucket.count = 0;
+}
+
+// Allocate the bucket rings and start empty
+void createTelemetryPyramid(TelemetryPyramid& pyramid) {
+    for (int l = 0; l < TELEMETRY_LEVELS_MAX; ++l) {
+        pyramid.levels[l].buckets = new TelemetryBucket[TELEMETRY_LEVEL_BUCKETS[l]];
+    }
+    resetTelemetryPyramid(pyramid);
+}
+
+// Free the bucket rings
+void destroyTelemetryPyramid(TelemetryPyramid& pyramid) {
+    for (int l = 0; l < TELEMETRY_LEVELS_MAX; ++l) {
+        delete[] pyramid.levels[l].buckets;
+        pyramid.levels[l].buckets = NULL;
+    }
+}
+
+// Forget all buckets, e.g. when a new session starts
+void resetTelemetryPyramid(TelemetryPyramid& pyramid) {
+    for (int l = 0; l < TELEMETRY_LEVELS_MAX; ++l) {
+        TelemetryLevel& level = pyramid.levels[l];
+        level.start = 0;
+        level.count = 0;
+        level.openIndex = -1;
+        resetBucket(level.open, 0.0);
+    }
+    pyramid.samples = 0;
+}
+
+// Read the sampled channels of the viewed car from a snapshot
+void readTelemetrySample(const SharedMemory* sharedData, TelemetrySample& sample) {
+    for (int k = 0; k < TYRE_MAX; ++k) {
+        sample.groups[TELEMETRY_TYRE_TEMP].v[k] = sharedData->mTyreTemp[k];
+        sample.groups[TELEMETRY_TYRE_TREAD_TEMP].v[k] = sharedData->mTyreTreadTemp[k];
+        sample.groups[TELEMETRY_BRAKE_TEMP].v[k] = sharedData->mBrakeTempCelsius[k];
+        sample.groups[TELEMETRY_TYRE_WEAR].v[k] = sharedData->mTyreWear[k];
+        sample.groups[TELEMETRY_AIR_PRESSURE].v[k] = sharedData->mAirPressure[k];
+    }
+    TelemetryQuad& environment = sample.groups[TELEMETRY_ENVIRONMENT];
+    environment.v[TELEMETRY_RAIN_DENSITY] = sharedData->mRainDensity;
+    environment.v[TELEMETRY_TRACK_TEMPERATURE] = sharedData->mTrackTemperature;
+    environment.v[TELEMETRY_AMBIENT_TEMPERATURE] = sharedData->mAmbientTemperature;
+    environment.v[3] = 0.0f;
+}
+
+// Fold one sample into a bucket, four channels at a time
+static void accumulateSample(TelemetryBucket& bucket, const TelemetrySample& sample) {
+    for (int g = 0; g < TELEMETRY_GROUPS_MAX; ++g) {
+        const float* value = sample.groups[g].v;
+        float* min = bucket.min[g].v;
+        float* max = bucket.max[g].v;
+        float* sum = bucket.sum[g].v;
+        for (int k = 0; k < TYRE_MAX; ++k) {
+            min[k] = value[k] < min[k] ? value[k] : min[k];
+            max[k] = value[k] > max[k] ? value[k] : max[k];
+            sum[k] += value[k];
+        }
+    }
+    bucket.count++;
+}
+
+// Fold a closed bucket into the coarser one that contains it
+static void accumulateBucket(TelemetryBucket& into, const TelemetryBucket& from) {
+    for (int g = 0; g < TELEMETRY_GROUPS_MAX; ++g) {
+        for (int k = 0; k < TYRE_MAX; ++k) {
+            into.min[g].v[k] = from.min[g].v[k] < into.min[g].v[k] ? from.min[g].v[k] : into.min[g].v[k];
+            into.max[g].v[k] = from.max[g].v[k] > into.max[g].v[k] ? from.max[g].v[k] : into.max[g].v[k];
+            into.sum[g].v[k] += from.sum[g].v[k];
+        }
+    }
+    into.count += from.count;
+}
+
+// Store a closed bucket in its level's ring, dropping the oldest when full
+static void pushBucket(TelemetryLevel& level, int capacity, const TelemetryBucket& bucket) {
+    int slot = (level.start + level.count) % capacity;
+    if (level.count == capacity) {
+        level.start = (level.start + 1) % capacity;
+    } else {
+        level.count++;
+    }
+    level.buckets[slot] = bucket;
+}
+
+// Make 'index' the open bucket of level l, closing the previous one and rolling it up
+static void advanceLevel(TelemetryPyramid& pyramid, int l, long long index) {
+    TelemetryLevel& level = pyramid.levels[l];
+    if (level.openIndex == index) return;
+    if (level.openIndex >= 0 && level.open.count > 0) {
+        pushBucket(level, TELEMETRY_LEVEL_BUCKETS[l], level.open);
+        if (l + 1 < TELEMETRY_LEVELS_MAX) {
+            TelemetryLevel& parent = pyramid.levels[l + 1];
+            const long long parentIndex = static_cast<long long>(std::floor(level.open.startTime / TELEMETRY_LEVEL_SECONDS[l + 1]));
+            advanceLevel(pyramid, l + 1, parentIndex);
+            accumulateBucket(parent.open, level.open);
+        }
+    }
+    level.openIndex = index;
+    resetBucket(level.open, index * TELEMETRY_LEVEL_SECONDS[l]);
+}
+
+// Add one sample taken at 'now' (seconds on a monotonic clock); closing a bucket rolls it up into the next level
+void addTelemetrySample(TelemetryPyramid& pyramid, const TelemetrySample& sample, double now) {
+    const long long index = static_cast<long long>(std::floor(now / TELEMETRY_LEVEL_SECONDS[0]));
+    if (index < pyramid.levels[0].openIndex) return; // clock went backwards, keep what is there
+    advanceLevel(pyramid, 0, index);
+    accumulateSample(pyramid.levels[0].open, sample);
+    pyramid.samples++;
+}
+
+// Closed bucket 'index' of a level, oldest first
+const TelemetryBucket& telemetryBucketAt(const TelemetryPyramid& pyramid, int level, int index) {
+    const TelemetryLevel& l = pyramid.levels[level];
+    return l.buckets[(l.start + index) % TELEMETRY_LEVEL_BUCKETS[level]];
+}
+
+// Finest level that covers [startTime, endTime] in at most maxPoints buckets; charts read only that level
+int selectTelemetryLevel(const TelemetryPyramid& pyramid, double startTime, double endTime, int maxPoints) {
+    for (int l = 0; l < TELEMETRY_LEVELS_MAX; ++l) {
+        const TelemetryLevel& level = pyramid.levels[l];
+        const bool covers = level.count > 0 && telemetryBucketAt(pyramid, l, 0).startTime <= startTime;
+        const bool fits = (endTime - startTime) / TELEMETRY_LEVEL_SECONDS[l] <= maxPoints;
+        if (covers && fits) return l;
+    }
+    return TELEMETRY_LEVELS_MAX - 1;
+}
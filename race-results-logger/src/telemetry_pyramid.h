@@ -0,0 +1,92 @@
+#ifndef TELEMETRY_PYRAMID_H
+#define TELEMETRY_PYRAMID_H
+
+#include "SharedMemory.h"
+
+// Channel groups sampled per frame; each group is one value per tyre (TYRE_MAX wide)
+enum
+{
+  TELEMETRY_TYRE_TEMP = 0,                            // mTyreTemp [ UNITS = Celsius ]
+  TELEMETRY_TYRE_TREAD_TEMP,                          // mTyreTreadTemp [ UNITS = Kelvin ]
+  TELEMETRY_BRAKE_TEMP,                               // mBrakeTempCelsius [ UNITS = Celsius ]
+  TELEMETRY_TYRE_WEAR,                                // mTyreWear [ RANGE = 0.0f->1.0f ]
+  TELEMETRY_AIR_PRESSURE,                             // mAirPressure [ UNITS = PSI ]
+  TELEMETRY_ENVIRONMENT,                              // rain density, track and ambient temperature, unused
+  //-------------
+  TELEMETRY_GROUPS_MAX
+};
+
+// Slots of the TELEMETRY_ENVIRONMENT group
+enum
+{
+  TELEMETRY_RAIN_DENSITY = 0,
+  TELEMETRY_TRACK_TEMPERATURE,
+  TELEMETRY_AMBIENT_TEMPERATURE
+};
+
+// Pyramid levels: bucket width in seconds and buckets kept per level.
+// 1 s for the last hour, 10 s for the last 6 hours, 1 min for the last 24 hours.
+enum
+{
+  TELEMETRY_LEVELS_MAX = 3
+};
+static const double TELEMETRY_LEVEL_SECONDS[TELEMETRY_LEVELS_MAX] = {1.0, 10.0, 60.0};
+static const int TELEMETRY_LEVEL_BUCKETS[TELEMETRY_LEVELS_MAX] = {3600, 2160, 1440};
+
+// Four channel values processed together, one per tyre
+struct TelemetryQuad {
+    alignas(16) float v[TYRE_MAX];
+};
+
+// One frame of sampled channels
+struct TelemetrySample {
+    TelemetryQuad groups[TELEMETRY_GROUPS_MAX];
+};
+
+// Min, max and sum of every channel over one time bucket
+struct TelemetryBucket {
+    TelemetryQuad min[TELEMETRY_GROUPS_MAX];
+    TelemetryQuad max[TELEMETRY_GROUPS_MAX];
+    TelemetryQuad sum[TELEMETRY_GROUPS_MAX];
+    double startTime;                                 // [ UNITS = seconds ]
+    unsigned int count;
+};
+
+// One level: the bucket being filled and a ring of closed buckets
+struct TelemetryLevel {
+    TelemetryBucket* buckets;                         // TELEMETRY_LEVEL_BUCKETS entries, oldest at start
+    int start;
+    int count;
+    TelemetryBucket open;
+    long long openIndex;                              // bucket number of 'open' [ UNSET = -1 ]
+};
+
+// Min/max/mean pyramid of tyre, brake and weather channels over the whole session.
+// Memory is fixed at creation; each level drops its oldest buckets when full.
+struct TelemetryPyramid {
+    TelemetryLevel levels[TELEMETRY_LEVELS_MAX];
+    unsigned long long samples;
+};
+
+// Allocate the bucket rings and start empty
+void createTelemetryPyramid(TelemetryPyramid& pyramid);
+
+// Free the bucket rings
+void destroyTelemetryPyramid(TelemetryPyramid& pyramid);
+
+// Forget all buckets, e.g. when a new session starts
+void resetTelemetryPyramid(TelemetryPyramid& pyramid);
+
+// Read the sampled channels of the viewed car from a snapshot
+void readTelemetrySample(const SharedMemory* sharedData, TelemetrySample& sample);
+
+// Add one sample taken at 'now' (seconds on a monotonic clock); closing a bucket rolls it up into the next level
+void addTelemetrySample(TelemetryPyramid& pyramid, const TelemetrySample& sample, double now);
+
+// Closed bucket 'index' of a level, oldest first
+const TelemetryBucket& telemetryBucketAt(const TelemetryPyramid& pyramid, int level, int index);
+
+// Finest level that covers [startTime, endTime] in at most maxPoints buckets; charts read only that level
+int selectTelemetryLevel(const TelemetryPyramid& pyramid, double startTime, double endTime, int maxPoints);
+
+#endif // TELEMETRY_PYRAMID_H
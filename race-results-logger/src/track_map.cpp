@@ -0,0 +1,260 @@
+#include "track_map.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+static const double TWO_PI = 6.283185307179586;
+
+// Empty a trajectory and go back to keeping every sample
+static void resetTrajectory(CarTrajectory& trajectory) {
+    trajectory.count = 0;
+    trajectory.stride = 1;
+    trajectory.pending = 0;
+}
+
+// Forget all samples, e.g. when the track changes
+void resetTrackMap(TrackMap& map) {
+    map.trackName.clear();
+    map.trackLayout.clear();
+    map.trackLength = 0.0f;
+    for (int b = 0; b < TRACK_MAP_BINS; ++b) {
+        map.sumX[b] = 0.0;
+        map.sumZ[b] = 0.0;
+        map.samples[b] = 0;
+    }
+    for (int s = 0; s < TRACK_SECTORS_MAX; ++s) {
+        map.sectorSin[s] = 0.0;
+        map.sectorCos[s] = 0.0;
+        map.sectorSamples[s] = 0;
+    }
+    for (int i = 0; i < IDENTITY_MAX; ++i) {
+        map.lastSector[i] = -1;
+        resetTrajectory(map.trajectories[i]);
+        map.trajectoryNames[i].clear();
+        map.trajectoryStint[i] = 0;
+    }
+}
+
+// Append a sample to a trajectory; when the budget is full every other point is dropped
+// and the sampling stride doubles, so the whole session stays covered at lower resolution
+static void appendTrajectoryPoint(CarTrajectory& trajectory, const TrackPoint& point) {
+    if (trajectory.count > 0 && point.distance < trajectory.points[trajectory.count - 1].distance) {
+        resetTrajectory(trajectory); // restart or teleport, the old trajectory no longer applies
+    }
+    if (++trajectory.pending < trajectory.stride) return;
+    trajectory.pending = 0;
+    if (trajectory.count > 0 && point.distance == trajectory.points[trajectory.count - 1].distance) return;
+
+    if (trajectory.count == TRAJECTORY_POINTS_MAX) {
+        for (int j = 0; j < TRAJECTORY_POINTS_MAX / 2; ++j) {
+            trajectory.points[j] = trajectory.points[2 * j];
+        }
+        trajectory.count = TRAJECTORY_POINTS_MAX / 2;
+        trajectory.stride *= 2;
+    }
+    trajectory.points[trajectory.count++] = point;
+}
+
+// Accumulate racing-line, sector and trajectory samples from one snapshot, with the identities of its slots
+void updateTrackMap(TrackMap& map, const SharedMemory* sharedData, const SlotIdentities& slots) {
+    const float trackLength = sharedData->mTrackLength;
+    if (trackLength <= 0.0f) return;
+
+    if (trackLength != map.trackLength ||
+        map.trackName != sharedData->mTrackLocation ||
+        map.trackLayout != sharedData->mTrackVariation) {
+        resetTrackMap(map);
+        map.trackName = sharedData->mTrackLocation;
+        map.trackLayout = sharedData->mTrackVariation;
+        map.trackLength = trackLength;
+    }
+
+    int numParticipants = sharedData->mNumParticipants;
+    if (numParticipants > slots.numSlots) numParticipants = slots.numSlots;
+    const float binsPerMetre = TRACK_MAP_BINS / trackLength;
+
+    for (int s = 0; s < numParticipants; ++s) {
+        const ParticipantInfo& info = sharedData->mParticipantInfo[s];
+        const int i = slots.identity[s];
+        if (!info.mIsActive || i < 0) continue;
+
+        // A new stint of the identity starts its sector tracking and trajectory over
+        if (map.trajectoryStint[i] != slots.stint[s]) {
+            map.trajectoryStint[i] = slots.stint[s];
+            map.trajectoryNames[i] = info.mName;
+            map.lastSector[i] = -1;
+            resetTrajectory(map.trajectories[i]);
+        }
+        const float lapDistance = info.mCurrentLapDistance;
+        if (lapDistance < 0.0f || lapDistance >= trackLength) continue;
+        const float x = info.mWorldPosition[VEC_X];
+        const float z = info.mWorldPosition[VEC_Z];
+
+        // Racing line, leaving out cars in the pit lane
+        if (sharedData->mPitModes[s] == PIT_MODE_NONE) {
+            int bin = static_cast<int>(lapDistance * binsPerMetre);
+            if (bin >= TRACK_MAP_BINS) bin = TRACK_MAP_BINS - 1;
+            map.sumX[bin] += x;
+            map.sumZ[bin] += z;
+            map.samples[bin]++;
+        }
+
+        // Sector markers, averaged on the circle so a marker near the line does not split in two
+        const int sector = info.mCurrentSector;
+        if (map.lastSector[i] >= 0 && sector >= 0 && sector != map.lastSector[i]) {
+            const int marker = sector % TRACK_SECTORS_MAX;
+            const double angle = TWO_PI * lapDistance / trackLength;
+            map.sectorSin[marker] += std::sin(angle);
+            map.sectorCos[marker] += std::cos(angle);
+            map.sectorSamples[marker]++;
+        }
+        map.lastSector[i] = sector;
+
+        TrackPoint point = {x, z, info.mLapsCompleted * trackLength + lapDistance};
+        appendTrajectoryPoint(map.trajectories[i], point);
+    }
+}
+
+// Distance from p to the segment a-b on the track plane
+static float segmentDistance(const TrackPoint& p, const TrackPoint& a, const TrackPoint& b) {
+    const float dx = b.x - a.x;
+    const float dz = b.z - a.z;
+    const float lengthSquared = dx * dx + dz * dz;
+    float t = 0.0f;
+    if (lengthSquared > 0.0f) {
+        t = ((p.x - a.x) * dx + (p.z - a.z) * dz) / lengthSquared;
+        t = std::max(0.0f, std::min(1.0f, t));
+    }
+    const float ex = a.x + t * dx - p.x;
+    const float ez = a.z + t * dz - p.z;
+    return std::sqrt(ex * ex + ez * ez);
+}
+
+// Douglas-Peucker with an explicit stack; marks the points to keep
+static void simplifyPolyline(const std::vector<TrackPoint>& points, float tolerance, std::vector<bool>& keep) {
+    keep.assign(points.size(), false);
+    if (points.empty()) return;
+    keep.front() = true;
+    keep.back() = true;
+
+    std::vector<std::pair<size_t, size_t>> stack;
+    stack.push_back(std::make_pair(static_cast<size_t>(0), points.size() - 1));
+    while (!stack.empty()) {
+        size_t first = stack.back().first;
+        size_t last = stack.back().second;
+        stack.pop_back();
+        if (last <= first + 1) continue;
+
+        float worst = 0.0f;
+        size_t worstIndex = first;
+        for (size_t i = first + 1; i < last; ++i) {
+            float d = segmentDistance(points[i], points[first], points[last]);
+            if (d > worst) {
+                worst = d;
+                worstIndex = i;
+            }
+        }
+        if (worst > tolerance) {
+            keep[worstIndex] = true;
+            stack.push_back(std::make_pair(first, worstIndex));
+            stack.push_back(std::make_pair(worstIndex, last));
+        }
+    }
+}
+
+// Centre line from the averaged bins, simplified with Douglas-Peucker to within 'tolerance' metres
+TrackOutline buildTrackOutline(const TrackMap& map, float tolerance) {
+    TrackOutline outline;
+    outline.trackLength = map.trackLength;
+    for (int s = 0; s < TRACK_SECTORS_MAX; ++s) {
+        outline.sectorDistance[s] = -1.0f;
+        outline.sectorPoint[s] = -1;
+    }
+    if (map.trackLength <= 0.0f) return outline;
+
+    const float binLength = map.trackLength / TRACK_MAP_BINS;
+    std::vector<TrackPoint> centre;
+    for (int b = 0; b < TRACK_MAP_BINS; ++b) {
+        if (map.samples[b] == 0) continue;
+        TrackPoint point = {static_cast<float>(map.sumX[b] / map.samples[b]),
+                            static_cast<float>(map.sumZ[b] / map.samples[b]),
+                            (b + 0.5f) * binLength};
+        centre.push_back(point);
+    }
+
+    std::vector<bool> keep;
+    simplifyPolyline(centre, tolerance, keep);
+    for (size_t i = 0; i < centre.size(); ++i) {
+        if (keep[i]) outline.points.push_back(centre[i]);
+    }
+
+    // Bucket index: first outline point at or after the start of each lap-distance bin
+    outline.bucketStart.assign(TRACK_MAP_BINS + 1, static_cast<int>(outline.points.size()));
+    int next = 0;
+    for (int b = 0; b <= TRACK_MAP_BINS; ++b) {
+        const float binStart = b * binLength;
+        while (next < static_cast<int>(outline.points.size()) && outline.points[next].distance < binStart) ++next;
+        outline.bucketStart[b] = next;
+    }
+
+    for (int s = 0; s < TRACK_SECTORS_MAX; ++s) {
+        if (map.sectorSamples[s] == 0 || outline.points.empty()) continue;
+        double angle = std::atan2(map.sectorSin[s], map.sectorCos[s]);
+        if (angle < 0.0) angle += TWO_PI;
+        const float distance = static_cast<float>(angle / TWO_PI * map.trackLength);
+        outline.sectorDistance[s] = distance;
+
+        int bin = std::min(static_cast<int>(distance / binLength), static_cast<int>(TRACK_MAP_BINS) - 1);
+        int nearest = std::min(outline.bucketStart[bin], static_cast<int>(outline.points.size()) - 1);
+        if (nearest > 0 && distance - outline.points[nearest - 1].distance < outline.points[nearest].distance - distance) {
+            --nearest;
+        }
+        outline.sectorPoint[s] = nearest;
+    }
+    return outline;
+}
+
+// Interpolated outline position at a lap distance, using the bucket index
+TrackPoint outlinePointAt(const TrackOutline& outline, float lapDistance) {
+    TrackPoint result = {0.0f, 0.0f, lapDistance};
+    const int count = static_cast<int>(outline.points.size());
+    if (count == 0 || outline.trackLength <= 0.0f) return result;
+
+    int bin = static_cast<int>(lapDistance / outline.trackLength * TRACK_MAP_BINS);
+    bin = std::max(0, std::min(bin, static_cast<int>(TRACK_MAP_BINS)));
+    int i = outline.bucketStart[bin];
+    while (i < count && outline.points[i].distance < lapDistance) ++i;
+
+    // Neighbours around the lap, wrapping across the start/finish line
+    TrackPoint before = outline.points[(i + count - 1) % count];
+    TrackPoint after = outline.points[i % count];
+    if (i == 0) before.distance -= outline.trackLength;
+    if (i == count) after.distance += outline.trackLength;
+
+    const float span = after.distance - before.distance;
+    const float t = span > 0.0f ? (lapDistance - before.distance) / span : 0.0f;
+    result.x = before.x + t * (after.x - before.x);
+    result.z = before.z + t * (after.z - before.z);
+    return result;
+}
+
+// Interpolated trajectory position of a car at a race distance (binary search over the trajectory)
+bool trajectoryPointAt(const CarTrajectory& trajectory, float raceDistance, TrackPoint& point) {
+    if (trajectory.count == 0) return false;
+    const TrackPoint* first = trajectory.points;
+    const TrackPoint* last = trajectory.points + trajectory.count;
+    if (raceDistance < first->distance || raceDistance > (last - 1)->distance) return false;
+
+    const TrackPoint* after = std::lower_bound(first, last, raceDistance,
+        [](const TrackPoint& p, float d) { return p.distance < d; });
+    if (after == first) {
+        point = *first;
+        return true;
+    }
+    const TrackPoint* before = after - 1;
+    const float t = (raceDistance - before->distance) / (after->distance - before->distance);
+    point.x = before->x + t * (after->x - before->x);
+    point.z = before->z + t * (after->z - before->z);
+    point.distance = raceDistance;
+    return true;
+}
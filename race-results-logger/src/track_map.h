@@ -0,0 +1,91 @@
+#ifndef TRACK_MAP_H
+#define TRACK_MAP_H
+
+#include <string>
+#include <vector>
+#include "SharedMemory.h"
+#include "participant_identity.h"
+
+// Lap-distance bins used to average racing-line samples into a centre line
+enum
+{
+  TRACK_MAP_BINS = 2048
+};
+
+// Point budget per car trajectory; older points are thinned out when it is reached
+enum
+{
+  TRAJECTORY_POINTS_MAX = 512
+};
+
+// Sector markers kept for the track outline
+enum
+{
+  TRACK_SECTORS_MAX = 3
+};
+
+// One point on the track plane (world X/Z) with its distance along the lap or race
+struct TrackPoint {
+    float x;
+    float z;
+    float distance;                                   // [ UNITS = Metres ]
+};
+
+// Downsampled trajectory of one car, ordered by race distance
+struct CarTrajectory {
+    TrackPoint points[TRAJECTORY_POINTS_MAX];
+    int count;
+    int stride;                                       // keep every stride-th sample
+    int pending;                                      // samples seen since the last kept one
+};
+
+// Racing-line accumulator, simplified outline with sector markers and per-car trajectories.
+// Everything is fixed-size, so memory stays the same however long the session runs. Per-car
+// state is kept by participant identity, like the gap tracker, so a car moved to another slot
+// keeps its trajectory and one that leaves and comes back (a new stint) starts a new one.
+struct TrackMap {
+    std::string trackName;
+    std::string trackLayout;
+    float trackLength;
+
+    // Racing-line samples averaged per lap-distance bin
+    double sumX[TRACK_MAP_BINS];
+    double sumZ[TRACK_MAP_BINS];
+    unsigned int samples[TRACK_MAP_BINS];
+
+    // Sector changes accumulated as a circular mean of lap distance
+    double sectorSin[TRACK_SECTORS_MAX];
+    double sectorCos[TRACK_SECTORS_MAX];
+    unsigned int sectorSamples[TRACK_SECTORS_MAX];
+    int lastSector[IDENTITY_MAX];
+
+    CarTrajectory trajectories[IDENTITY_MAX];
+    std::string trajectoryNames[IDENTITY_MAX];
+    uint32_t trajectoryStint[IDENTITY_MAX];           // stint the trajectory belongs to [ UNSET = 0 ]
+};
+
+// Simplified outline built from a TrackMap, with an index from lap distance to outline point
+struct TrackOutline {
+    std::vector<TrackPoint> points;                   // ordered by lap distance
+    float sectorDistance[TRACK_SECTORS_MAX];          // [ UNSET = -1.0f ]
+    int sectorPoint[TRACK_SECTORS_MAX];               // outline point nearest each marker [ UNSET = -1 ]
+    std::vector<int> bucketStart;                     // first point at or after each lap-distance bin
+    float trackLength;
+};
+
+// Forget all samples, e.g. when the track changes
+void resetTrackMap(TrackMap& map);
+
+// Accumulate racing-line, sector and trajectory samples from one snapshot, with the identities of its slots
+void updateTrackMap(TrackMap& map, const SharedMemory* sharedData, const SlotIdentities& slots);
+
+// Centre line from the averaged bins, simplified with Douglas-Peucker to within 'tolerance' metres
+TrackOutline buildTrackOutline(const TrackMap& map, float tolerance);
+
+// Interpolated outline position at a lap distance, using the bucket index
+TrackPoint outlinePointAt(const TrackOutline& outline, float lapDistance);
+
+// Interpolated trajectory position of a car at a race distance (binary search over the trajectory)
+bool trajectoryPointAt(const CarTrajectory& trajectory, float raceDistance, TrackPoint& point);
+
+#endif // TRACK_MAP_H
@@ -0,0 +1,304 @@
+#include "upload.h"
+#include <curl/curl.h>
+#include <ctype.h>
+#include <string.h>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <filesystem>
+#include "compression.h"
+#include "logger.h"
+#include "output.h"
+#include "platform.h"
+#include "result_hash.h"
+#include "result_wire.h"
+
+// Link with curl
+#pragma comment(lib, "libcurl.lib")
+
+// Initialize curl once for the process
+void initUpload() {
+    curl_global_init(CURL_GLOBAL_ALL);
+}
+
+// Release curl's global state
+void cleanupUpload() {
+    curl_global_cleanup();
+}
+
+// Callback for libcurl to ignore response data
+size_t writeCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    return size * nmemb;
+}
+
+// One response header to keep: its name, and its value once seen (empty if the response had none)
+struct HeaderCapture {
+    const char* name;
+    std::string value;
+};
+
+// Callback for libcurl to keep the value of the response header named in a HeaderCapture
+static size_t headerCaptureCallback(char* buffer, size_t size, size_t nitems, void* userdata) {
+    HeaderCapture* capture = static_cast<HeaderCapture*>(userdata);
+    const size_t length = size * nitems;
+    const size_t nameLength = strlen(capture->name);
+    if (length > nameLength && buffer[nameLength] == ':') {
+        bool matches = true;
+        for (size_t i = 0; i < nameLength && matches; ++i) {
+            matches = tolower(static_cast<unsigned char>(buffer[i])) == tolower(static_cast<unsigned char>(capture->name[i]));
+        }
+        if (matches) {
+            std::string value(buffer + nameLength + 1, length - nameLength - 1);
+            const size_t first = value.find_first_not_of(" \t");
+            const size_t last = value.find_last_not_of(" \t\r\n");
+            capture->value = first == std::string::npos ? "" : value.substr(first, last - first + 1);
+        }
+    }
+    return length;
+}
+
+// Whether a comma-separated list of media types, as in Accept-Post, names contentType
+static bool listsMediaType(const std::string& list, const char* contentType) {
+    std::stringstream items(list);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        item = item.substr(0, item.find(';'));
+        const size_t first = item.find_first_not_of(" \t");
+        const size_t last = item.find_last_not_of(" \t");
+        if (first == std::string::npos) continue;
+        item = item.substr(first, last - first + 1);
+        for (char& c : item) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        if (item == contentType) return true;
+    }
+    return false;
+}
+
+// Cleared when the server answers 415 to the dictionary encoding; later uploads in this session go uncompressed
+static bool serverAcceptsDictionary = true;
+
+// Whether the server decodes binary results
+enum
+{
+  BINARY_SUPPORT_UNKNOWN = 0,                         // not probed yet
+  BINARY_SUPPORT_YES = 1,                             // advertised in RESULT_WIRE_ACCEPT_HEADER
+  BINARY_SUPPORT_NO = 2                               // not advertised, or a binary upload failed; JSON for the session
+};
+
+// Found by the capability probe before the first binary upload of the session
+static int serverBinarySupport = BINARY_SUPPORT_UNKNOWN;
+
+// Ask GET /upload which body types the server decodes. A server without the binary decoder never
+// names RESULT_WIRE_CONTENT_TYPE (an old one answers 404), so it is never sent a body it would
+// store as an empty result. False if the server could not be reached; the caller retries later.
+static bool probeBinarySupport(const ServerConfig& config) {
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        logMessage("ERROR", "Failed to initialize curl for the upload capability probe");
+        return false;
+    }
+    HeaderCapture acceptPost = {RESULT_WIRE_ACCEPT_HEADER, ""};
+    std::string url = "http://" + config.server + ":" + std::to_string(config.port) + "/upload";
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCaptureCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &acceptPost);
+    CURLcode res = curl_easy_perform(curl);
+    long httpCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+    curl_easy_cleanup(curl);
+
+    if (res != CURLE_OK) {
+        logMessage("ERROR", std::string("Failed to probe the server's upload formats: ") + curl_easy_strerror(res));
+        return false;
+    }
+    if (listsMediaType(acceptPost.value, RESULT_WIRE_CONTENT_TYPE)) {
+        logMessage("INFO", "Server accepts binary results");
+        serverBinarySupport = BINARY_SUPPORT_YES;
+    } else {
+        logMessage("INFO", "Server does not advertise binary results (HTTP " + std::to_string(httpCode) + (acceptPost.value.empty() ? std::string("") : ", " RESULT_WIRE_ACCEPT_HEADER ": " + acceptPost.value) +
+                           "), sending JSON for the rest of the session");
+        serverBinarySupport = BINARY_SUPPORT_NO;
+    }
+    return true;
+}
+
+// POST one body to /upload; httpCode is 0 if the request never got an answer. If echoedHash is
+// not NULL it receives the RESULT_WIRE_HASH_HEADER of the response, empty if there was none.
+static bool postBody(const std::string& filename, const std::string& body, const char* contentType, const char* contentEncoding, const ServerConfig& config, long& httpCode,
+                     std::string* echoedHash) {
+    httpCode = 0;
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        logMessage("ERROR", "Failed to initialize curl for " + filename);
+        return false;
+    }
+
+    std::string url = "http://" + config.server + ":" + std::to_string(config.port) + "/upload";
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.data());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    HeaderCapture hashHeader = {RESULT_WIRE_HASH_HEADER, ""};
+    if (echoedHash != NULL) {
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCaptureCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &hashHeader);
+    }
+
+    struct curl_slist* headers = NULL;
+    headers = curl_slist_append(headers, (std::string("Content-Type: ") + contentType).c_str());
+    if (contentEncoding != NULL) {
+        headers = curl_slist_append(headers, (std::string("Content-Encoding: ") + contentEncoding).c_str());
+    }
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+    if (echoedHash != NULL) *echoedHash = hashHeader.value;
+
+    if (res != CURLE_OK) {
+        logMessage("ERROR", "Failed to send " + filename + ": " + curl_easy_strerror(res));
+        return false;
+    }
+    return httpCode == 200;
+}
+
+// Send a result file via HTTP POST: .amsr files as binary, .zd spool files and, with compressUpload,
+// plain JSON deflated against the shared dictionary; each falls back to plain JSON on HTTP 415. Binary
+// is only sent once GET /upload advertised it, and also falls back when the server does not echo the
+// result hash. dictionary is NULL when none could be loaded.
+bool sendJsonFile(const std::string& filename, const ServerConfig& config, const CompressionDictionary* dictionary) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        logMessage("ERROR", "Failed to read JSON file: " + filename);
+        return false;
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string jsonData = buffer.str();
+    file.close();
+
+    // Binary results only go to a server that advertised them, and count as delivered only when it
+    // echoes their hash; any other answer sends JSON from then on.
+    long httpCode = 0;
+    if (std::filesystem::path(filename).extension() == RESULT_WIRE_EXTENSION) {
+        ResultDocument document;
+        if (!decodeResultsWire(jsonData, document)) {
+            logMessage("ERROR", "Failed to decode binary results in " + filename);
+            return false;
+        }
+        if (serverBinarySupport == BINARY_SUPPORT_UNKNOWN && !probeBinarySupport(config)) return false;
+        if (serverBinarySupport == BINARY_SUPPORT_YES) {
+            std::string echoedHash;
+            const bool answered = postBody(filename, jsonData, RESULT_WIRE_CONTENT_TYPE, NULL, config, httpCode, &echoedHash);
+            if (answered && echoedHash == formatHash(document.resultHash)) {
+                logMessage("INFO", "Successfully sent " + filename + " to server (" + std::to_string(jsonData.size()) + " bytes, binary)");
+                return true;
+            }
+            if (answered) {
+                logMessage("ERROR", "Server answered HTTP 200 to " + filename + " without " RESULT_WIRE_HASH_HEADER " " + formatHash(document.resultHash) +
+                                    (echoedHash.empty() ? std::string("") : " (got " + echoedHash + ")") + ", sending JSON for the rest of the session");
+            } else if (httpCode == 415) {
+                logMessage("INFO", "Server does not accept binary results, sending JSON for the rest of the session");
+            } else {
+                if (httpCode != 0) logMessage("ERROR", "Server returned HTTP " + std::to_string(httpCode) + " for " + filename);
+                return false;
+            }
+            serverBinarySupport = BINARY_SUPPORT_NO;
+        }
+
+        std::ostringstream json;
+        writeResultsJson(json, document.sessionName, document.trackName, document.trackLayout, document.resultHash, document.results);
+        jsonData = json.str();
+    }
+
+    bool spoolCompressed = std::filesystem::path(filename).extension() == COMPRESSED_SPOOL_EXTENSION;
+    std::string encoded;
+    bool useDictionary = false;
+    if (serverAcceptsDictionary) {
+        if (spoolCompressed) {
+            encoded = jsonData;
+            useDictionary = true;
+        } else if (config.compressUpload && dictionary != NULL && compressWithDictionary(jsonData, *dictionary, encoded)) {
+            useDictionary = true;
+        }
+    }
+
+    if (useDictionary) {
+        if (postBody(filename, encoded, "application/json", DICTIONARY_CONTENT_ENCODING, config, httpCode, NULL)) {
+            logMessage("INFO", "Successfully sent " + filename + " to server (" + std::to_string(encoded.size()) + " bytes, " DICTIONARY_CONTENT_ENCODING ")");
+            return true;
+        }
+        if (httpCode != 415) {
+            if (httpCode != 0) logMessage("ERROR", "Server returned HTTP " + std::to_string(httpCode) + " for " + filename);
+            return false;
+        }
+        logMessage("INFO", "Server does not accept " DICTIONARY_CONTENT_ENCODING ", sending uncompressed for the rest of the session");
+        serverAcceptsDictionary = false;
+    }
+
+    // Identity upload; spooled files have to be inflated first
+    if (spoolCompressed) {
+        std::string inflated;
+        if (dictionary == NULL || !decompressWithDictionary(jsonData, *dictionary, inflated)) {
+            logMessage("ERROR", "Cannot decompress " + filename + " for an uncompressed upload, dictionary missing or different");
+            return false;
+        }
+        jsonData.swap(inflated);
+    }
+    if (!postBody(filename, jsonData, "application/json", NULL, config, httpCode, NULL)) {
+        if (httpCode != 0) logMessage("ERROR", "Server returned HTTP " + std::to_string(httpCode) + " for " + filename);
+        return false;
+    }
+
+    logMessage("INFO", "Successfully sent " + filename + " to server");
+    return true;
+}
+
+// Process and send all result files (.json, .json.zd and .amsr) in output/ and raceinfo/
+void processOutputFiles(const ServerConfig& config, const CompressionDictionary* dictionary) {
+    if (config.disableUpload) {
+        logMessage("INFO", "Upload disabled, skipping processOutputFiles");
+        return;
+    }
+    namespace fs = std::filesystem;
+    if (!fs::exists("sent")) {
+        fs::create_directory("sent");
+        logMessage("INFO", "Created sent/ directory");
+    }
+    if (!fs::exists("output")) {
+        fs::create_directory("output");
+        logMessage("INFO", "Created output/ directory");
+    }
+    if (!fs::exists("raceinfo")) {
+        fs::create_directory("raceinfo");
+        logMessage("INFO", "Created raceinfo/ directory");
+    }
+
+    // Process files in both output/ and raceinfo/
+    std::vector<std::string> folders = {"output", "raceinfo"};
+    for (const auto& folder : folders) {
+        for (const auto& entry : fs::directory_iterator(folder)) {
+            const auto extension = entry.path().extension();
+            if (extension != ".json" && extension != COMPRESSED_SPOOL_EXTENSION && extension != RESULT_WIRE_EXTENSION) continue;
+
+            std::string filename = entry.path().string();
+            while (!sendJsonFile(filename, config, dictionary)) {
+                logMessage("INFO", "Retrying " + filename + " in 15 seconds");
+                sleepMs(15000); // Retry every 15 seconds
+            }
+
+            std::string sentFilename = "sent/" + entry.path().filename().string();
+            try {
+                fs::rename(filename, sentFilename);
+                logMessage("INFO", "Moved " + filename + " to " + sentFilename);
+            } catch (const fs::filesystem_error& e) {
+                logMessage("ERROR", "Failed to move " + filename + " to sent/: " + e.what());
+            }
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef UPLOAD_H
+#define UPLOAD_H
+
+#include <string>
+#include "compression.h"
+#include "config.h"
+
+// Initialize curl once for the process
+void initUpload();
+
+// Release curl's global state
+void cleanupUpload();
+
+// Send a result file via HTTP POST: .amsr files as binary, .zd spool files and, with compressUpload,
+// plain JSON deflated against the shared dictionary; each falls back to plain JSON on HTTP 415. Binary
+// is only sent once GET /upload advertised it, and also falls back when the server does not echo the
+// result hash. dictionary is NULL when none could be loaded.
+bool sendJsonFile(const std::string& filename, const ServerConfig& config, const CompressionDictionary* dictionary);
+
+// Process and send all result files (.json, .json.zd and .amsr) in output/ and raceinfo/
+void processOutputFiles(const ServerConfig& config, const CompressionDictionary* dictionary);
+
+#endif // UPLOAD_H
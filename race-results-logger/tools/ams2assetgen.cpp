@@ -0,0 +1,261 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "asset_ids.h"
+
+// Build-time generator of the perfect-hash asset ID tables in asset_ids_table.h, from the
+// server's CSV data tables. Runs before ams2core is compiled (CMake custom command, build.bat).
+
+// One key of a table: the game name and its ID
+struct AssetKey {
+    std::string name;
+    uint32_t id;
+};
+
+// A generated table ready to be written out
+struct GeneratedTable {
+    const char* prefix;
+    std::vector<AssetKey> keys;
+    std::vector<int> slots;                           // key index per slot   [ UNSET = -1 ]
+    std::vector<uint16_t> displacements;
+};
+
+// Split one CSV line into fields, honouring double quotes
+static std::vector<std::string> splitCsvLine(const std::string& line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                fields.back() += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                fields.back() += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+// Read the given columns of a CSV file, joined with '\0' when there are two; false if the file or a column is missing
+static bool readCsvKeys(const std::string& filename, const char* column, const char* secondColumn,
+                        std::vector<std::string>& keys) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        printf("ERROR: Cannot open %s\n", filename.c_str());
+        return false;
+    }
+    std::string line;
+    std::getline(in, line);
+    if (line.compare(0, 3, "\xEF\xBB\xBF") == 0) line.erase(0, 3);
+    std::vector<std::string> header = splitCsvLine(line);
+    int first = -1;
+    int second = -1;
+    for (size_t i = 0; i < header.size(); ++i) {
+        if (header[i] == column) first = static_cast<int>(i);
+        if (secondColumn != NULL && header[i] == secondColumn) second = static_cast<int>(i);
+    }
+    if (first < 0 || (secondColumn != NULL && second < 0)) {
+        printf("ERROR: %s has no column '%s'%s%s\n", filename.c_str(), column,
+               secondColumn != NULL ? " or '" : "", secondColumn != NULL ? secondColumn : "");
+        return false;
+    }
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields = splitCsvLine(line);
+        if (static_cast<int>(fields.size()) <= std::max(first, second) || fields[first].empty()) continue;
+        std::string key = fields[first];
+        if (second >= 0) {
+            key += '\0';
+            key += fields[second];
+        }
+        keys.push_back(key);
+    }
+    return true;
+}
+
+// Printable form of a key for messages
+static std::string displayName(const std::string& name) {
+    std::string display = name;
+    std::replace(display.begin(), display.end(), '\0', '/');
+    return display;
+}
+
+// Hash the keys, drop duplicates and fail on two different names with one ID (or an ID of 0)
+static bool hashKeys(const std::vector<std::string>& names, std::vector<AssetKey>& keys) {
+    for (const std::string& name : names) {
+        uint32_t id = fnv1a32(name.data(), name.size());
+        bool duplicate = false;
+        for (const AssetKey& key : keys) {
+            if (key.id != id) continue;
+            if (key.name != name) {
+                printf("ERROR: '%s' and '%s' share asset ID %08x\n", displayName(key.name).c_str(),
+                       displayName(name).c_str(), id);
+                return false;
+            }
+            duplicate = true;
+        }
+        if (id == ASSET_ID_UNKNOWN) {
+            printf("ERROR: '%s' hashes to the unknown asset ID 0\n", displayName(name).c_str());
+            return false;
+        }
+        if (!duplicate) keys.push_back({name, id});
+    }
+    return true;
+}
+
+// Hash and displace: spread the keys over buckets, then place the largest buckets first,
+// searching each for a displacement that sends all its keys to free slots
+static bool buildPerfectHash(GeneratedTable& table) {
+    const size_t count = table.keys.size();
+    size_t slotCount = 1;
+    while (slotCount < count + count / 4 + 1) slotCount *= 2;
+    const size_t bucketCount = count / 4 + 1;
+    table.slots.assign(slotCount, -1);
+    table.displacements.assign(bucketCount, 0);
+
+    std::vector<std::vector<int>> buckets(bucketCount);
+    for (size_t k = 0; k < count; ++k) buckets[table.keys[k].id % bucketCount].push_back(static_cast<int>(k));
+    std::vector<size_t> order(bucketCount);
+    for (size_t b = 0; b < bucketCount; ++b) order[b] = b;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    for (size_t b : order) {
+        if (buckets[b].empty()) break;
+        bool placed = false;
+        for (uint32_t displacement = 0; displacement <= 0xFFFF && !placed; ++displacement) {
+            std::vector<uint32_t> chosen;
+            placed = true;
+            for (int k : buckets[b]) {
+                uint32_t slot = mixAssetHash(table.keys[k].id, displacement) & static_cast<uint32_t>(slotCount - 1);
+                if (table.slots[slot] >= 0 || std::find(chosen.begin(), chosen.end(), slot) != chosen.end()) {
+                    placed = false;
+                    break;
+                }
+                chosen.push_back(slot);
+            }
+            if (!placed) continue;
+            for (size_t i = 0; i < chosen.size(); ++i) table.slots[chosen[i]] = buckets[b][i];
+            table.displacements[b] = static_cast<uint16_t>(displacement);
+        }
+        if (!placed) {
+            printf("ERROR: No displacement places bucket %zu of %s\n", b, table.prefix);
+            return false;
+        }
+    }
+    return true;
+}
+
+// C string literal of a key; octal escapes for everything but plain ASCII, so '\0' and UTF-8 survive
+static std::string cStringLiteral(const std::string& name) {
+    std::string literal = "\"";
+    for (unsigned char c : name) {
+        if (c >= 0x20 && c < 0x7F && c != '"' && c != '\\' && c != '?') {
+            literal += static_cast<char>(c);
+        } else {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\%03o", c);
+            literal += escape;
+        }
+    }
+    return literal + "\"";
+}
+
+// Write one table: slots, displacements, the AssetTable and a compile-time check of the first key
+static void writeTable(std::ostream& out, const GeneratedTable& table) {
+    out << "// " << table.keys.size() << " names in " << table.slots.size() << " slots, "
+        << table.displacements.size() << " buckets\n";
+    out << "constexpr AssetEntry " << table.prefix << "_SLOTS[" << table.slots.size() << "] = {\n";
+    for (int k : table.slots) {
+        if (k < 0) {
+            out << "    {NULL, 0, 0},\n";
+        } else {
+            char id[16];
+            snprintf(id, sizeof(id), "0x%08xu", table.keys[k].id);
+            out << "    {" << cStringLiteral(table.keys[k].name) << ", " << table.keys[k].name.size() << ", " << id << "},\n";
+        }
+    }
+    out << "};\n";
+    out << "constexpr uint16_t " << table.prefix << "_DISPLACEMENTS[" << table.displacements.size() << "] = {";
+    for (size_t b = 0; b < table.displacements.size(); ++b) {
+        out << (b % 16 == 0 ? "\n    " : " ") << table.displacements[b] << ",";
+    }
+    out << "\n};\n";
+    out << "constexpr AssetTable " << table.prefix << " = {" << table.prefix << "_SLOTS, " << table.slots.size() - 1
+        << "u, " << table.prefix << "_DISPLACEMENTS, " << table.displacements.size() << "u};\n";
+    const AssetKey& first = table.keys.front();
+    char id[16];
+    snprintf(id, sizeof(id), "0x%08xu", first.id);
+    out << "static_assert(lookupAssetId(" << table.prefix << ", " << cStringLiteral(first.name) << ", "
+        << first.name.size() << ") == " << id << ", \"" << table.prefix << " lookup\");\n\n";
+}
+
+// Generate the asset ID tables from the server's CSV folder:
+// ams2assetgen <csv folder> <output header>
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("Usage: ams2assetgen <csv folder> <output header>\n");
+        return 1;
+    }
+    const std::string folder = std::string(argv[1]) + "/";
+    const std::string output = argv[2];
+
+    struct Source {
+        const char* prefix;
+        const char* file;
+        const char* column;
+        const char* secondColumn;
+    };
+    const Source sources[] = {
+        {"CAR_ASSETS", "Car Data Table.csv", "Car Game Internal Name", NULL},
+        {"CAR_CLASS_ASSETS", "Car Class Data Table.csv", "Car Class Game Internal Name", NULL},
+        {"TRACK_ASSETS", "Track Data Table.csv", "Track", "Layout Name in Game"},
+        {"LOCATION_ASSETS", "Location Data Table.csv", "location", NULL},
+    };
+
+    std::stringstream out;
+    out << "// Generated by ams2assetgen from race-results-server/fs/data/csv, do not edit\n";
+    out << "#ifndef ASSET_IDS_TABLE_H\n#define ASSET_IDS_TABLE_H\n\n#include <stddef.h>\n#include \"asset_ids.h\"\n\n";
+    for (const Source& source : sources) {
+        std::vector<std::string> names;
+        GeneratedTable table;
+        table.prefix = source.prefix;
+        if (!readCsvKeys(folder + source.file, source.column, source.secondColumn, names)) return 1;
+        if (!hashKeys(names, table.keys)) return 1;
+        if (table.keys.empty()) {
+            printf("ERROR: %s has no names\n", source.file);
+            return 1;
+        }
+        if (!buildPerfectHash(table)) return 1;
+        writeTable(out, table);
+        printf("%s: %zu names\n", source.prefix, table.keys.size());
+    }
+    out << "#endif // ASSET_IDS_TABLE_H\n";
+
+    // Leave an unchanged header alone so nothing that includes it is rebuilt
+    std::ifstream existing(output, std::ios::binary);
+    std::stringstream previous;
+    previous << existing.rdbuf();
+    if (existing.is_open() && previous.str() == out.str()) return 0;
+    existing.close();
+    std::ofstream file(output, std::ios::binary);
+    file << out.str();
+    if (!file.good()) {
+        printf("ERROR: Failed to write %s\n", output.c_str());
+        return 1;
+    }
+    return 0;
+}
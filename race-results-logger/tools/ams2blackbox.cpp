@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include "black_box.h"
+#include "results.h"
+
+// Replay a black box dump as one CSV row per frame of the viewed car and its last collision:
+// ams2blackbox <dump.amsb>
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        printf("Usage: ams2blackbox <dump" BLACK_BOX_EXTENSION ">\n");
+        return 1;
+    }
+    std::ifstream in(argv[1], std::ios::binary);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string data = buffer.str();
+
+    BlackBoxReader reader;
+    if (!openBlackBoxDump(data, reader)) {
+        printf("ERROR: %s is not a black box dump for shared memory version %d\n", argv[1], SHARED_MEMORY_VERSION);
+        return 1;
+    }
+    printf("# Reason: %s, trigger at %.3f s, %u frames\n", reader.reason.c_str(), reader.triggerTime, reader.records);
+    printf("Time,Sequence,Session,RaceState,Lap,LapDistance,Speed,Throttle,Brake,Steering,Gear,CrashState,CollisionIndex,CollisionMagnitude\n");
+
+    double time;
+    unsigned int frames = 0;
+    while (nextBlackBoxFrame(reader, time)) {
+        const SharedMemory* frame = reinterpret_cast<const SharedMemory*>(reader.frame);
+        const int viewed = frame->mViewedParticipantIndex;
+        const bool valid = viewed >= 0 && viewed < STORED_PARTICIPANTS_MAX;
+        const ParticipantInfo* info = valid ? &frame->mParticipantInfo[viewed] : NULL;
+        printf("%.3f,%u,%s,%s,%u,%.1f,%.2f,%.2f,%.2f,%.2f,%d,%u,%d,%.3f\n", time, frame->mSequenceNumber,
+               getSessionName(frame->mSessionState).c_str(), valid ? getRaceStatus(frame->mRaceStates[viewed]).c_str() : "",
+               info ? info->mCurrentLap : 0, info ? info->mCurrentLapDistance : 0.0f, frame->mSpeed, frame->mThrottle,
+               frame->mBrake, frame->mSteering, frame->mGear, frame->mCrashState, frame->mLastOpponentCollisionIndex,
+               frame->mLastOpponentCollisionMagnitude);
+        frames++;
+    }
+    closeBlackBoxDump(reader);
+    if (frames != reader.records) {
+        printf("ERROR: Dump is corrupt after %u of %u frames\n", frames, reader.records);
+        return 1;
+    }
+    return 0;
+}
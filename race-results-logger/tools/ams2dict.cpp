@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include "compression.h"
+
+// Default dictionary budget; deflate can reference at most 32 KB
+static const size_t DEFAULT_DICTIONARY_SIZE = 16384;
+
+// Read every .json result file under the given paths (files or folders, searched recursively)
+static void collectSamples(const std::string& path, std::vector<std::string>& samples) {
+    namespace fs = std::filesystem;
+    std::vector<fs::path> files;
+    if (fs::is_directory(path)) {
+        for (const auto& entry : fs::recursive_directory_iterator(path)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".json") files.push_back(entry.path());
+        }
+    } else {
+        files.push_back(path);
+    }
+    for (const auto& file : files) {
+        std::ifstream in(file, std::ios::binary);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        if (!isResultDocument(buffer.str())) {
+            printf("Skipping %s: not a result document\n", file.string().c_str());
+            continue;
+        }
+        samples.push_back(buffer.str());
+    }
+}
+
+// Train the result-compression dictionary from an archive of result files:
+// ams2dict [-size bytes] <output.dict> <file or folder>...
+int main(int argc, char** argv) {
+    size_t maxSize = DEFAULT_DICTIONARY_SIZE;
+    int arg = 1;
+    if (arg + 1 < argc && std::string(argv[arg]) == "-size") {
+        maxSize = static_cast<size_t>(atol(argv[arg + 1]));
+        arg += 2;
+    }
+    if (argc - arg < 2) {
+        printf("Usage: ams2dict [-size bytes] <output.dict> <file or folder>...\n");
+        return 1;
+    }
+    const std::string output = argv[arg++];
+
+    std::vector<std::string> samples;
+    for (; arg < argc; ++arg) collectSamples(argv[arg], samples);
+    if (samples.empty()) {
+        printf("ERROR: No .json samples found\n");
+        return 1;
+    }
+
+    CompressionDictionary dictionary = trainDictionary(samples, maxSize);
+    if (dictionary.data.empty() || !saveDictionary(output, dictionary)) {
+        printf("ERROR: Failed to write dictionary %s\n", output.c_str());
+        return 1;
+    }
+    printf("Dictionary %s: %zu bytes from %zu samples, id %08lx\n", output.c_str(), dictionary.data.size(), samples.size(), dictionary.id);
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "output.h"
+#include "result_hash.h"
+#include "result_wire.h"
+#include "standings.h"
+
+// Binary results (.amsr) under a path, a file or a folder searched recursively, in name order
+static void collectResultFiles(const std::string& path, std::vector<std::string>& files) {
+    namespace fs = std::filesystem;
+    if (!fs::is_directory(path)) {
+        files.push_back(path);
+        return;
+    }
+    std::vector<std::string> found;
+    for (const auto& entry : fs::recursive_directory_iterator(path)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".amsr") found.push_back(entry.path().string());
+    }
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+}
+
+// Print one table in standings order
+static void printTable(const std::vector<StandingTally>& drivers) {
+    const std::vector<int> order = rankStandings(drivers);
+    printf("%4s  %-32s %6s %5s %4s %4s %4s\n", "Pos", "Driver", "Points", "Races", "Wins", "Pods", "Best");
+    for (size_t p = 0; p < order.size(); ++p) {
+        const StandingTally& tally = drivers[order[p]];
+        printf("%4zu  %-32s %6d %5d %4d %4d %4d\n", p + 1, tally.driverName.c_str(), tally.points, tally.races,
+               tally.wins, tally.podiums, tally.bestFinish);
+    }
+}
+
+// Apply one finished race, save and reload the snapshot as a restarted logger would, apply the same
+// race again from a fresh capture and make sure it was counted once
+static bool checkRestartCountsOnce(const std::string& snapshot) {
+    std::vector<RaceResult> results;
+    const char* drivers[] = {"Check Driver A", "Check Driver B", "Check Driver C"};
+    for (unsigned int p = 0; p < 3; ++p) {
+        RaceResult result = {};
+        result.position = p + 1;
+        result.driverName = drivers[p];
+        result.sessionName = "Race";
+        result.carName = "Check Car";
+        result.trackName = "Check Track";
+        result.trackLayout = "Check Layout";
+        result.carClass = "Check Class";
+        result.carId = ASSET_ID_UNKNOWN;
+        result.carClassId = ASSET_ID_UNKNOWN;
+        result.gapToLeader = p * 1.5f;
+        result.interval = p > 0 ? 1.5f : 0.0f;
+        result.lapsCompleted = 10;
+        result.fastestLapTime = 90.0f + p;
+        result.lastLapTime = 91.0f + p;
+        results.push_back(result);
+    }
+
+    Standings* before = new Standings;
+    resetStandings(*before);
+    const bool firstApplied = applyRaceResult(*before, hashResults("Race", "Check Track", "Check Layout", results), results);
+    const bool saved = saveStandings(snapshot, *before);
+    delete before;
+
+    // The restarted logger sees the results screen again: gaps it rebuilds from nothing are lost
+    Standings* after = new Standings;
+    const bool loaded = saved && loadStandings(snapshot, *after);
+    for (RaceResult& result : results) {
+        result.gapToLeader = -1.0f;
+        result.interval = -1.0f;
+    }
+    const bool secondApplied = loaded && applyRaceResult(*after, hashResults("Race", "Check Track", "Check Layout", results), results);
+    const bool countedOnce = firstApplied && loaded && !secondApplied && after->races == 1 && after->drivers.size() == 3 && after->drivers[0].races == 1;
+    printf("Restart check: %s (%d races, first apply %s, second apply %s)\n", countedOnce ? "counted once" : "FAILED",
+           loaded ? after->races : 0, firstApplied ? "counted" : "skipped", secondApplied ? "counted" : "skipped");
+    delete after;
+    std::filesystem::remove(snapshot);
+    return countedOnce;
+}
+
+// Query the logger's season standings, or backfill them from archived binary race results:
+// ams2standings [-snapshot file] [-class name] [-json file] [result.amsr or folder]...
+// ams2standings -check [-snapshot file] runs the restart check against a scratch snapshot instead
+int main(int argc, char** argv) {
+    std::string snapshot = STANDINGS_SNAPSHOT_FILE;
+    std::string carClass;
+    std::string jsonOutput;
+    std::vector<std::string> files;
+    bool check = false;
+    for (int arg = 1; arg < argc; ++arg) {
+        const std::string option = argv[arg];
+        if ((option == "-snapshot" || option == "-class" || option == "-json") && arg + 1 < argc) {
+            std::string& value = option == "-snapshot" ? snapshot : option == "-class" ? carClass : jsonOutput;
+            value = argv[++arg];
+        } else if (option == "-check") {
+            check = true;
+        } else if (!option.empty() && option[0] == '-') {
+            printf("Usage: ams2standings [-snapshot file] [-class name] [-json file] [result.amsr or folder]...\n"
+                   "       ams2standings -check [-snapshot scratch file]\n");
+            return 1;
+        } else {
+            collectResultFiles(option, files);
+        }
+    }
+
+    if (check) {
+        return checkRestartCountsOnce(snapshot == STANDINGS_SNAPSHOT_FILE ? "standings-check.dat" : snapshot) ? 0 : 1;
+    }
+
+    Standings* standings = new Standings;
+    if (!loadStandings(snapshot, *standings)) {
+        delete standings;
+        return 1;
+    }
+
+    // Only race sessions count; results already in the snapshot are skipped by their hash
+    int applied = 0;
+    for (const std::string& filename : files) {
+        std::ifstream in(filename, std::ios::binary);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        ResultDocument document;
+        if (!decodeResultsWire(buffer.str(), document)) {
+            printf("Skipping %s: not a binary result document\n", filename.c_str());
+            continue;
+        }
+        if (document.sessionName != "Race") continue;
+        // Documents written without a hash get the one the logger would have given them
+        const uint64_t resultHash = document.resultHash != 0 ? document.resultHash
+            : hashResults(document.sessionName, document.trackName, document.trackLayout, document.results);
+        if (applyRaceResult(*standings, resultHash, document.results)) ++applied;
+    }
+    if (applied > 0 && !saveStandings(snapshot, *standings)) {
+        printf("ERROR: Failed to write %s\n", snapshot.c_str());
+        delete standings;
+        return 1;
+    }
+
+    printf("%s: %d races, %zu drivers, %zu classes (%d added)\n\n", snapshot.c_str(), standings->races,
+           standings->drivers.size(), standings->classes.size(), applied);
+    if (carClass.empty()) {
+        printTable(standings->drivers);
+    } else if (const ClassStandings* classStandings = findClassStandings(*standings, carClass)) {
+        printf("%s, %d races\n", carClass.c_str(), classStandings->races);
+        printTable(classStandings->drivers);
+    } else {
+        printf("No races of class %s\n", carClass.c_str());
+    }
+
+    if (!jsonOutput.empty()) {
+        std::ofstream json(jsonOutput, std::ios::out);
+        writeStandingsJson(json, *standings);
+        if (!json.good()) {
+            printf("ERROR: Failed to write %s\n", jsonOutput.c_str());
+            delete standings;
+            return 1;
+        }
+    }
+    delete standings;
+    return 0;
+}
@@ -0,0 +1,31 @@
+const { DICTIONARY_ENCODING, ACCEPT_ENCODING, ACCEPT_POST, RESULT_HASH_HEADER, isBinaryResult, parseUpload } = require('../utils/uploadEncoding');
+
+// Decodes binary and dictionary-compressed uploads before express.json() sees them; other
+// bodies are left to express.json(), which answers 415 for encodings it cannot read.
+// GET /upload is the logger's capability probe and only gets the headers.
+function decodeUpload(req, res, next) {
+    res.set('Accept-Encoding', ACCEPT_ENCODING);
+    res.set('Accept-Post', ACCEPT_POST);
+    if (req.method === 'GET') return res.status(204).end();
+    const encoding = (req.headers['content-encoding'] || '').trim().toLowerCase();
+    const binary = isBinaryResult(req.headers['content-type']);
+    if (encoding !== DICTIONARY_ENCODING && !binary) return next();
+
+    const chunks = [];
+    req.on('data', (chunk) => chunks.push(chunk));
+    req.on('error', next);
+    req.on('end', () => {
+        try {
+            req.body = parseUpload(Buffer.concat(chunks), req.headers['content-type'], encoding);
+            req._body = true; // tells express.json() the body is already parsed
+            if (binary) res.set(RESULT_HASH_HEADER, req.body.ResultHash);
+            next();
+        } catch (error) {
+            const status = error.status || 400;
+            console.error(`Error decoding upload: ${error.message}`);
+            res.status(status).json({ message: `Error decoding upload: ${error.message}` });
+        }
+    });
+}
+
+module.exports = decodeUpload;
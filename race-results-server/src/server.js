@@ -1,6 +1,7 @@
 const express = require('express');
 const cors = require('cors');
 const path = require('path');
+const decodeUpload = require('./middleware/decodeUpload');
 const uploadRoutes = require('./routes/upload');
 const resultsRoutes = require('./routes/results');
 const driverRoutes = require('./routes/driver');
@@ -14,6 +15,7 @@ const imagesPath = path.join(__dirname, '../fs/images');
 console.log(`Serving images from: ${imagesPath}`);
 
 app.use(cors());
+app.use('/upload', decodeUpload);
 app.use(express.json());
 
 app.use('/upload', uploadRoutes);
@@ -2,6 +2,7 @@ const { POINTS_SYSTEM } = require('../utils/constants');
 const fs = require('fs');
 const csvParser = require('csv-parser');
 const path = require('path');
+const { assetId, trackAssetId, createAssetIndex } = require('../utils/assetIds');
 
 // Load CSVs (run once at startup or cache)
 const carsData = [];
@@ -18,6 +19,10 @@ fs.createReadStream(path.join(__dirname, '../../fs/data/csv/Track Data Table.csv
   .on('end', () => console.log('Track Data Table.csv loaded'))
   .on('error', (error) => console.error('Error loading Track Data Table.csv:', error));
 
+// Join results on the logger's asset IDs; results from older loggers carry names only
+const carById = createAssetIndex(carsData, c => assetId(c['Car Game Internal Name']));
+const trackById = createAssetIndex(tracksData, t => trackAssetId(t['Track'], t['Layout Name in Game']));
+
 function calculateDriverPoints(raceResults) {
     const driverPoints = {};
 
@@ -39,6 +44,9 @@ function calculateDriverPoints(raceResults) {
 function calculateDriverPointsTable(raceResults) {
     const driverData = {};
     const trackLayouts = raceResults.map(race => race.TrackLayout);
+    // An ID of 0 is a name the logger's tables did not know, e.g. a row added to the CSV after it was
+    // built, so it falls back to the name like a result without IDs
+    const trackIds = raceResults.map(race => race.TrackId || trackAssetId(race.TrackName, race.TrackLayout));
 
     // Log available TrackLayout values for debugging
     console.log('TrackLayouts from race results:', trackLayouts);
@@ -64,8 +72,8 @@ function calculateDriverPointsTable(raceResults) {
             driverData[driver.DriverName].racePoints[race.TrackLayout] = points;
             driverData[driver.DriverName].totalPoints += points;
 
-            // Add car image from CSV (match by Car Game Internal Name)
-            const carMatch = carsData.find(c => c['Car Game Internal Name'] === driver.CarName);
+            // Add car image from CSV (match by the asset ID of Car Game Internal Name)
+            const carMatch = carById(driver.CarId || assetId(driver.CarName));
             if (carMatch && carMatch['Image File Name'] && carMatch['Car Class Game Internal Name']) {
                 const carImagePath = `/images/cars/${carMatch['Car Class Game Internal Name']}/${carMatch['Image File Name']}`;
                 driverData[driver.DriverName].carImage = carImagePath;
@@ -83,8 +91,8 @@ function calculateDriverPointsTable(raceResults) {
     });
 
     // Add track images to trackLayouts
-    const enrichedTrackLayouts = trackLayouts.map(track => {
-        const trackMatch = tracksData.find(t => t['Layout Name in Game'] === track);
+    const enrichedTrackLayouts = trackLayouts.map((track, i) => {
+        const trackMatch = trackById(trackIds[i]) || tracksData.find(t => t['Layout Name in Game'] === track);
         const imagePath = trackMatch && trackMatch['Image Name'] ? `/images/tracks/${trackMatch['Image Name']}` : '';
         // Log for debugging
         if (imagePath) {
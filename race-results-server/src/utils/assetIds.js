@@ -0,0 +1,38 @@
+// Asset IDs as the logger computes them (race-results-logger/src/asset_ids.h): the FNV-1a hash
+// of the UTF-8 game name, 0 for a name the CSV tables do not know. Results carry CarId,
+// CarClassId, TrackId and LocationId, so CSV rows can be looked up by number.
+
+const ASSET_ID_UNKNOWN = 0;
+
+// FNV-1a 32-bit hash of a name
+function assetId(name) {
+    let hash = 0x811c9dc5;
+    for (const byte of Buffer.from(name, 'utf8')) {
+        hash ^= byte;
+        hash = Math.imul(hash, 0x01000193) >>> 0;
+    }
+    return hash;
+}
+
+// Layout names repeat across locations ("Grand Prix"), so a track's key is location + layout
+function trackAssetId(location, layout) {
+    return assetId(`${location}\u0000${layout}`);
+}
+
+// Index CSV rows by the asset ID of their key; rows are pushed as they stream in, so keep the
+// index in step with the array rather than building it once
+function createAssetIndex(rows, keyOf) {
+    const index = new Map();
+    let indexed = 0;
+    return (id) => {
+        for (; indexed < rows.length; indexed++) index.set(keyOf(rows[indexed]), rows[indexed]);
+        return index.get(id);
+    };
+}
+
+module.exports = {
+    ASSET_ID_UNKNOWN,
+    assetId,
+    trackAssetId,
+    createAssetIndex
+};
@@ -0,0 +1,144 @@
+// Decoder (and encoder, for tests and benchmarks) for the logger's binary result format,
+// see race-results-logger/src/result_wire.h for the layout. Decoding gives the same
+// object the JSON upload parses to, so the rest of the server does not see a difference.
+
+const RESULT_WIRE_CONTENT_TYPE = 'application/x-ams2-results';
+const MAGIC = 'AMSR';
+const VERSION = 1;
+const HEADER_SIZE = 24;
+const DRIVER_SIZE = 28;
+
+// Times as the JSON path writes them: millisecond precision, -1 when unset
+function roundTime(value) {
+    return value < 0 ? -1 : Math.round(value * 1000) / 1000;
+}
+
+// Names are short and nearly always ASCII; building those directly is much cheaper than a
+// Buffer.toString() call per string
+function readString(buffer, start, end) {
+    let ascii = '';
+    for (let i = start; i < end; i++) {
+        const byte = buffer[i];
+        if (byte >= 0x80) return buffer.toString('utf8', start, end);
+        ascii += String.fromCharCode(byte);
+    }
+    return ascii;
+}
+
+function wireError(message) {
+    const error = new Error(message);
+    error.status = 400;
+    return error;
+}
+
+function decodeResultWire(buffer) {
+    if (buffer.length < HEADER_SIZE || buffer.toString('latin1', 0, 4) !== MAGIC) {
+        throw wireError('Body is not a binary result document');
+    }
+    if (buffer.readUInt16LE(4) !== VERSION) {
+        throw wireError(`Unsupported binary result version ${buffer.readUInt16LE(4)}`);
+    }
+    const count = buffer.readUInt16LE(6);
+    const stringCount = buffer.readUInt16LE(8);
+    const hash = buffer.readBigUInt64LE(16);
+
+    const strings = new Array(stringCount);
+    let offset = HEADER_SIZE;
+    for (let s = 0; s < stringCount; s++) {
+        if (offset + 2 > buffer.length) throw wireError('Truncated string table');
+        const length = buffer.readUInt16LE(offset);
+        offset += 2;
+        if (offset + length > buffer.length) throw wireError('Truncated string table');
+        strings[s] = readString(buffer, offset, offset + length);
+        offset += length;
+    }
+    if (buffer.length - offset !== count * DRIVER_SIZE) throw wireError('Driver records do not match the driver count');
+
+    const string = (index) => {
+        if (index >= stringCount) throw wireError(`String index ${index} out of range`);
+        return strings[index];
+    };
+    // Fixed-width records: plain byte reads for the 16-bit fields, a DataView for the floats
+    const view = new DataView(buffer.buffer, buffer.byteOffset, buffer.length);
+    const drivers = new Array(count);
+    for (let i = 0; i < count; i++, offset += DRIVER_SIZE) {
+        const lapsDown = buffer[offset + 10] | (buffer[offset + 11] << 8);
+        drivers[i] = {
+            Position: buffer[offset] | (buffer[offset + 1] << 8),
+            DriverName: string(buffer[offset + 2] | (buffer[offset + 3] << 8)),
+            CarName: string(buffer[offset + 4] | (buffer[offset + 5] << 8)),
+            CarClass: string(buffer[offset + 6] | (buffer[offset + 7] << 8)),
+            GapToLeader: roundTime(view.getFloat32(offset + 12, true)),
+            Interval: roundTime(view.getFloat32(offset + 16, true)),
+            LapsDown: lapsDown >= 0x8000 ? lapsDown - 0x10000 : lapsDown,
+            LapsCompleted: buffer[offset + 8] | (buffer[offset + 9] << 8),
+            FastestLapTime: roundTime(view.getFloat32(offset + 20, true)),
+            LastLapTime: roundTime(view.getFloat32(offset + 24, true))
+        };
+    }
+
+    return {
+        'Session Name': string(buffer.readUInt16LE(10)),
+        TrackName: string(buffer.readUInt16LE(12)),
+        TrackLayout: string(buffer.readUInt16LE(14)),
+        ResultHash: hash.toString(16).padStart(16, '0'),
+        Drivers: drivers
+    };
+}
+
+function encodeResultWire(result) {
+    const strings = [];
+    const index = new Map();
+    const intern = (value) => {
+        value = value || '';
+        if (!index.has(value)) {
+            index.set(value, strings.length);
+            strings.push(Buffer.from(value, 'utf8'));
+        }
+        return index.get(value);
+    };
+    const session = intern(result['Session Name']);
+    const track = intern(result.TrackName);
+    const layout = intern(result.TrackLayout);
+    const drivers = result.Drivers || [];
+    const names = drivers.map((d) => [intern(d.DriverName), intern(d.CarName), intern(d.CarClass)]);
+
+    const stringBytes = strings.reduce((total, s) => total + 2 + s.length, 0);
+    const buffer = Buffer.alloc(HEADER_SIZE + stringBytes + drivers.length * DRIVER_SIZE);
+    buffer.write(MAGIC, 0, 'latin1');
+    buffer.writeUInt16LE(VERSION, 4);
+    buffer.writeUInt16LE(drivers.length, 6);
+    buffer.writeUInt16LE(strings.length, 8);
+    buffer.writeUInt16LE(session, 10);
+    buffer.writeUInt16LE(track, 12);
+    buffer.writeUInt16LE(layout, 14);
+    buffer.writeBigUInt64LE(BigInt(`0x${result.ResultHash || '0'}`), 16);
+
+    let offset = HEADER_SIZE;
+    for (const s of strings) {
+        buffer.writeUInt16LE(s.length, offset);
+        s.copy(buffer, offset + 2);
+        offset += 2 + s.length;
+    }
+    const time = (value) => (typeof value === 'number' ? value : -1);
+    drivers.forEach((d, i) => {
+        buffer.writeUInt16LE(d.Position || 0, offset);
+        buffer.writeUInt16LE(names[i][0], offset + 2);
+        buffer.writeUInt16LE(names[i][1], offset + 4);
+        buffer.writeUInt16LE(names[i][2], offset + 6);
+        buffer.writeUInt16LE(d.LapsCompleted || 0, offset + 8);
+        buffer.writeInt16LE(d.LapsDown || 0, offset + 10);
+        buffer.writeFloatLE(time(d.GapToLeader), offset + 12);
+        buffer.writeFloatLE(time(d.Interval), offset + 16);
+        buffer.writeFloatLE(time(d.FastestLapTime), offset + 20);
+        buffer.writeFloatLE(time(d.LastLapTime), offset + 24);
+        offset += DRIVER_SIZE;
+    });
+    return buffer;
+}
+
+module.exports = {
+    RESULT_WIRE_CONTENT_TYPE,
+    decodeResultWire,
+    encodeResultWire
+};
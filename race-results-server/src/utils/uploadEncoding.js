@@ -0,0 +1,108 @@
+const fs = require('fs');
+const path = require('path');
+const zlib = require('zlib');
+const { RESULT_WIRE_CONTENT_TYPE, decodeResultWire } = require('./resultWire');
+
+// Content-Encoding used by the logger for bodies deflated against a shared dictionary
+const DICTIONARY_ENCODING = 'deflate-dict';
+const ACCEPT_ENCODING = `${DICTIONARY_ENCODING}, identity`;
+
+// Accept-Post on /upload responses lists the body types the server decodes; the logger only sends
+// binary results to a server that names RESULT_WIRE_CONTENT_TYPE here, since a server without the
+// decoder would store an empty result for them
+const ACCEPT_POST = `application/json, ${RESULT_WIRE_CONTENT_TYPE}`;
+
+// Response header echoing the ResultHash of a decoded binary upload; the logger only counts a
+// binary upload as delivered when it gets its own hash back, since a server without the decoder
+// would answer 200 to a body express.json() skipped
+const RESULT_HASH_HEADER = 'X-Result-Hash';
+
+const dictionaryDir = path.join(__dirname, '../../fs/data/dict');
+
+// Dictionaries keyed by their Adler-32, the id zlib writes into the stream header
+let dictionaryCache = null;
+
+function adler32(buffer) {
+    let a = 1;
+    let b = 0;
+    for (let i = 0; i < buffer.length; i++) {
+        a = (a + buffer[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return ((b << 16) | a) >>> 0;
+}
+
+function loadDictionaries() {
+    if (dictionaryCache) return dictionaryCache;
+    dictionaryCache = new Map();
+    try {
+        for (const file of fs.readdirSync(dictionaryDir)) {
+            if (!file.endsWith('.dict')) continue;
+            const data = fs.readFileSync(path.join(dictionaryDir, file));
+            dictionaryCache.set(adler32(data), data);
+            console.log(`Loaded compression dictionary ${file} (${data.length} bytes)`);
+        }
+    } catch (error) {
+        console.error(`Error reading compression dictionaries: ${error.message}`);
+    }
+    return dictionaryCache;
+}
+
+// Error carrying the HTTP status to answer with
+function encodingError(status, message) {
+    const error = new Error(message);
+    error.status = status;
+    return error;
+}
+
+// Undo the Content-Encoding of an upload body. Throws with status 415 for an encoding or
+// dictionary this server does not have, 400 for a corrupt body.
+function decodeUploadBody(body, contentEncoding) {
+    const encoding = (contentEncoding || 'identity').trim().toLowerCase();
+    if (encoding === 'identity') return body;
+    if (encoding !== DICTIONARY_ENCODING) {
+        throw encodingError(415, `Unsupported Content-Encoding: ${encoding}`);
+    }
+
+    // zlib header: 2 bytes, FDICT flag, then the 4-byte big-endian dictionary id
+    if (body.length < 6 || (body[1] & 0x20) === 0) {
+        throw encodingError(400, 'Body is not a dictionary-compressed zlib stream');
+    }
+    const dictionaryId = body.readUInt32BE(2);
+    const dictionary = loadDictionaries().get(dictionaryId);
+    if (!dictionary) {
+        throw encodingError(415, `Unknown compression dictionary ${dictionaryId.toString(16)}`);
+    }
+    try {
+        return zlib.inflateSync(body, { dictionary });
+    } catch (error) {
+        throw encodingError(400, `Failed to inflate body: ${error.message}`);
+    }
+}
+
+// True for bodies in the logger's binary result format
+function isBinaryResult(contentType) {
+    return (contentType || '').split(';')[0].trim().toLowerCase() === RESULT_WIRE_CONTENT_TYPE;
+}
+
+// Result object from a raw upload body, JSON or binary, with any Content-Encoding undone
+function parseUpload(body, contentType, contentEncoding) {
+    const decoded = decodeUploadBody(body, contentEncoding);
+    if (isBinaryResult(contentType)) return decodeResultWire(decoded);
+    try {
+        return JSON.parse(decoded.toString('utf8'));
+    } catch (error) {
+        throw encodingError(400, `Invalid JSON: ${error.message}`);
+    }
+}
+
+module.exports = {
+    DICTIONARY_ENCODING,
+    ACCEPT_ENCODING,
+    ACCEPT_POST,
+    RESULT_HASH_HEADER,
+    adler32,
+    decodeUploadBody,
+    isBinaryResult,
+    parseUpload
+};
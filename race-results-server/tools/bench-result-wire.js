@@ -0,0 +1,52 @@
+// Decode time of the binary result format against JSON.parse, on the result files in the
+// given folders (each is converted to binary first):
+//   node tools/bench-result-wire.js <folder>...
+const fs = require('fs');
+const path = require('path');
+const { decodeResultWire, encodeResultWire } = require('../src/utils/resultWire');
+
+function collectSamples(folder, samples) {
+    for (const entry of fs.readdirSync(folder, { withFileTypes: true })) {
+        const file = path.join(folder, entry.name);
+        if (entry.isDirectory()) collectSamples(file, samples);
+        else if (entry.name.endsWith('.json')) samples.push(fs.readFileSync(file));
+    }
+}
+
+function bench(name, rounds, inputs, body) {
+    for (let i = 0; i < inputs.length; i++) body(inputs[i]);
+    const start = process.hrtime.bigint();
+    let sink = 0;
+    for (let r = 0; r < rounds; r++) {
+        for (let i = 0; i < inputs.length; i++) sink += body(inputs[i]).Drivers.length;
+    }
+    const ns = Number(process.hrtime.bigint() - start) / (rounds * inputs.length);
+    console.log(`${name.padEnd(32)} ${ns.toFixed(1).padStart(12)} ns/op  (${rounds * inputs.length} iterations, ${sink} drivers)`);
+    return ns;
+}
+
+const samples = [];
+for (const folder of process.argv.slice(2)) collectSamples(folder, samples);
+const results = [];
+for (const sample of samples) {
+    try {
+        const result = JSON.parse(sample.toString('utf8'));
+        if (Array.isArray(result.Drivers)) results.push(result);
+    } catch (error) {
+        // not a result document, skip it
+    }
+}
+if (results.length === 0) {
+    console.log('Usage: node tools/bench-result-wire.js <folder with result .json files>...');
+    process.exit(1);
+}
+
+const json = results.map((r) => Buffer.from(JSON.stringify(r, null, 2)));
+const wire = results.map(encodeResultWire);
+const size = (list) => list.reduce((total, b) => total + b.length, 0);
+console.log(`${results.length} results: ${size(json)} bytes JSON, ${size(wire)} bytes binary\n`);
+
+const rounds = 2000;
+const jsonNs = bench('JSON.parse', rounds, json, (b) => JSON.parse(b.toString('utf8')));
+const wireNs = bench('binary decode', rounds, wire, decodeResultWire);
+console.log(`\nbinary decode is ${(jsonNs / wireNs).toFixed(2)}x JSON.parse`);
@@ -0,0 +1,56 @@
+// Local stand-in for POST /upload with no dependencies beyond Node itself, for testing the
+// logger's uploads and Content-Encoding negotiation without the full server:
+//   node tools/upload-stub.js [port] [--identity-only | --legacy]
+// --identity-only answers 415 to compressed and binary bodies, like a server that only takes JSON.
+// --legacy answers 200 to binary bodies without decoding them and 404 to the GET /upload capability
+// probe, like a server without decodeUpload.
+const http = require('http');
+const fileService = require('../src/services/fileService');
+const { ACCEPT_ENCODING, ACCEPT_POST, RESULT_HASH_HEADER, isBinaryResult, parseUpload } = require('../src/utils/uploadEncoding');
+
+const port = Number(process.argv.find((arg) => /^\d+$/.test(arg)) || 3000);
+const identityOnly = process.argv.includes('--identity-only');
+const legacy = process.argv.includes('--legacy');
+
+function reply(res, status, message, resultHash) {
+    const headers = {
+        'Content-Type': 'application/json',
+        'Accept-Encoding': identityOnly ? 'identity' : ACCEPT_ENCODING
+    };
+    if (!legacy) headers['Accept-Post'] = identityOnly ? 'application/json' : ACCEPT_POST;
+    if (resultHash) headers[RESULT_HASH_HEADER] = resultHash;
+    res.writeHead(status, headers);
+    res.end(JSON.stringify({ message }));
+}
+
+http.createServer((req, res) => {
+    if (req.url !== '/upload') return reply(res, 404, 'Not found');
+    if (req.method === 'GET') return legacy ? reply(res, 404, 'Not found') : reply(res, 200, 'Upload endpoint');
+    if (req.method !== 'POST') return reply(res, 404, 'Not found');
+
+    const chunks = [];
+    req.on('data', (chunk) => chunks.push(chunk));
+    req.on('end', async () => {
+        const body = Buffer.concat(chunks);
+        const encoding = req.headers['content-encoding'] || 'identity';
+        const binary = isBinaryResult(req.headers['content-type']);
+        try {
+            if (identityOnly && (encoding !== 'identity' || binary)) {
+                return reply(res, 415, `Unsupported body: ${req.headers['content-type']}, ${encoding}`);
+            }
+            if (legacy && binary) {
+                console.log(`Stored an empty result for a ${body.length}-byte binary body`);
+                return reply(res, 200, 'Data received and saved successfully');
+            }
+            const data = parseUpload(body, req.headers['content-type'], encoding);
+            const filename = await fileService.saveRaceResult(data);
+            console.log(`Saved ${filename} (${body.length} bytes received, ${binary ? 'binary' : 'json'}, ${encoding})`);
+            reply(res, 200, 'Data received and saved successfully', binary ? data.ResultHash : null);
+        } catch (error) {
+            console.error(`Error handling upload: ${error.message}`);
+            reply(res, error.status || 500, `Error saving data: ${error.message}`);
+        }
+    });
+}).listen(port, () => {
+    console.log(`Upload stub running at http://localhost:${port}/upload${identityOnly ? ' (identity only)' : legacy ? ' (legacy)' : ''}`);
+});